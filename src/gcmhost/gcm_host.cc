@@ -0,0 +1,419 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// gcm_host.cc - Stand-in for libgcm, so that the library can be built and profiled on an ordinary
+// host. RSX local memory, labels, reports and the control register are ordinary memory; a thread
+// plays the part of the RSX's command processor, fetching commands between GET and PUT, following
+// jumps, calls and returns, and executing the handful of methods that the CPU can observe
+// (semaphores, the reference register, and query reports). Everything else is skipped.
+
+#include <rsx/gcm_sys.h>
+
+#include "rsxfifo.h"
+#include "nv40.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The PS3 has 256MB of RSX local memory:
+#define RSXGL_HOST_LOCAL_SIZE (256 * 1024 * 1024)
+
+// Main memory is mapped into the RSX's IO address space in units of 1MB:
+#define RSXGL_HOST_IO_PAGE_SIZE (1024 * 1024)
+
+#define RSXGL_HOST_MAX_LABELS 256
+#define RSXGL_HOST_MAX_REPORTS 2048
+
+// gcmSetFlip emits a write to this (otherwise unused) method, and the flip happens once the
+// command processor executes it:
+#define RSXGL_HOST_FLIP_METHOD 0x1ffc
+
+namespace {
+
+  struct io_mapping_t {
+    const uint8_t * address;
+    uint32_t size, offset;
+  };
+
+  struct gcm_host_t {
+    gcmContextData context;
+    gcmControlRegister control;
+    gcmConfiguration config;
+
+    // Labels are 16 bytes apart, which is also how semaphore offsets address them:
+    uint32_t labels[RSXGL_HOST_MAX_LABELS * 4];
+    gcmReportData reports[RSXGL_HOST_MAX_REPORTS];
+
+    std::mutex io_mutex;
+    std::vector< io_mapping_t > io_mappings;
+    uint32_t io_next_offset;
+
+    std::atomic< bool > running;
+    std::atomic< uint32_t > flip_status;
+
+    // State of the command processor:
+    uint32_t semaphore_offset, backend_semaphore_offset;
+    bool in_call;
+    uint32_t return_offset;
+  };
+
+  gcm_host_t &
+  gcm_host()
+  {
+    static gcm_host_t _host;
+    return _host;
+  }
+
+  inline uint64_t
+  gcm_host_time()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC,&ts);
+    return ((uint64_t)ts.tv_sec * 1000000000ull) + (uint64_t)ts.tv_nsec;
+  }
+
+  // Host address of the word at IO offset "offset", or 0 if nothing's mapped there. Mappings are
+  // never removed, so the last one that was found is remembered:
+  const uint32_t *
+  gcm_host_io_address(const uint32_t offset,io_mapping_t & cached)
+  {
+    if(cached.address == 0 || offset < cached.offset || offset >= (cached.offset + cached.size)) {
+      gcm_host_t & host = gcm_host();
+      std::lock_guard< std::mutex > lock(host.io_mutex);
+
+      cached.address = 0;
+      for(const io_mapping_t & mapping : host.io_mappings) {
+	if(offset >= mapping.offset && offset < (mapping.offset + mapping.size)) {
+	  cached = mapping;
+	  break;
+	}
+      }
+
+      if(cached.address == 0) {
+	return 0;
+      }
+    }
+
+    return (const uint32_t *)(cached.address + (offset - cached.offset));
+  }
+
+  volatile uint32_t *
+  gcm_host_label(const uint32_t semaphore_offset)
+  {
+    return gcm_host().labels + ((semaphore_offset >> 2) % (RSXGL_HOST_MAX_LABELS * 4));
+  }
+
+  void
+  gcm_host_execute(const uint32_t subchannel,const uint32_t method,const uint32_t value)
+  {
+    gcm_host_t & host = gcm_host();
+
+    if(subchannel != 0) return;
+
+    switch(method) {
+    case 0x50:
+      host.control.ref = value;
+      break;
+    case NV406ETCL_SEMAPHORE_OFFSET:
+      host.semaphore_offset = value;
+      break;
+    case NV406ETCL_SEMAPHORE_ACQUIRE:
+      {
+	volatile uint32_t * label = gcm_host_label(host.semaphore_offset);
+	while(*label != value && host.running) {
+	  sched_yield();
+	}
+      }
+      break;
+    case NV406ETCL_SEMAPHORE_RELEASE:
+      *gcm_host_label(host.semaphore_offset) = value;
+      break;
+    case NV40TCL_SEMAPHORE_OFFSET:
+      host.backend_semaphore_offset = value;
+      break;
+    case NV40TCL_SEMAPHORE_BACKENDWRITE_RELEASE:
+      // The library swaps the first and third bytes of the value, as the RSX expects:
+      *gcm_host_label(host.backend_semaphore_offset) = (value & 0xff00ff00) | ((value >> 16) & 0xff) | ((value & 0xff) << 16);
+      break;
+    case RSXGL_HOST_FLIP_METHOD:
+      host.flip_status = 0;
+      break;
+    case NV30_3D_QUERY_GET:
+      {
+	gcmReportData & report = host.reports[((value & 0xffffff) >> 4) % RSXGL_HOST_MAX_REPORTS];
+	report.timer = gcm_host_time();
+	report.value = 0;
+	report.zero = 0;
+      }
+      break;
+    default:
+      break;
+    }
+  }
+
+  void
+  gcm_host_fault(const char * what,const uint32_t offset)
+  {
+    fprintf(stderr,"gcmhost: %s at offset 0x%08x\n",what,offset);
+    abort();
+  }
+
+  // The command processor:
+  void
+  gcm_host_gpu()
+  {
+    gcm_host_t & host = gcm_host();
+    io_mapping_t cached = { 0, 0, 0 };
+
+    while(host.running) {
+      const uint32_t get = host.control.get;
+      const uint32_t put = host.control.put;
+      __sync_synchronize();
+
+      if(get == put) {
+	sched_yield();
+	continue;
+      }
+
+      const uint32_t * words = gcm_host_io_address(get,cached);
+      if(words == 0) {
+	gcm_host_fault("fetch from unmapped memory",get);
+      }
+
+      const rsxfifo_command_t command = rsxfifo_decode(*words,get);
+
+      switch(command.type) {
+      case RSXFIFO_COMMAND_METHOD:
+	for(uint32_t i = 0;i < command.count;++i) {
+	  gcm_host_execute(command.subchannel,command.increment ? (command.method + (i * 4)) : command.method,words[i + 1]);
+	}
+	host.control.get = get + ((command.count + 1) * 4);
+	break;
+      case RSXFIFO_COMMAND_JUMP:
+	host.control.get = command.target;
+	break;
+      case RSXFIFO_COMMAND_CALL:
+	if(host.in_call) {
+	  gcm_host_fault("nested call",get);
+	}
+	host.in_call = true;
+	host.return_offset = get + 4;
+	host.control.get = command.target;
+	break;
+      case RSXFIFO_COMMAND_RETURN:
+	if(!host.in_call) {
+	  gcm_host_fault("return without a call",get);
+	}
+	host.in_call = false;
+	host.control.get = host.return_offset;
+	break;
+      default:
+	gcm_host_fault("invalid command",get);
+	break;
+      }
+    }
+  }
+
+  // libgcm's callback is invoked when the command buffer is full. Wait for the GPU to catch up,
+  // then start again at the beginning:
+  s32
+  gcm_host_callback(gcmContextData * context,u32 count)
+  {
+    gcm_host_t & host = gcm_host();
+
+    u32 begin_offset = 0;
+    gcmAddressToOffset(context -> begin,&begin_offset);
+
+    // The GPU stops once it's followed the jump:
+    *context -> current = 0x20000000 | begin_offset;
+    __sync_synchronize();
+    host.control.put = begin_offset;
+    while(host.control.get != begin_offset) {
+      sched_yield();
+    }
+
+    context -> current = context -> begin;
+    return 0;
+  }
+
+}
+
+s32
+gcmInitBody(gcmContextData * ATTRIBUTE_PRXPTR * context,const u32 cmdSize,const u32 ioSize,const void * ioAddress)
+{
+  gcm_host_t & host = gcm_host();
+
+  if(host.running || cmdSize > ioSize) {
+    return -1;
+  }
+
+  void * local = mmap(0,RSXGL_HOST_LOCAL_SIZE,PROT_READ | PROT_WRITE,MAP_PRIVATE | MAP_ANONYMOUS,-1,0);
+  if(local == MAP_FAILED) {
+    return -1;
+  }
+
+  host.config.localAddress = local;
+  host.config.localSize = RSXGL_HOST_LOCAL_SIZE;
+  host.config.ioAddress = (void *)ioAddress;
+  host.config.ioSize = ioSize;
+  host.config.memoryFrequency = 650000000;
+  host.config.coreFrequency = 500000000;
+
+  host.io_next_offset = 0;
+  u32 offset = 0;
+  gcmMapMainMemory(ioAddress,ioSize,&offset);
+
+  host.context.begin = (u32 *)ioAddress;
+  host.context.end = host.context.begin + (cmdSize / sizeof(u32)) - 1;
+  host.context.current = host.context.begin;
+  host.context.callback = gcm_host_callback;
+
+  host.control.put = offset;
+  host.control.get = offset;
+  host.control.ref = 0xffffffff;
+
+  memset(host.labels,0,sizeof(host.labels));
+  memset(host.reports,0,sizeof(host.reports));
+
+  host.flip_status = 0;
+  host.semaphore_offset = 0;
+  host.backend_semaphore_offset = 0;
+  host.in_call = false;
+  host.return_offset = 0;
+
+  host.running = true;
+  std::thread(gcm_host_gpu).detach();
+
+  *context = &host.context;
+  return 0;
+}
+
+s32
+gcmTerminate(void)
+{
+  gcm_host().running = false;
+  return 0;
+}
+
+s32
+gcmGetConfiguration(gcmConfiguration * config)
+{
+  *config = gcm_host().config;
+  return 0;
+}
+
+s32
+gcmAddressToOffset(void * address,u32 * offset)
+{
+  gcm_host_t & host = gcm_host();
+  const uint8_t * p = (const uint8_t *)address;
+  const uint8_t * local = (const uint8_t *)host.config.localAddress;
+
+  if(local != 0 && p >= local && p < (local + host.config.localSize)) {
+    *offset = p - local;
+    return 0;
+  }
+
+  std::lock_guard< std::mutex > lock(host.io_mutex);
+
+  for(const io_mapping_t & mapping : host.io_mappings) {
+    if(p >= mapping.address && p < (mapping.address + mapping.size)) {
+      *offset = mapping.offset + (p - mapping.address);
+      return 0;
+    }
+  }
+
+  return -1;
+}
+
+s32
+gcmMapMainMemory(const void * address,const u32 size,u32 * offset)
+{
+  gcm_host_t & host = gcm_host();
+  std::lock_guard< std::mutex > lock(host.io_mutex);
+
+  io_mapping_t mapping;
+  mapping.address = (const uint8_t *)address;
+  mapping.size = size;
+  mapping.offset = host.io_next_offset;
+
+  host.io_mappings.push_back(mapping);
+  host.io_next_offset += (size + RSXGL_HOST_IO_PAGE_SIZE - 1) & ~(RSXGL_HOST_IO_PAGE_SIZE - 1);
+
+  *offset = mapping.offset;
+  return 0;
+}
+
+gcmControlRegister *
+gcmGetControlRegister(void)
+{
+  return &gcm_host().control;
+}
+
+u32 *
+gcmGetLabelAddress(const u8 index)
+{
+  return gcm_host().labels + (index * 4);
+}
+
+gcmReportData *
+gcmGetReportDataAddress(const u32 index)
+{
+  return (index < RSXGL_HOST_MAX_REPORTS) ? (gcm_host().reports + index) : 0;
+}
+
+s32
+gcmSetDisplayBuffer(const u8 bufferId,const u32 offset,const u32 pitch,const u32 width,const u32 height)
+{
+  return 0;
+}
+
+void
+gcmSetFlipMode(const u32 mode)
+{
+}
+
+// There's no display to flip. The flip is considered to have happened once the GPU has executed
+// the command emitted here, which it can only do after the command buffer has been flushed:
+s32
+gcmSetFlip(gcmContextData * context,const u8 bufferId)
+{
+  if((context -> current + 2) > context -> end && (*context -> callback)(context,2) != 0) {
+    return -1;
+  }
+
+  gcm_host().flip_status = 1;
+
+  context -> current[0] = RSXGL_HOST_FLIP_METHOD | (1 << 18);
+  context -> current[1] = bufferId;
+  context -> current += 2;
+
+  return 0;
+}
+
+void
+gcmSetWaitFlip(gcmContextData * context)
+{
+}
+
+void
+gcmResetFlipStatus(void)
+{
+  gcm_host().flip_status = 1;
+}
+
+u32
+gcmGetFlipStatus(void)
+{
+  return gcm_host().flip_status;
+}
@@ -0,0 +1,34 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// ppu-types.h - Host stand-in for PSL1GHT's basic types.
+
+#ifndef rsxgl_host_ppu_types_H
+#define rsxgl_host_ppu_types_H
+
+#include <stdint.h>
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef uint64_t u64;
+
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef int64_t s64;
+
+typedef volatile u8 vu8;
+typedef volatile u16 vu16;
+typedef volatile u32 vu32;
+typedef volatile u64 vu64;
+
+// Pointers to structures shared with the LV2 kernel are 32 bits wide on the PS3; on the host
+// they're just pointers:
+#define ATTRIBUTE_PRXPTR
+
+#endif
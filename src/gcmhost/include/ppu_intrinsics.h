@@ -0,0 +1,14 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// ppu_intrinsics.h - Host stand-in for the PPU's memory barrier intrinsics.
+
+#ifndef rsxgl_host_ppu_intrinsics_H
+#define rsxgl_host_ppu_intrinsics_H
+
+#define __sync() __sync_synchronize()
+#define __lwsync() __sync_synchronize()
+#define __eieio() __sync_synchronize()
+
+#endif
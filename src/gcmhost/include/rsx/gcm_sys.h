@@ -0,0 +1,74 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// gcm_sys.h - Host stand-in for the parts of PSL1GHT's libgcm that RSXGL uses. The RSX is
+// replaced by a thread that executes the command buffer (see src/gcmhost/gcm_host.cc).
+
+#ifndef rsxgl_host_gcm_sys_H
+#define rsxgl_host_gcm_sys_H
+
+#include <ppu-types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GCM_FLIP_HSYNC 1
+#define GCM_FLIP_VSYNC 2
+#define GCM_FLIP_HSYNC_AND_BREAK_EVERYTHING 3
+
+struct _gcmCtxData;
+typedef s32 (*gcmContextCallback)(struct _gcmCtxData *,u32);
+
+typedef struct _gcmCtxData {
+  u32 * begin ATTRIBUTE_PRXPTR;
+  u32 * end ATTRIBUTE_PRXPTR;
+  u32 * current ATTRIBUTE_PRXPTR;
+  gcmContextCallback callback ATTRIBUTE_PRXPTR;
+} gcmContextData;
+
+typedef struct _gcmCtrlRegister {
+  vu32 put;
+  vu32 get;
+  vu32 ref;
+} gcmControlRegister;
+
+typedef struct _gcmCfg {
+  void * localAddress ATTRIBUTE_PRXPTR;
+  void * ioAddress ATTRIBUTE_PRXPTR;
+  u32 localSize;
+  u32 ioSize;
+  u32 memoryFrequency;
+  u32 coreFrequency;
+} gcmConfiguration;
+
+typedef struct _gcmReportData {
+  u64 timer;
+  u32 value;
+  u32 zero;
+} gcmReportData;
+
+s32 gcmInitBody(gcmContextData * ATTRIBUTE_PRXPTR * context,const u32 cmdSize,const u32 ioSize,const void * ioAddress);
+s32 gcmTerminate(void);
+
+s32 gcmGetConfiguration(gcmConfiguration * config);
+s32 gcmAddressToOffset(void * address,u32 * offset);
+s32 gcmMapMainMemory(const void * address,const u32 size,u32 * offset);
+
+gcmControlRegister * gcmGetControlRegister(void);
+u32 * gcmGetLabelAddress(const u8 index);
+gcmReportData * gcmGetReportDataAddress(const u32 index);
+
+s32 gcmSetDisplayBuffer(const u8 bufferId,const u32 offset,const u32 pitch,const u32 width,const u32 height);
+void gcmSetFlipMode(const u32 mode);
+s32 gcmSetFlip(gcmContextData * context,const u8 bufferId);
+void gcmSetWaitFlip(gcmContextData * context);
+void gcmResetFlipStatus(void);
+u32 gcmGetFlipStatus(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
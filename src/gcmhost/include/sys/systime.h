@@ -0,0 +1,22 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// sys/systime.h - Host stand-in for PSL1GHT's lv2 system time calls.
+
+#ifndef rsxgl_host_sys_systime_H
+#define rsxgl_host_sys_systime_H
+
+#include <ppu-types.h>
+#include <time.h>
+
+// Microseconds since some arbitrary point:
+static inline u64
+sysGetSystemTime(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ((u64)ts.tv_sec * 1000000ull) + ((u64)ts.tv_nsec / 1000ull);
+}
+
+#endif
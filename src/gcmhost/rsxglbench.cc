@@ -0,0 +1,272 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// rsxglbench.cc - Microbenchmarks of some of the library's CPU-side paths, run against the
+// simulated RSX in gcm_host.cc: filling the command buffer ring (gl_fifo.c) and waiting for the
+// GPU to catch up (wait.c), and making small allocations from RSX memory with the slab allocator
+// (slab.cc) and with an mspace alone. It exits with a non-zero status if the simulated GPU stops
+// making progress, flips before it's been flushed, or if an allocation fails, so it also serves as
+// a smoke test.
+//
+// Usage: rsxglbench [commands [allocations]]
+
+#include <EGL/egl.h>
+#include "GL3/rsxgl.h"
+
+#include <rsx/gcm_sys.h>
+
+#include "gl_fifo.h"
+#include "mem.h"
+#include "slab.h"
+#include "wait.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include <algorithm>
+#include <vector>
+
+// egl.c, which usually defines this, needs gallium; the benchmarks don't:
+extern "C" struct rsxgl_init_parameters_t rsxgl_init_parameters;
+struct rsxgl_init_parameters_t rsxgl_init_parameters;
+
+// Command lists aren't recorded here:
+extern "C" int32_t
+rsxgl_command_list_reserve(gcmContextData *,uint32_t)
+{
+  return -1;
+}
+
+// Sizes of the command buffer, and of the memory that the allocators are given:
+static const uint32_t rsxglbench_command_buffer_size = 1024 * 1024;
+static const rsx_size_t rsxglbench_arena_size = 16 * 1024 * 1024;
+
+// Give up on the GPU after this many microseconds:
+static const uint64_t rsxglbench_timeout = 10 * 1000000;
+
+static void
+rsxglbench_report(const char * name,const uint64_t n,const uint64_t elapsed)
+{
+  printf("%-24s %10lu in %8lu us, %8.1f ns each\n",name,(unsigned long)n,(unsigned long)elapsed,n ? ((double)elapsed * 1000.0 / (double)n) : 0.0);
+}
+
+// Wait for the GPU to set the reference register to value:
+static bool
+rsxglbench_wait_ref(const uint32_t value)
+{
+  gcmControlRegister volatile * control = gcmGetControlRegister();
+  if(control -> ref == value) return true;
+
+  struct rsxgl_wait_t wait;
+  rsxgl_wait_begin(&wait,rsxglbench_timeout);
+  while(control -> ref != value) {
+    if(!rsxgl_wait_step(&wait)) {
+      rsxgl_wait_end(&wait,0);
+      return false;
+    }
+  }
+  rsxgl_wait_end(&wait,1);
+  return true;
+}
+
+static inline void
+rsxglbench_flush(gcmContextData * context)
+{
+  gcmControlRegister volatile * control = gcmGetControlRegister();
+  uint32_t offset = 0;
+
+  __sync_synchronize();
+  gcmAddressToOffset(context -> current,&offset);
+  control -> put = offset;
+}
+
+static inline void
+rsxglbench_emit_set_ref(gcmContextData * context,const uint32_t value)
+{
+  uint32_t * buffer = gcm_reserve(context,2);
+
+  gcm_emit_method_at(buffer,0,0x50,1);
+  gcm_emit_at(buffer,1,value);
+
+  gcm_finish_n_commands(context,2);
+}
+
+// Emit commands, flushing every so often as the library does, so that the ring wraps around many
+// times. Then time round trips - a flush followed by a wait for the GPU - one at a time:
+static bool
+rsxglbench_commands(gcmContextData * context,const uint32_t n)
+{
+  uint64_t start = rsxgl_wait_time();
+  for(uint32_t i = 0;i < n;++i) {
+    rsxglbench_emit_set_ref(context,i);
+    if((i % 64) == 63) rsxglbench_flush(context);
+  }
+  rsxglbench_flush(context);
+  if(!rsxglbench_wait_ref(n - 1)) {
+    fprintf(stderr,"rsxglbench: GPU stopped at reference %u, expected %u\n",gcmGetControlRegister() -> ref,n - 1);
+    return false;
+  }
+  rsxglbench_report("commands",n,rsxgl_wait_time() - start);
+
+  const uint32_t nround_trips = std::max(n / 1000,(uint32_t)1);
+  start = rsxgl_wait_time();
+  for(uint32_t i = 0;i < nround_trips;++i) {
+    rsxglbench_emit_set_ref(context,n + i);
+    rsxglbench_flush(context);
+    if(!rsxglbench_wait_ref(n + i)) {
+      fprintf(stderr,"rsxglbench: GPU stopped at reference %u, expected %u\n",gcmGetControlRegister() -> ref,n + i);
+      return false;
+    }
+  }
+  rsxglbench_report("round trips",nround_trips,rsxgl_wait_time() - start);
+
+  return true;
+}
+
+// A flip mustn't happen before the GPU has been given the command for it:
+static bool
+rsxglbench_flip(gcmContextData * context)
+{
+  gcmResetFlipStatus();
+
+  // As eglSwapBuffers does, make room so that libgcm doesn't have to:
+  gcm_reserve(context,2);
+  if(gcmSetFlip(context,0) != 0) {
+    fprintf(stderr,"rsxglbench: gcmSetFlip failed\n");
+    return false;
+  }
+
+  // Give the GPU a chance to get it wrong:
+  usleep(1000);
+
+  if(gcmGetFlipStatus() == 0) {
+    fprintf(stderr,"rsxglbench: flip happened before it was flushed\n");
+    return false;
+  }
+
+  rsxglbench_flush(context);
+
+  bool flipped = false;
+  struct rsxgl_wait_t wait;
+  rsxgl_wait_begin(&wait,rsxglbench_timeout);
+  while(!(flipped = (gcmGetFlipStatus() == 0)) && rsxgl_wait_step(&wait));
+  rsxgl_wait_end(&wait,flipped);
+
+  if(!flipped) {
+    fprintf(stderr,"rsxglbench: flip didn't happen after it was flushed\n");
+  }
+  return flipped;
+}
+
+// Allocate blocks of the small sizes that uniform and index buffers tend to have. A thousand or so
+// are kept at once, and they're replaced out of order, so that the allocator has to deal with
+// fragmentation:
+template< typename Allocator >
+static bool
+rsxglbench_allocations(const char * name,Allocator & allocator,const uint32_t n)
+{
+  static const rsx_size_t sizes[] = { 128, 256, 200, 1024, 64, 4096, 512, 16384 };
+  static const uint32_t nsizes = sizeof(sizes) / sizeof(rsx_size_t);
+  static const uint32_t nlive = 1024;
+
+  std::vector< void * > blocks(nlive,(void *)0);
+
+  const uint64_t start = rsxgl_wait_time();
+  for(uint32_t i = 0;i < n;++i) {
+    const uint32_t j = (i * 7) % nlive;
+    if(blocks[j] != 0) allocator.free(blocks[j]);
+
+    blocks[j] = allocator.allocate(128,sizes[i % nsizes]);
+    if(blocks[j] == 0) {
+      fprintf(stderr,"rsxglbench: %s: allocation %u of %u bytes failed\n",name,i,sizes[i % nsizes]);
+      return false;
+    }
+  }
+  for(uint32_t j = 0;j < nlive;++j) {
+    if(blocks[j] != 0) allocator.free(blocks[j]);
+  }
+  rsxglbench_report(name,n,rsxgl_wait_time() - start);
+
+  return true;
+}
+
+namespace {
+
+  struct mspace_allocator_t {
+    mspace space;
+
+    void * allocate(const rsx_size_t align,const rsx_size_t size) {
+      return rsxgl_mspace_memalign(space,align,size);
+    }
+
+    void free(void * ptr) {
+      rsxgl_mspace_free(space,ptr);
+    }
+  };
+
+  // As rsxgl_arena_allocate does it - the slabs first, then the mspace:
+  struct slab_mspace_allocator_t {
+    mspace space;
+    slab_allocator_t * slabs;
+
+    void * allocate(const rsx_size_t align,const rsx_size_t size) {
+      rsx_size_t block_size = 0;
+      void * ptr = rsxgl_slab_allocate(slabs,align,size,block_size);
+      return (ptr != 0) ? ptr : rsxgl_mspace_memalign(space,align,size);
+    }
+
+    void free(void * ptr) {
+      if(rsxgl_slab_free(slabs,ptr) == 0) rsxgl_mspace_free(space,ptr);
+    }
+  };
+
+}
+
+int
+main(int argc,char ** argv)
+{
+  const uint32_t ncommands = (argc > 1) ? strtoul(argv[1],0,10) : 1000000;
+  const uint32_t nallocations = (argc > 2) ? strtoul(argv[2],0,10) : 1000000;
+
+  rsxgl_init_parameters.wait_spin_time = 100;
+  rsxgl_init_parameters.wait_max_sleep = 1000;
+
+  // The command buffer lives in main memory, mapped for the RSX in units of 1MB:
+  void * io = memalign(1024 * 1024,rsxglbench_command_buffer_size);
+  gcmContextData * context = 0;
+  if(io == 0 || gcmInitBody(&context,rsxglbench_command_buffer_size,rsxglbench_command_buffer_size,io) != 0) {
+    fprintf(stderr,"rsxglbench: couldn't initialize the simulated RSX\n");
+    return 1;
+  }
+  gcm_ring_init(context);
+
+  bool passed = ncommands == 0 || rsxglbench_commands(context,ncommands);
+  passed = rsxglbench_flip(context) && passed;
+
+  // Memory for the allocators, as a memory arena would have it:
+  void * address = rsxgl_rsx_memalign(128,rsxglbench_arena_size);
+  if(address == 0) {
+    fprintf(stderr,"rsxglbench: couldn't allocate %u bytes of RSX memory\n",rsxglbench_arena_size);
+    passed = false;
+  }
+  else if(nallocations > 0) {
+    mspace_allocator_t mspace_allocator;
+    mspace_allocator.space = create_mspace_with_base(address,rsxglbench_arena_size,0);
+    passed = rsxglbench_allocations("mspace allocations",mspace_allocator,nallocations) && passed;
+    destroy_mspace(mspace_allocator.space);
+
+    slab_mspace_allocator_t slab_allocator;
+    slab_allocator.space = create_mspace_with_base(address,rsxglbench_arena_size,0);
+    slab_allocator.slabs = rsxgl_slab_allocator_create(slab_allocator.space,address,rsxglbench_arena_size);
+    passed = rsxglbench_allocations("slab allocations",slab_allocator,nallocations) && passed;
+    rsxgl_slab_allocator_destroy(slab_allocator.slabs);
+    destroy_mspace(slab_allocator.space);
+  }
+  rsxgl_rsx_free(address);
+
+  gcmTerminate();
+
+  return passed ? 0 : 1;
+}
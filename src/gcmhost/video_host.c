@@ -0,0 +1,50 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// video_host.c - Stand-in for PSL1GHT's video output configuration. Pretends that a 720p display
+// is attached.
+
+#include <sysutil/video.h>
+
+#include <string.h>
+
+s32
+videoGetState(s32 videoOut,s32 deviceIndex,videoState * state)
+{
+  memset(state,0,sizeof(videoState));
+  state -> displayMode.resolution = VIDEO_RESOLUTION_720;
+  state -> displayMode.aspect = VIDEO_ASPECT_16_9;
+  return 0;
+}
+
+s32
+videoGetResolution(s32 resolutionId,videoResolution * resolution)
+{
+  switch(resolutionId) {
+  case VIDEO_RESOLUTION_1080:
+    resolution -> width = 1920;
+    resolution -> height = 1080;
+    return 0;
+  case VIDEO_RESOLUTION_720:
+    resolution -> width = 1280;
+    resolution -> height = 720;
+    return 0;
+  case VIDEO_RESOLUTION_480:
+    resolution -> width = 720;
+    resolution -> height = 480;
+    return 0;
+  case VIDEO_RESOLUTION_576:
+    resolution -> width = 720;
+    resolution -> height = 576;
+    return 0;
+  default:
+    return -1;
+  }
+}
+
+s32
+videoConfigure(s32 videoOut,videoConfiguration * config,void * option,s32 blocking)
+{
+  return 0;
+}
@@ -24,6 +24,25 @@ struct rsxgl_init_parameters_t {
   uint32_t max_swap_wait_iterations;
   useconds_t swap_wait_interval;
   uint32_t rsx_mspace_offset, rsx_mspace_size;
+
+  /* Automatically flush the command buffer once this many draw calls, command words, or
+     vertices have been submitted since the last flush. 0 disables the corresponding test: */
+  uint32_t flush_draw_threshold, flush_word_threshold, flush_vertex_threshold;
+
+  /* When the CPU has to wait for the GPU, it polls without sleeping for wait_spin_time
+     microseconds, then sleeps for exponentially longer intervals of up to wait_max_sleep
+     microseconds. A wait_max_sleep of 0 polls without ever sleeping. eglSwapBuffers gives up on
+     the flip after max_swap_wait_iterations * swap_wait_interval microseconds (never, if either is 0): */
+  useconds_t wait_spin_time, wait_max_sleep;
+
+  /* Buffers that aren't given an arena with glUseMemoryArenaRSX are placed according to their usage
+     hint: STATIC_DRAW and *_COPY buffers go to RSX local memory, while STREAM_DRAW, DYNAMIC_DRAW and
+     *_READ buffers go to main memory, taken from an arena of main_buffer_arena_size bytes (rounded up
+     to 1MB) that's created when it's first needed. A main_buffer_arena_size of 0 keeps all buffers in
+     local memory. If buffer_migration is nonzero, buffers that the CPU reads from or writes to more
+     often than their hint suggests are moved to main memory: */
+  khronos_usize_t main_buffer_arena_size;
+  uint32_t buffer_migration;
 };
 
 /*! \brief Customize the resources that RSXGL allocates upon initialization. Call this, optionally, before
@@ -33,6 +52,22 @@ struct rsxgl_init_parameters_t {
 */
 void rsxglConfigure(struct rsxgl_init_parameters_t const * parameters);
 
+/* Time spent by the CPU waiting for the GPU (glFinish, glClientWaitSync, eglSwapBuffers, and
+   waits for objects that the GPU is still using), since initialization or the last call to
+   rsxglResetWaitStatistics. Times are in microseconds: */
+struct rsxgl_wait_statistics_t {
+  uint64_t waits, sleeps, timeouts;
+  uint64_t total_time, max_time;
+};
+
+/*! \brief Retrieve the wait statistics.
+  \param statistics Pointer to a structure that the statistics are copied into.
+*/
+void rsxglGetWaitStatistics(struct rsxgl_wait_statistics_t * statistics);
+
+/*! \brief Reset the wait statistics to zero. */
+void rsxglResetWaitStatistics(void);
+
 #if 0
 /* The following functions are for compatibility with librsx - where librsx is
    used to do the setup that EGL usually performs.
@@ -5,6 +5,7 @@
 // arena.cc - Create arenas from which memory may be allocated.
 
 #include "arena.h"
+#include "slab.h"
 #include "rsxgl_context.h"
 #include "gl_object_storage.h"
 
@@ -30,12 +31,22 @@ memory_arena_t::storage_type & memory_arena_t::storage()
 memory_t
 rsxgl_arena_allocate(memory_arena_t & arena,rsx_size_t align,rsx_size_t size,void * * address)
 {
-  void * addr = mspace_memalign(arena.space,align,size);
+  if(arena.slabs == 0) arena.slabs = rsxgl_slab_allocator_create(arena.space,arena.address,arena.size);
+
+  rsx_size_t allocated_size = 0;
+  void * addr = rsxgl_slab_allocate(arena.slabs,align,size,allocated_size);
+
+  if(addr == 0) {
+    addr = rsxgl_mspace_memalign(arena.space,align,size);
+    if(addr != 0) allocated_size = mspace_usable_size(addr);
+  }
 
   if(addr == 0) {
     return memory_t();
   }
   else {
+    rsxgl_memory_usage_allocate(&arena.usage,allocated_size);
+
     if(address != 0) *address = addr;
     return memory_t(arena.memory.location,arena.memory.offset + ((uint8_t *)addr - (uint8_t *)(arena.address)),1);
   }
@@ -44,7 +55,23 @@ rsxgl_arena_allocate(memory_arena_t & arena,rsx_size_t align,rsx_size_t size,voi
 void
 rsxgl_arena_free(struct memory_arena_t & arena,const struct memory_t & memory)
 {
-  mspace_free(arena.space,rsxgl_arena_address(arena,memory));
+  void * addr = rsxgl_arena_address(arena,memory);
+
+  const rsx_size_t block_size = (arena.slabs != 0) ? rsxgl_slab_free(arena.slabs,addr) : 0;
+
+  if(block_size != 0) {
+    rsxgl_memory_usage_free(&arena.usage,block_size);
+  }
+  else {
+    rsxgl_memory_usage_free(&arena.usage,mspace_usable_size(addr));
+    rsxgl_mspace_free(arena.space,addr);
+  }
+}
+
+void
+rsxgl_arena_info(memory_arena_t & arena,rsxgl_memory_info_t * info)
+{
+  rsxgl_mspace_info(arena.space,arena.size,&arena.usage,info);
 }
 
 static inline size_t
@@ -61,45 +88,64 @@ rsxgl_memory_location(GLenum location)
   }
 }
 
-GLAPI GLuint APIENTRY
-glCreateMemoryArenaRSX(GLenum location,GLsizei align,GLsizei size)
+memory_arena_t::name_type
+rsxgl_arena_create(const uint32_t location,const rsx_size_t align,const rsx_size_t size)
 {
-  const size_t rsx_location = rsxgl_memory_location(location);
-  if(rsx_location == ~0U) RSXGL_ERROR(GL_INVALID_ENUM,0);
-
-  if(location == GL_MAIN_MEMORY_ARENA_RSX && ((align % (1024 * 1024) != 0) || (size % (1024 * 1024) != 0))) {
-    RSXGL_ERROR(GL_INVALID_VALUE,0);
-  }
-
-  uint32_t name = memory_arena_t::storage().create_name_and_object();
-  memory_arena_t & arena = memory_arena_t::storage().at(name);
+  void * address = 0;
   uint32_t offset = 0;
 
-  if(rsx_location == RSXGL_MEMORY_LOCATION_LOCAL) {
-    arena.address = rsxgl_rsx_memalign(align,size);
-    if(arena.address == 0) RSXGL_ERROR(GL_OUT_OF_MEMORY,0);
+  if(location == RSXGL_MEMORY_LOCATION_LOCAL) {
+    address = rsxgl_rsx_memalign(align,size);
+    if(address == 0) return 0;
 
-    gcmAddressToOffset(arena.address,&offset);
+    gcmAddressToOffset(address,&offset);
   }
-  else if(rsx_location == RSXGL_MEMORY_LOCATION_MAIN) {
-    arena.address = memalign(align,size);
-    if(arena.address == 0) RSXGL_ERROR(GL_OUT_OF_MEMORY,0);
+  else if(location == RSXGL_MEMORY_LOCATION_MAIN) {
+    address = memalign(align,size);
+    if(address == 0) return 0;
 
-    gcmMapMainMemory(arena.address,size,&offset);
+    if(gcmMapMainMemory(address,size,&offset) != 0) {
+      free(address);
+      return 0;
+    }
+  }
+  else {
+    return 0;
   }
 
-  arena.memory.location = rsx_location;
+  const memory_arena_t::name_type name = memory_arena_t::storage().create_name_and_object();
+  memory_arena_t & arena = memory_arena_t::storage().at(name);
+
+  arena.address = address;
+  arena.memory.location = location;
   arena.memory.offset = offset;
   arena.size = size;
   arena.space = create_mspace_with_base(arena.address,arena.size,0);
 
+  return name;
+}
+
+GLAPI GLuint APIENTRY
+glCreateMemoryArenaRSX(GLenum location,GLsizei align,GLsizei size)
+{
+  const size_t rsx_location = rsxgl_memory_location(location);
+  if(rsx_location == ~0U) RSXGL_ERROR(GL_INVALID_ENUM,0);
+
+  if(location == GL_MAIN_MEMORY_ARENA_RSX && ((align % (1024 * 1024) != 0) || (size % (1024 * 1024) != 0))) {
+    RSXGL_ERROR(GL_INVALID_VALUE,0);
+  }
+
+  const memory_arena_t::name_type name = rsxgl_arena_create(rsx_location,align,size);
+  if(name == 0) RSXGL_ERROR(GL_OUT_OF_MEMORY,0);
+
   RSXGL_NOERROR(name);
 }
 
 void
 memory_arena_t::destroy()
 {
-  destroy_mspace(space);
+  if(slabs != 0) rsxgl_slab_allocator_destroy(slabs);
+  if(space != 0) destroy_mspace(space);
 
   if(memory.location == RSXGL_MEMORY_LOCATION_LOCAL) {
     rsxgl_rsx_free(address);
@@ -112,7 +158,7 @@ memory_arena_t::destroy()
 GLAPI void APIENTRY
 glDeleteMemoryArenaRSX(GLuint name)
 {
-  if(!memory_arena_t::storage().is_object(name)) {
+  if(!rsxgl_arena_is_object(name)) {
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
 
@@ -146,7 +192,7 @@ glUseMemoryArenaRSX(GLenum target,GLuint name)
     RSXGL_ERROR_(GL_INVALID_ENUM);
   }
 
-  if(!(name == 0 || memory_arena_t::storage().is_object(name))) {
+  if(!(name == 0 || rsxgl_arena_is_object(name))) {
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
 
@@ -180,6 +226,23 @@ glGetMemoryArenaParameterivRSX(GLenum target,GLenum pname,GLint * params)
       RSXGL_ERROR_(GL_INVALID_ENUM);
     }
   }
+  else if(pname == GL_ARENA_USED_RSX || pname == GL_ARENA_FREE_RSX || pname == GL_ARENA_LARGEST_FREE_RSX || pname == GL_ARENA_PEAK_USED_RSX) {
+    rsxgl_memory_info_t info;
+    rsxgl_arena_info(arena,&info);
+
+    if(pname == GL_ARENA_USED_RSX) {
+      *params = info.used;
+    }
+    else if(pname == GL_ARENA_FREE_RSX) {
+      *params = info.free;
+    }
+    else if(pname == GL_ARENA_LARGEST_FREE_RSX) {
+      *params = info.largest_free;
+    }
+    else if(pname == GL_ARENA_PEAK_USED_RSX) {
+      *params = info.peak;
+    }
+  }
   else {
     RSXGL_ERROR_(GL_INVALID_ENUM);
   }
@@ -65,6 +65,8 @@ struct memory_t {
 };
 
 struct memory_arena_t;
+struct slab_allocator_t;
+struct stream_ring_t;
 
 struct memory_arena_t {
   typedef bindable_gl_object< memory_arena_t, RSXGL_MAX_ARENAS, RSXGL_MAX_ARENA_TARGETS, 1 > gl_object_type;
@@ -82,8 +84,19 @@ struct memory_arena_t {
   memory_t memory;
   rsx_size_t size;
 
+  // Small allocations come from here; created when the arena is first allocated from:
+  slab_allocator_t * slabs;
+
+  // Memory handed out by rsxgl_arena_allocate:
+  rsxgl_memory_usage_t usage;
+
+  // Set if the arena describes a streaming ring's memory:
+  stream_ring_t * ring;
+
   memory_arena_t()
-    : address(0), space(0), size(0) {
+    : address(0), space(0), size(0), slabs(0), ring(0) {
+    usage.used = 0;
+    usage.peak = 0;
   }
 
   void destroy();
@@ -111,8 +124,21 @@ struct memory_arena_t {
 #endif
 };
 
+// Create an arena of size bytes in the given memory location. Returns 0 if the memory couldn't be
+// had. Main memory arenas must be aligned to, and be a multiple of, 1MB:
+memory_arena_t::name_type rsxgl_arena_create(const uint32_t location,const rsx_size_t align,const rsx_size_t size);
+
 memory_t rsxgl_arena_allocate(memory_arena_t &,rsx_size_t,rsx_size_t,void * * = 0);
 void rsxgl_arena_free(memory_arena_t &,const memory_t &);
+void rsxgl_arena_info(memory_arena_t &,rsxgl_memory_info_t *);
+
+// True if name is an arena that the application may use. The arenas that describe the streaming
+// rings share the namespace, but belong to the library:
+static inline bool
+rsxgl_arena_is_object(const memory_arena_t::name_type name)
+{
+  return memory_arena_t::storage().is_object(name) && memory_arena_t::storage().at(name).ring == 0;
+}
 
 static inline void *
 rsxgl_arena_address(memory_arena_t & arena,const memory_t & memory)
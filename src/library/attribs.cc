@@ -10,6 +10,7 @@
 #include "arena.h"
 #include "buffer.h"
 #include "attribs.h"
+#include "client_arrays.h"
 
 #include <GL3/gl3.h>
 #include "error.h"
@@ -321,7 +322,7 @@ glGetVertexAttribPointerv (GLuint index, GLenum pname, GLvoid** pointer)
   attribs_t & attribs = ctx -> attribs_binding[0];
 
   if(pname == GL_VERTEX_ATTRIB_ARRAY_POINTER) {
-    *pointer = (GLvoid *)((uint64_t)attribs.offset[index]);
+    *pointer = attribs.client.test(index) ? (GLvoid *)attribs.pointer[index] : (GLvoid *)((uint64_t)attribs.offset[index]);
   }
 
   RSXGL_NOERROR_();
@@ -762,22 +763,24 @@ rsxgl_vertex_attrib_pointer(rsxgl_context_t * ctx,uint32_t rsx_type,GLuint index
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  if(ctx -> buffer_binding.names[RSXGL_ARRAY_BUFFER] == 0 && pointer != 0) {
-    RSXGL_ERROR_(GL_INVALID_OPERATION);
-  }
-
   attribs_t & attribs = ctx -> attribs_binding[0];
 
   attribs.buffers.bind(index,ctx -> buffer_binding.names[RSXGL_ARRAY_BUFFER]);
 
+  attribs.type.set(index,rsx_type);
+  attribs.size.set(index,size - 1);
+  attribs.stride[index] = stride;
+
   if(ctx -> buffer_binding.names[RSXGL_ARRAY_BUFFER] != 0) {
     attribs.offset[index] = rsxgl_pointer_to_offset(pointer);
-    attribs.type.set(index,rsx_type);
-    attribs.size.set(index,size - 1);
-    attribs.stride[index] = stride;
+    attribs.client.reset(index);
+    attribs.pointer[index] = 0;
   }
+  // Client-side array (GLES2, and the compatibility profile):
   else {
     attribs.offset[index] = 0;
+    attribs.client.set(index,pointer != 0);
+    attribs.pointer[index] = pointer;
   }
 
   ctx -> invalid_attribs.set(index);
@@ -820,15 +823,43 @@ glVertexAttribDivisor (GLuint index, GLuint divisor)
   // TODO: Implement this
 }
 
-void
-rsxgl_attribs_validate(rsxgl_context_t * ctx,program_t & program,const uint32_t start,const uint32_t length,const uint32_t timestamp)
+bool
+rsxgl_attribs_client_arrays(rsxgl_context_t * ctx)
 {
-  gcmContextData * context = ctx -> base.gcm_context;
+  const attribs_t & attribs = ctx -> attribs_binding[0];
+  const bit_set< RSXGL_MAX_VERTEX_ATTRIBS > client = attribs.enabled & attribs.client;
 
-  // Validate the vertex cache
-  // TODO: move this someplace where it can be determined if vertex buffers have been made
-  // invalid, and perform the operation if that's the case.
-  {
+  if(!client.any()) return false;
+  if(!ctx -> state.enable.mapped_client_arrays) return true;
+
+  // Arrays that the GPU can read directly don't need to be copied:
+  for(size_t i = 0;i < RSXGL_MAX_VERTEX_ATTRIBS;++i) {
+    uint32_t offset = 0, location = 0;
+    if(client.test(i) && !rsxgl_client_array_mapped(attribs.pointer[i],offset,location)) return true;
+  }
+
+  return false;
+}
+
+// Size of each component of the vertex types:
+static const uint8_t rsxgl_vertex_type_bytes[8] = {
+  0,
+  sizeof(int16_t),
+  sizeof(float),
+  sizeof(float) / 2,
+  sizeof(uint8_t),
+  sizeof(int16_t),
+  sizeof(uint32_t),
+  sizeof(uint8_t)
+};
+
+// Invalidate the vertex cache if the CPU (or the GPU, through transform feedback or a copy)
+// has written to any of the buffers that are about to be read:
+void
+rsxgl_vertex_cache_validate(rsxgl_context_t * ctx)
+{
+  if(ctx -> invalid.parts.vertex_cache) {
+    gcmContextData * context = ctx -> base.gcm_context;
     uint32_t * buffer = gcm_reserve(context,8);
 
     gcm_emit_method_at(buffer,0,0x1710,1);
@@ -844,7 +875,16 @@ rsxgl_attribs_validate(rsxgl_context_t * ctx,program_t & program,const uint32_t
     gcm_emit_at(buffer,7,0);
 
     gcm_finish_n_commands(context,8);
+
+    ctx -> invalid.parts.vertex_cache = 0;
   }
+}
+
+bool
+rsxgl_attribs_validate(rsxgl_context_t * ctx,program_t & program,const uint32_t start,const uint32_t length,const uint32_t timestamp)
+{
+  gcmContextData * context = ctx -> base.gcm_context;
+  register_cache_t & registers = ctx -> registers;
 
   //
   const program_t::attribs_bitfield_type
@@ -864,60 +904,101 @@ rsxgl_attribs_validate(rsxgl_context_t * ctx,program_t & program,const uint32_t
     invalid_attribs = ctx -> invalid_attribs, enabled_attrib_pointers = attribs.enabled;
   bit_set< RSXGL_MAX_VERTEX_ATTRIBS >
     validated;
+  bool client_arrays_begun = false;
 
   for(program_t::attrib_size_type index = 0;index < RSXGL_MAX_VERTEX_ATTRIBS;++index,enabled_it.next(attribs_enabled),invalid_it.next(invalid_attrib_assignments),assignment_it.next(attrib_assignments)) {
     if(!enabled_it.test()) continue;
 
     const program_t::attrib_size_type api_index = assignment_it.value();
 
-    if(invalid_it.test() || invalid_attribs.test(api_index)) {
+    // The GPU reads from the buffer whether or not its registers need to be sent again, so the
+    // buffer's timestamp is always updated:
+    const bool buffer_attached = enabled_attrib_pointers.test(api_index) && attribs.buffers.names[api_index] != 0 && attribs.buffers[api_index].memory;
+    if(buffer_attached) {
+      // start & length count vertices; the buffer wants to know which bytes will be read. Element
+      // draws don't know which vertices they'll use, and pass a length of 0 (the whole buffer):
+      const uint32_t stride = attribs.stride[api_index];
+      if(length > 0 && stride > 0) {
+	rsxgl_buffer_validate(ctx,attribs.buffers[api_index],attribs.offset[api_index] + (start * stride),length * stride,timestamp);
+      }
+      else {
+	rsxgl_buffer_validate(ctx,attribs.buffers[api_index],0,0,timestamp);
+      }
+    }
+
+    // Client-side arrays are copied for every draw, since the application may have changed them;
+    // GL_RSX_mapped_client_arrays lets the GPU read them where they are:
+    const bool client_enabled = enabled_attrib_pointers.test(api_index) && !buffer_attached && attribs.client.test(api_index);
+    uint32_t client_offset = 0, client_location = 0;
+    const bool client_mapped = client_enabled && ctx -> state.enable.mapped_client_arrays && rsxgl_client_array_mapped(attribs.pointer[api_index],client_offset,client_location);
+    const bool client_attached = client_enabled && (client_mapped || length > 0);
+
+    if(invalid_it.test() || invalid_attribs.test(api_index) || client_attached) {
       // Attribute is backed by a buffer:
       if(enabled_attrib_pointers.test(api_index)) {
 	// A buffer is actually attached:
-	if(attribs.buffers.names[api_index] != 0 && attribs.buffers[api_index].memory) {
-	  rsxgl_buffer_validate(ctx,attribs.buffers[api_index],start,length,timestamp);
-
+	if(buffer_attached) {
 	  const memory_t memory = attribs.buffers[api_index].memory + attribs.offset[api_index];
 
-	  uint32_t * buffer = gcm_reserve(context,4);
-	  
-	  gcm_emit_method_at(buffer,0,NV30_3D_VTXBUF(index),1);
-	  gcm_emit_at(buffer,1,memory.offset | ((uint32_t)memory.location << 31));
-	  gcm_emit_method_at(buffer,2,NV30_3D_VTXFMT(index),1);
-	  gcm_emit_at(buffer,3,
-		      /* ((uint32_t)attribs.frequency[api_index] << 16 | */
-		      ((uint32_t)attribs.stride[api_index] << NV30_3D_VTXFMT_STRIDE__SHIFT) |
-		      ((uint32_t)(attribs.size[api_index] + 1) << NV30_3D_VTXFMT_SIZE__SHIFT) |
-		      ((uint32_t)attribs.type[api_index] & 0x7));
-	  
-	  gcm_finish_n_commands(context,4);
+	  rsxgl_emit_register(context,registers,NV30_3D_VTXBUF(index),memory.offset | ((uint32_t)memory.location << 31));
+	  rsxgl_emit_register(context,registers,NV30_3D_VTXFMT(index),
+			      /* ((uint32_t)attribs.frequency[api_index] << 16 | */
+			      ((uint32_t)attribs.stride[api_index] << NV30_3D_VTXFMT_STRIDE__SHIFT) |
+			      ((uint32_t)(attribs.size[api_index] + 1) << NV30_3D_VTXFMT_SIZE__SHIFT) |
+			      ((uint32_t)attribs.type[api_index] & 0x7));
+	}
+	// Client-side array; copy the vertices that will be used to RSX memory, unless the GPU can
+	// read them already:
+	else if(client_attached) {
+	  if(!client_mapped && !client_arrays_begun) {
+	    rsxgl_client_arrays_begin();
+	    client_arrays_begun = true;
+	  }
+
+	  const uint32_t type = attribs.type[api_index];
+
+	  // The application may have written new data there since the last draw, so the vertex cache
+	  // can't be trusted:
+	  if(client_mapped) {
+	    ctx -> invalid.parts.vertex_cache = 1;
+	  }
+	  else {
+	    const uint32_t element_bytes = (type == RSXGL_VERTEX_S11_11_10_NR) ? 4 : (rsxgl_vertex_type_bytes[type] * (attribs.size[api_index] + 1));
+
+	    // Attributes that weren't reached stay invalid for the next draw:
+	    bool uploaded = false;
+	    if(!rsxgl_client_array_migrate(context,attribs.pointer[api_index],attribs.stride[api_index],element_bytes,start,length,client_offset,uploaded)) return false;
+	    client_location = RSXGL_VERTEX_MIGRATE_BUFFER_LOCATION;
+
+	    // The vertex cache may hold whatever was at that memory before:
+	    if(uploaded) ctx -> invalid.parts.vertex_cache = 1;
+	  }
+
+	  rsxgl_emit_register(context,registers,NV30_3D_VTXBUF(index),client_offset | (client_location << 31));
+	  rsxgl_emit_register(context,registers,NV30_3D_VTXFMT(index),
+			      /* ((uint32_t)attribs.frequency[api_index] << 16 | */
+			      ((uint32_t)attribs.stride[api_index] << NV30_3D_VTXFMT_STRIDE__SHIFT) |
+			      ((uint32_t)(attribs.size[api_index] + 1) << NV30_3D_VTXFMT_SIZE__SHIFT) |
+			      ((uint32_t)type & 0x7));
 	}
 	// Nothing attached; disable fetch:
 	else {
-	  uint32_t * buffer = gcm_reserve(context,2);
-
-	  gcm_emit_method_at(buffer,0,NV30_3D_VTXFMT(index),1);
-	  gcm_emit_at(buffer,1,
-		      /* ((uint32_t)attribs.frequency[i] << 16 | */
-		      ((uint32_t)0 << NV30_3D_VTXFMT_STRIDE__SHIFT) |
-		      ((uint32_t)0 << NV30_3D_VTXFMT_SIZE__SHIFT) |
-		      ((uint32_t)RSXGL_VERTEX_F32 & 0x7));
-	  
-	  gcm_finish_n_commands(context,2);
+	  rsxgl_emit_register(context,registers,NV30_3D_VTXFMT(index),
+			      /* ((uint32_t)attribs.frequency[i] << 16 | */
+			      ((uint32_t)0 << NV30_3D_VTXFMT_STRIDE__SHIFT) |
+			      ((uint32_t)0 << NV30_3D_VTXFMT_SIZE__SHIFT) |
+			      ((uint32_t)RSXGL_VERTEX_F32 & 0x7));
 	}
       }
       // Attribute is constant:
       else {
-	uint32_t * buffer = gcm_reserve(context,5);
-
-	gcm_emit_method_at(buffer,0,NV30_3D_VTX_ATTR_4F(index),4);
-
-	gcm_emit_at(buffer,1,attribs.defaults[api_index][0].u);
-	gcm_emit_at(buffer,2,attribs.defaults[api_index][1].u);
-	gcm_emit_at(buffer,3,attribs.defaults[api_index][2].u);
-	gcm_emit_at(buffer,4,attribs.defaults[api_index][3].u);
-	
-	gcm_finish_n_commands(context,5);
+	const uint32_t values[4] = {
+	  attribs.defaults[api_index][0].u,
+	  attribs.defaults[api_index][1].u,
+	  attribs.defaults[api_index][2].u,
+	  attribs.defaults[api_index][3].u
+	};
+	rsxgl_emit_registers(context,registers,NV30_3D_VTX_ATTR_4F(index),4,values);
       }
 
       validated.set(api_index);
@@ -927,6 +1008,10 @@ rsxgl_attribs_validate(rsxgl_context_t * ctx,program_t & program,const uint32_t
   ctx -> invalid_attrib_assignments.reset();
   ctx -> invalid_attribs &= ~validated;
 
+  rsxgl_vertex_cache_validate(ctx);
+
+  return true;
+
 #if 0
   //
   attribs_t & attribs = ctx -> attribs_binding[0];
@@ -51,6 +51,11 @@ struct attribs_t {
 
   bit_set< RSXGL_MAX_VERTEX_ATTRIBS > enabled;
   uint32_t offset[RSXGL_MAX_VERTEX_ATTRIBS];
+
+  // Attributes that were given client-side arrays (no buffer was bound to GL_ARRAY_BUFFER):
+  bit_set< RSXGL_MAX_VERTEX_ATTRIBS > client;
+  const void * pointer[RSXGL_MAX_VERTEX_ATTRIBS];
+
   smint_array< 15, RSXGL_MAX_VERTEX_ATTRIBS > type;
   smint_array< 3, RSXGL_MAX_VERTEX_ATTRIBS > size;
   uint8_t stride[RSXGL_MAX_VERTEX_ATTRIBS];
@@ -62,6 +67,7 @@ struct attribs_t {
       defaults[i][2].f = 0.0f;
       defaults[i][3].f = 1.0f;
       offset[i] = 0;
+      pointer[i] = 0;
     }
   }
 
@@ -72,6 +78,15 @@ struct attribs_t {
 
 struct rsxgl_context_t;
 
-void rsxgl_attribs_validate(rsxgl_context_t *,program_t &,const uint32_t,const uint32_t,const uint32_t);
+// Returns false if a client-side array couldn't be copied to RSX memory:
+bool rsxgl_attribs_validate(rsxgl_context_t *,program_t &,const uint32_t,const uint32_t,const uint32_t);
+
+// Invalidate the vertex cache, if anything that draws read from has been written since it was
+// last invalidated:
+void rsxgl_vertex_cache_validate(rsxgl_context_t *);
+
+// True if any enabled attribute reads from a client-side array that has to be copied to the GPU.
+// Draws then need to know which vertices they use:
+bool rsxgl_attribs_client_arrays(rsxgl_context_t *);
 
 #endif
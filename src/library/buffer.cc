@@ -8,9 +8,12 @@
 #include <rsx/gcm_sys.h>
 #include "gl_fifo.h"
 #include "buffer.h"
+#include "stream.h"
 #include "timestamp.h"
 #include "attribs.h"
 
+#include "GL3/rsxgl.h"
+
 #include <GL3/gl3.h>
 #include "error.h"
 
@@ -24,6 +27,8 @@
 #endif
 #define GLAPI extern "C"
 
+extern "C" struct rsxgl_init_parameters_t rsxgl_init_parameters;
+
 buffer_t::storage_type & buffer_t::storage()
 {
   return current_object_ctx() -> buffer_storage();
@@ -33,7 +38,12 @@ buffer_t::~buffer_t()
 {
   // Free memory used by this buffer:
   if(memory.offset != 0) {
-    rsxgl_arena_free(memory_arena_t::storage().at(arena),memory);
+    if(stream) {
+      rsxgl_stream_free(rsxgl_ctx,arena,memory,timestamp);
+    }
+    else {
+      rsxgl_arena_free(memory_arena_t::storage().at(arena),memory);
+    }
   }
 }
 
@@ -69,15 +79,8 @@ glDeleteBuffers (GLsizei n, const GLuint* buffers)
     if(buffer_t::storage().is_object(buffer_name)) {
       ctx -> buffer_binding.unbind_from_all(buffer_name);
 
-      // TODO - orphan it, instead of doing this:
-      buffer_t & buffer = buffer_t::storage().at(buffer_name);
-      if(buffer.timestamp > 0) {
-	rsxgl_timestamp_wait(ctx,buffer.timestamp);
-	buffer.timestamp = 0;
-      }
-
-      // 
-      buffer_t::gl_object_type::maybe_delete(buffer_name);
+      // If the GPU is still using the buffer, it's destroyed later by rsxgl_reclaim_orphans():
+      buffer_t::gl_object_type::maybe_delete_or_orphan(rsxgl_timestamp_busy(ctx,buffer_t::storage().at(buffer_name).timestamp),buffer_name);
     }
     // It was just a name:
     else if(buffer_t::storage().is_name(buffer_name)) {
@@ -168,6 +171,286 @@ rsxgl_buffer_valid_range(const struct buffer_t & buffer,uint32_t offset,uint32_t
   }
 }
 
+// Is the GPU possibly still using the buffer's memory? Doesn't flush, or wait:
+static inline bool
+rsxgl_buffer_busy(rsxgl_context_t * ctx,const buffer_t & buffer)
+{
+  return rsxgl_timestamp_busy(ctx,buffer.timestamp);
+}
+
+size_t
+rsxgl_buffer_reclaim_memory(rsxgl_context_t * ctx,const bool wait)
+{
+  retired_buffer_memory_list_t & retired = ctx -> retired_buffer_memory;
+  if(retired.empty()) return 0;
+
+  if(wait) {
+    rsxgl_timestamp_wait(ctx,retired.front().timestamp);
+  }
+
+  const uint32_t issued = rsxgl_timestamp_issued(ctx);
+
+  retired_buffer_memory_list_t::iterator it = retired.begin(), it_end = retired.end(), jt = retired.begin();
+  for(;it != it_end;++it) {
+    if(it -> timestamp != ctx -> pending_timestamp && rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,it -> timestamp,issued)) {
+      rsxgl_arena_free(memory_arena_t::storage().at(it -> arena),it -> memory);
+    }
+    else {
+      *jt++ = *it;
+    }
+  }
+
+  const size_t freed = it_end - jt;
+  retired.erase(jt,it_end);
+
+  return freed;
+}
+
+// Give up memory that a buffer was using. If the GPU is still using it, it's freed later by
+// rsxgl_buffer_reclaim_memory():
+static inline void
+rsxgl_buffer_release_memory(rsxgl_context_t * ctx,const memory_arena_t::name_type arena,const memory_t & memory,const rsx_size_t size,const bool stream,const uint32_t timestamp)
+{
+  // The ring that streamed memory came from keeps track of when it can be reused:
+  if(stream) {
+    rsxgl_stream_free(ctx,arena,memory,timestamp);
+  }
+  else if(rsxgl_timestamp_busy(ctx,timestamp)) {
+    rsxgl_buffer_reclaim_memory(ctx);
+
+    retired_buffer_memory_t retired;
+    retired.arena = arena;
+    retired.memory = memory;
+    retired.size = size;
+    retired.timestamp = timestamp;
+    ctx -> retired_buffer_memory.push_back(retired);
+  }
+  else {
+    rsxgl_arena_free(memory_arena_t::storage().at(arena),memory);
+  }
+}
+
+static inline void
+rsxgl_buffer_retire_memory(rsxgl_context_t * ctx,buffer_t & buffer)
+{
+  if(!buffer.memory) return;
+
+  rsxgl_buffer_release_memory(ctx,buffer.arena,buffer.memory,buffer.size,buffer.stream,buffer.timestamp);
+
+  buffer.memory = memory_t();
+  buffer.timestamp = 0;
+  buffer.write_timestamp = 0;
+}
+
+static inline bool
+rsxgl_buffer_migration_enabled()
+{
+  return rsxgl_init_parameters.buffer_migration != 0;
+}
+
+// Buffers that are respecified often get their memory from a streaming ring:
+static inline bool
+rsxgl_buffer_streamed(const buffer_t & buffer)
+{
+  return buffer.usage == RSXGL_STREAM_DRAW || buffer.usage == RSXGL_DYNAMIC_DRAW ||
+    (rsxgl_buffer_migration_enabled() && buffer.cpu_writes >= RSXGL_BUFFER_MIGRATE_WRITES);
+}
+
+// Where a buffer that the application didn't give an arena to should be. The CPU reads from
+// main memory much faster than from local memory, and writes to it without going through the
+// RSX's uncached mapping; the GPU reads from local memory much faster:
+static inline uint32_t
+rsxgl_buffer_location(const buffer_t & buffer)
+{
+  if(rsxgl_buffer_migration_enabled() && (buffer.cpu_reads >= RSXGL_BUFFER_MIGRATE_READS || buffer.cpu_writes >= RSXGL_BUFFER_MIGRATE_WRITES)) {
+    return RSXGL_MEMORY_LOCATION_MAIN;
+  }
+
+  switch(buffer.usage) {
+  case RSXGL_STREAM_DRAW:
+  case RSXGL_DYNAMIC_DRAW:
+  case RSXGL_STREAM_READ:
+  case RSXGL_STATIC_READ:
+  case RSXGL_DYNAMIC_READ:
+    return RSXGL_MEMORY_LOCATION_MAIN;
+  default:
+    return RSXGL_MEMORY_LOCATION_LOCAL;
+  }
+}
+
+// The main memory arena that buffers are placed in. Returns 0 (the default arena, in local
+// memory) if there isn't one:
+static inline memory_arena_t::name_type
+rsxgl_buffer_main_arena(rsxgl_context_t * ctx)
+{
+  rsxgl_object_context_t * object_ctx = ctx -> object_context();
+
+  if(!object_ctx -> main_buffer_arena_created) {
+    object_ctx -> main_buffer_arena_created = 1;
+
+    static const rsx_size_t align = 1024 * 1024;
+    const rsx_size_t size = (rsxgl_init_parameters.main_buffer_arena_size + align - 1) & ~(align - 1);
+    if(size > 0) {
+      object_ctx -> main_buffer_arena = rsxgl_arena_create(RSXGL_MEMORY_LOCATION_MAIN,align,size);
+    }
+  }
+
+  return object_ctx -> main_buffer_arena;
+}
+
+// The arena that the application asked for the buffer's memory to come from:
+static inline memory_arena_t::name_type
+rsxgl_buffer_requested_arena(const buffer_t & buffer)
+{
+  return buffer.placed ? 0 : buffer.arena;
+}
+
+static inline memory_t
+rsxgl_buffer_arena_allocate(rsxgl_context_t * ctx,const memory_arena_t::name_type arena,const rsx_size_t size,void ** address)
+{
+  memory_t memory = rsxgl_arena_allocate(memory_arena_t::storage().at(arena),128,size,address);
+
+  while(!memory && !ctx -> retired_buffer_memory.empty()) {
+    if(rsxgl_buffer_reclaim_memory(ctx,true) == 0) break;
+    memory = rsxgl_arena_allocate(memory_arena_t::storage().at(arena),128,size,address);
+  }
+
+  return memory;
+}
+
+// Allocate memory for a buffer, from arena. If that's the default arena, then the library places
+// the buffer: streamed buffers try a streaming ring first, and buffers that belong in main memory
+// try the main memory arena. Anything that doesn't fit falls back to the default arena. If an
+// arena is full, wait for retired memory to be freed:
+static inline memory_t
+rsxgl_buffer_allocate(rsxgl_context_t * ctx,buffer_t & buffer,const memory_arena_t::name_type arena,const rsx_size_t size,void ** address)
+{
+  buffer.placed = (arena == 0);
+  buffer.stream = 0;
+
+  if(arena == 0) {
+    const uint32_t location = rsxgl_buffer_location(buffer);
+
+    if(rsxgl_buffer_streamed(buffer)) {
+      const memory_t memory = rsxgl_stream_allocate(ctx,location,128,size,buffer.arena,address);
+      if(memory) {
+	buffer.stream = 1;
+	return memory;
+      }
+    }
+
+    if(location == RSXGL_MEMORY_LOCATION_MAIN) {
+      const memory_arena_t::name_type main_arena = rsxgl_buffer_main_arena(ctx);
+      if(main_arena != 0) {
+	const memory_t memory = rsxgl_arena_allocate(memory_arena_t::storage().at(main_arena),128,size,address);
+	if(memory) {
+	  buffer.arena = main_arena;
+	  return memory;
+	}
+      }
+    }
+  }
+
+  buffer.arena = arena;
+  return rsxgl_buffer_arena_allocate(ctx,arena,size,address);
+}
+
+void
+rsxgl_buffer_invalidate_attribs(rsxgl_context_t * ctx,const buffer_t::name_type name)
+{
+  attribs_t & attribs = ctx -> attribs_binding[0];
+  for(size_t i = 0;i < RSXGL_MAX_VERTEX_ATTRIBS;++i) {
+    if(attribs.buffers.is_bound(i,name)) {
+      ctx -> invalid_attribs.set(i);
+    }
+  }
+}
+
+// Copy data into a main memory staging area (taken from the main memory streaming ring), and have
+// the GPU copy it to the buffer once it's done with the commands that have already been issued.
+// The CPU doesn't wait. Returns false if there's no room to stage the data, or if a command list
+// is being recorded (the copy would be replayed with the list):
+static inline bool
+rsxgl_buffer_upload(rsxgl_context_t * ctx,buffer_t & buffer,const rsx_size_t offset,const rsx_size_t size,const void * data)
+{
+  if(ctx -> command_list != 0) return false;
+
+  memory_arena_t::name_type staging_arena = 0;
+  void * address = 0;
+  const memory_t staging = rsxgl_stream_allocate(ctx,RSXGL_MEMORY_LOCATION_MAIN,16,size,staging_arena,&address);
+  if(!staging) return false;
+
+  memcpy(address,data,size);
+
+  const uint32_t timestamp = rsxgl_timestamp_create(ctx);
+
+  rsxgl_memory_transfer(ctx -> gcm_context(),buffer.memory + offset,size,1,staging,size,1,size,1);
+  rsxgl_flush_policy(ctx,0,0);
+
+  // The staging area is reused once the GPU has made the copy:
+  rsxgl_stream_free(ctx,staging_arena,staging,timestamp);
+
+  buffer.timestamp = timestamp;
+  buffer.write_timestamp = timestamp;
+
+  return true;
+}
+
+// Count an access by the CPU. Returns true if, with buffer migration enabled, the buffer is in
+// local memory but has just been accessed often enough that it belongs in main memory:
+static inline bool
+rsxgl_buffer_count_access(buffer_t & buffer,const bool read,const bool write)
+{
+  bool crossed = false;
+
+  if(read && buffer.cpu_reads < 255) {
+    crossed = crossed || (++buffer.cpu_reads == RSXGL_BUFFER_MIGRATE_READS);
+  }
+  if(write && buffer.cpu_writes < 255) {
+    crossed = crossed || (++buffer.cpu_writes == RSXGL_BUFFER_MIGRATE_WRITES);
+  }
+
+  return crossed && rsxgl_buffer_migration_enabled() && buffer.placed && buffer.memory && buffer.memory.location == RSXGL_MEMORY_LOCATION_LOCAL;
+}
+
+// Give the buffer memory wherever it's placed now, and have the GPU copy its contents there after
+// it's finished with the commands that have already been issued:
+static void
+rsxgl_buffer_migrate(rsxgl_context_t * ctx,const buffer_t::name_type name,buffer_t & buffer)
+{
+  const memory_arena_t::name_type old_arena = buffer.arena;
+  const memory_t old_memory = buffer.memory;
+  const bool old_stream = buffer.stream;
+
+  const memory_t memory = rsxgl_buffer_allocate(ctx,buffer,0,buffer.size,0);
+
+  // Nowhere better to go:
+  if(!memory || memory.location == old_memory.location) {
+    if(memory) {
+      rsxgl_buffer_release_memory(ctx,buffer.arena,memory,buffer.size,buffer.stream,0);
+    }
+
+    buffer.arena = old_arena;
+    buffer.stream = old_stream;
+    return;
+  }
+
+  const uint32_t timestamp = rsxgl_timestamp_create(ctx);
+
+  rsxgl_memory_transfer(ctx -> gcm_context(),memory,buffer.size,1,old_memory,buffer.size,1,buffer.size,1);
+  rsxgl_flush_policy(ctx,0,0);
+
+  rsxgl_buffer_release_memory(ctx,old_arena,old_memory,buffer.size,old_stream,timestamp);
+
+  buffer.memory = memory;
+  buffer.timestamp = timestamp;
+  buffer.write_timestamp = timestamp;
+
+  buffer.invalid = 0;
+  rsxgl_buffer_invalidate_range(buffer,0,buffer.size);
+  rsxgl_buffer_invalidate_attribs(ctx,name);
+}
+
 GLAPI void APIENTRY
 glBindBuffer (GLenum target, GLuint buffer_name)
 {
@@ -278,42 +561,22 @@ glBufferData (GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
 
   buffer_t * buffer = &ctx -> buffer_binding[rsx_target];
 
-#if 0
-  // If a pending GPU operation uses this buffer, then orphan it:
-  if((buffer -> timestamp != 0) && (!rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,buffer -> timestamp))) {
-    buffer_t::storage().orphan(ctx -> buffer_binding.names[rsx_target]);
-
-    buffer -> timestamp = 0;
-    buffer -> invalid = 0;
-    buffer -> usage = 0;
-    buffer -> mapped = 0;
-    buffer -> memory = memory_t();
-    buffer -> arena = 0;
-    buffer -> size = 0;
-    buffer -> mapped_offset = 0;
-    buffer -> mapped_size = 0;
-  }
-#else
-  if(buffer -> timestamp > 0) {
-    rsxgl_timestamp_wait(ctx,buffer -> timestamp);
-    buffer -> timestamp = 0;
+  // Respecifying a buffer's contents counts as a write, for placement:
+  if(buffer -> memory && data != 0) {
+    rsxgl_buffer_count_access(*buffer,false,true);
   }
 
-  // Free the old buffer:
-  if(buffer -> memory.offset != 0) {
-    rsxgl_arena_free(memory_arena_t::storage().at(buffer -> arena),buffer -> memory);
-    buffer -> memory = memory_t();
-  }
-#endif
+  // The old memory is freed once the GPU is done with it; the new memory can be written to right
+  // away:
+  rsxgl_buffer_retire_memory(ctx,*buffer);
+  buffer -> size = 0;
 
   // If a buffer is actually being requested, then allocate memory for it:
   void * address = 0;
   
   if(size > 0) {
-    buffer -> invalid = 1;
     buffer -> usage = rsx_usage;
-    buffer -> arena = ctx -> arena_binding.names[RSXGL_BUFFER_ARENA];
-    buffer -> memory = rsxgl_arena_allocate(memory_arena_t::storage().at(buffer -> arena),128,size,&address);
+    buffer -> memory = rsxgl_buffer_allocate(ctx,*buffer,ctx -> arena_binding.names[RSXGL_BUFFER_ARENA],size,&address);
     
     if(!buffer -> memory) RSXGL_ERROR_(GL_OUT_OF_MEMORY);
     
@@ -324,15 +587,12 @@ glBufferData (GLenum target, GLsizeiptr size, const GLvoid* data, GLenum usage)
     memcpy(address,data,buffer -> size);
   }
 
-  const buffer_t::name_type name = ctx -> buffer_binding.names[rsx_target];
+  // The vertex cache may hold whatever used to be at the new address:
+  buffer -> invalid = 0;
+  rsxgl_buffer_invalidate_range(*buffer,0,buffer -> size);
 
   // See if the buffer is attached to the current vertex array object; if so, invalidate:
-  attribs_t & attribs = ctx -> attribs_binding[0];
-  for(size_t i = 0;i < RSXGL_MAX_VERTEX_ATTRIBS;++i) {
-    if(attribs.buffers.is_bound(i,name)) {
-      ctx -> invalid_attribs.set(i);
-    }
-  }
+  rsxgl_buffer_invalidate_attribs(ctx,ctx -> buffer_binding.names[rsx_target]);
 
   RSXGL_NOERROR_();
 }
@@ -363,18 +623,47 @@ glBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, const GLvoid*
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  void * address = rsxgl_arena_address(memory_arena_t::storage().at(buffer.arena),buffer.memory);
+  if(buffer.memory && data != 0 && size > 0) {
+    const bool migrate = rsxgl_buffer_count_access(buffer,false,true);
 
-  if(address != 0 && data != 0 && size > 0) {
-    // TODO - if a pending operation depends upon this buffer, wait for that operation to finish:
-    // TODO - replace this with something smarter that doesn't conservatively decide to block on the GPU:
-    if(buffer.timestamp > 0) {
-      rsxgl_timestamp_wait(ctx,buffer.timestamp);
-      buffer.timestamp = 0;
+    // Replacing all of the contents of a buffer that the GPU is still using, or that belongs
+    // elsewhere - give it new memory:
+    if(offset == 0 && (rsx_size_t)size == buffer.size && (migrate || rsxgl_buffer_busy(ctx,buffer))) {
+      const memory_arena_t::name_type arena = rsxgl_buffer_requested_arena(buffer);
+      rsxgl_buffer_retire_memory(ctx,buffer);
+
+      buffer.memory = rsxgl_buffer_allocate(ctx,buffer,arena,size,0);
+      if(!buffer.memory) {
+	buffer.size = 0;
+	RSXGL_ERROR_(GL_OUT_OF_MEMORY);
+      }
+
+      rsxgl_buffer_invalidate_attribs(ctx,ctx -> buffer_binding.names[rsx_target]);
+    }
+    else {
+      if(migrate) {
+	rsxgl_buffer_migrate(ctx,ctx -> buffer_binding.names[rsx_target],buffer);
+      }
+
+      // The CPU writes to local memory slowly, and would have to wait for the GPU to finish with a
+      // busy buffer - in those cases, have the GPU copy the data in instead:
+      if((buffer.memory.location == RSXGL_MEMORY_LOCATION_LOCAL || rsxgl_buffer_busy(ctx,buffer)) &&
+	 rsxgl_buffer_upload(ctx,buffer,offset,size,data)) {
+	rsxgl_buffer_invalidate_range(buffer,offset,size);
+	RSXGL_NOERROR_();
+      }
+
+      if(buffer.timestamp > 0) {
+	rsxgl_timestamp_wait(ctx,buffer.timestamp);
+	buffer.timestamp = 0;
+      }
     }
+
+    void * address = rsxgl_arena_address(memory_arena_t::storage().at(buffer.arena),buffer.memory);
     
     // Copy the data:
     memcpy((uint8_t *)address + offset,data,size);
+    rsxgl_buffer_invalidate_range(buffer,offset,size);
   }
 
   RSXGL_NOERROR_();
@@ -406,10 +695,17 @@ glGetBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, GLvoid *dat
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  void * address = rsxgl_arena_address(memory_arena_t::storage().at(buffer.arena),buffer.memory);
+  if(buffer.memory && data != 0 && size > 0) {
+    if(rsxgl_buffer_count_access(buffer,true,false)) {
+      rsxgl_buffer_migrate(ctx,ctx -> buffer_binding.names[rsx_target],buffer);
+    }
+
+    // The GPU may still be writing to the buffer:
+    if(rsxgl_buffer_busy(ctx,buffer)) {
+      rsxgl_timestamp_wait(ctx,buffer.timestamp);
+    }
 
-  if(address != 0 && data != 0 && size > 0) {
-    // TODO - wait for pending operations to finish:
+    void * address = rsxgl_arena_address(memory_arena_t::storage().at(buffer.arena),buffer.memory);
 
     // Copy it:
     memcpy(data,(uint8_t *)address + offset,size);
@@ -419,39 +715,55 @@ glGetBufferSubData (GLenum target, GLintptr offset, GLsizeiptr size, GLvoid *dat
 }
 
 static inline void *
-rsxgl_map_buffer_range(rsxgl_context_t * ctx,const buffer_t::name_type buffer_name,const uint32_t offset, const uint32_t _length,const uint32_t access)
+rsxgl_map_buffer_range(rsxgl_context_t * ctx,const buffer_t::name_type buffer_name,const uint32_t offset,const uint32_t length,const int rsx_access,const GLbitfield flags)
 {
   buffer_t & buffer = buffer_t::storage().at(buffer_name);
-  const uint32_t length = (_length == 0) ? buffer.size : _length;
 
   if(buffer.mapped != 0) {
     RSXGL_ERROR(GL_INVALID_OPERATION,0);
   }
 
-  int rsx_access = rsxgl_buffer_access(access);
-  if(rsx_access == ~0) {
-    RSXGL_ERROR(GL_INVALID_ENUM,0);
-  }
-
-  if(offset < 0 || length < 0) {
-    RSXGL_ERROR(GL_INVALID_VALUE,0);
-  }
   if(!rsxgl_buffer_valid_range(buffer,offset,length)) {
     RSXGL_ERROR(GL_INVALID_VALUE,0);
   }
 
-  // TODO - replace this with something smarter that doesn't conservatively decide to block on the GPU:
-  if(buffer.timestamp > 0) {
-    rsxgl_timestamp_wait(ctx,buffer.timestamp);
-    buffer.timestamp = 0;
+  // The previous contents don't need to be kept - if the GPU is still using them, then
+  // give the buffer new memory instead of waiting:
+  const bool invalidate = (flags & GL_MAP_INVALIDATE_BUFFER_BIT) || ((flags & GL_MAP_INVALIDATE_RANGE_BIT) && offset == 0 && length == buffer.size);
+
+  const bool migrate = rsxgl_buffer_count_access(buffer,rsx_access & RSXGL_READ_ONLY,rsx_access & RSXGL_WRITE_ONLY);
+
+  if(invalidate && (migrate || rsxgl_buffer_busy(ctx,buffer))) {
+    const memory_arena_t::name_type arena = rsxgl_buffer_requested_arena(buffer);
+    rsxgl_buffer_retire_memory(ctx,buffer);
+
+    buffer.memory = rsxgl_buffer_allocate(ctx,buffer,arena,buffer.size,0);
+    if(!buffer.memory) {
+      buffer.size = 0;
+      RSXGL_ERROR(GL_OUT_OF_MEMORY,0);
+    }
+
+    rsxgl_buffer_invalidate_attribs(ctx,buffer_name);
+  }
+  else {
+    if(migrate) {
+      rsxgl_buffer_migrate(ctx,buffer_name,buffer);
+    }
+
+    // With GL_MAP_UNSYNCHRONIZED_BIT, the application has promised not to touch anything that
+    // the GPU is still using - which doesn't include the copy made by a migration:
+    if((migrate || !(flags & GL_MAP_UNSYNCHRONIZED_BIT)) && buffer.timestamp > 0) {
+      rsxgl_timestamp_wait(ctx,buffer.timestamp);
+      buffer.timestamp = 0;
+    }
   }
 
-  // 
   buffer.mapped = rsx_access;
-  buffer.mapped_offset = 0;
-  buffer.mapped_size = buffer.size;
+  buffer.mapped_explicit = (flags & GL_MAP_FLUSH_EXPLICIT_BIT) ? 1 : 0;
+  buffer.mapped_offset = offset;
+  buffer.mapped_size = length;
 
-  RSXGL_NOERROR(rsxgl_arena_address(memory_arena_t::storage().at(buffer.arena),buffer.memory));
+  RSXGL_NOERROR((uint8_t *)rsxgl_arena_address(memory_arena_t::storage().at(buffer.arena),buffer.memory) + offset);
 }
 
 //
@@ -463,13 +775,18 @@ glMapBuffer (GLenum target, GLenum access)
     RSXGL_ERROR(GL_INVALID_ENUM,0);
   }
 
+  int rsx_access = rsxgl_buffer_access(access);
+  if(rsx_access == ~0) {
+    RSXGL_ERROR(GL_INVALID_ENUM,0);
+  }
+
   rsxgl_context_t * ctx = current_ctx();
 
   if(ctx -> buffer_binding.names[rsx_target] == 0) {
     RSXGL_ERROR(GL_INVALID_OPERATION,0);
   }
   
-  return rsxgl_map_buffer_range(ctx,ctx -> buffer_binding.names[rsx_target],0,0,access);
+  return rsxgl_map_buffer_range(ctx,ctx -> buffer_binding.names[rsx_target],0,ctx -> buffer_binding[rsx_target].size,rsx_access,0);
 }
 
 GLAPI GLvoid* APIENTRY
@@ -480,13 +797,35 @@ glMapBufferRange (GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield
     RSXGL_ERROR(GL_INVALID_ENUM,0);
   }
 
+  if(offset < 0 || length <= 0) {
+    RSXGL_ERROR(GL_INVALID_VALUE,0);
+  }
+
+  static const GLbitfield valid_access = GL_MAP_READ_BIT | GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_FLUSH_EXPLICIT_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+  if((access & ~valid_access) != 0) {
+    RSXGL_ERROR(GL_INVALID_VALUE,0);
+  }
+
+  const int rsx_access = ((access & GL_MAP_READ_BIT) ? RSXGL_READ_ONLY : 0) | ((access & GL_MAP_WRITE_BIT) ? RSXGL_WRITE_ONLY : 0);
+  if(rsx_access == 0) {
+    RSXGL_ERROR(GL_INVALID_OPERATION,0);
+  }
+
+  if((access & GL_MAP_READ_BIT) && (access & (GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT | GL_MAP_UNSYNCHRONIZED_BIT))) {
+    RSXGL_ERROR(GL_INVALID_OPERATION,0);
+  }
+
+  if((access & GL_MAP_FLUSH_EXPLICIT_BIT) && !(access & GL_MAP_WRITE_BIT)) {
+    RSXGL_ERROR(GL_INVALID_OPERATION,0);
+  }
+
   rsxgl_context_t * ctx = current_ctx();
 
   if(ctx -> buffer_binding.names[rsx_target] == 0) {
     RSXGL_ERROR(GL_INVALID_OPERATION,0);
   }
 
-  return rsxgl_map_buffer_range(ctx,ctx -> buffer_binding.names[rsx_target],offset,length,access);
+  return rsxgl_map_buffer_range(ctx,ctx -> buffer_binding.names[rsx_target],offset,length,rsx_access,access);
 }
 
 GLAPI void APIENTRY
@@ -504,18 +843,16 @@ glFlushMappedBufferRange (GLenum target, GLintptr offset, GLsizeiptr length)
   }
   buffer_t & buffer = ctx -> buffer_binding[rsx_target];
 
-  if(buffer.mapped == 0) {
+  if(buffer.mapped == 0 || !buffer.mapped_explicit) {
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
 
-  if(offset < 0 || length < 0) {
-    RSXGL_ERROR_(GL_INVALID_VALUE);
-  }
-  if(!rsxgl_buffer_valid_range(buffer,offset,length)) {
+  // offset is relative to the mapped range:
+  if(offset < 0 || length < 0 || ((rsx_size_t)offset + (rsx_size_t)length) > buffer.mapped_size) {
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  // TODO - Implement this function.
+  rsxgl_buffer_invalidate_range(buffer,buffer.mapped_offset + offset,length);
 
   RSXGL_NOERROR_();
 }
@@ -539,7 +876,13 @@ glUnmapBuffer (GLenum target)
     RSXGL_ERROR(GL_INVALID_OPERATION,GL_FALSE);
   }
 
+  // Explicitly-flushed mappings have already reported what was written:
+  if((buffer.mapped & RSXGL_WRITE_ONLY) && !buffer.mapped_explicit) {
+    rsxgl_buffer_invalidate_range(buffer,buffer.mapped_offset,buffer.mapped_size);
+  }
+
   buffer.mapped = 0;
+  buffer.mapped_explicit = 0;
   buffer.mapped_offset = 0;
   buffer.mapped_size = 0;
 
@@ -690,7 +1033,7 @@ glCopyBufferSubData (GLenum readTarget, GLenum writeTarget, GLintptr readOffset,
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
   
-  const uint32_t timestamp = rsxgl_timestamp_create(ctx,1);
+  const uint32_t timestamp = rsxgl_timestamp_create(ctx);
 
   gcmContextData * context = ctx -> gcm_context();
 
@@ -712,26 +1055,28 @@ glCopyBufferSubData (GLenum readTarget, GLenum writeTarget, GLintptr readOffset,
 
   gcm_finish_n_commands(context,12);
 
-  rsxgl_timestamp_post(ctx,timestamp);
-
-  rsxgl_assert(timestamp >= ctx -> buffer_binding[iread].timestamp);
-  rsxgl_assert(timestamp >= ctx -> buffer_binding[iwrite].timestamp);
+  rsxgl_flush_policy(ctx,0,0);
 
   ctx -> buffer_binding[iread].timestamp = timestamp;
   ctx -> buffer_binding[iwrite].timestamp = timestamp;
+  ctx -> buffer_binding[iwrite].write_timestamp = timestamp;
+  rsxgl_buffer_invalidate_range(write_buffer,writeOffset,size);
 
   RSXGL_NOERROR_();
 }
 
 void
-rsxgl_buffer_validate(rsxgl_context_t *,buffer_t & buffer,const uint32_t start,const uint32_t length,const uint32_t timestamp)
+rsxgl_buffer_validate(rsxgl_context_t * ctx,buffer_t & buffer,const uint32_t start,const uint32_t length,const uint32_t timestamp)
 {
-  rsxgl_assert(timestamp >= buffer.timestamp);
   buffer.timestamp = timestamp;
 
-  if(buffer.invalid) {
-    // TODO - here will go flushing of mapped buffers, to replace the current scheme where the CPU synchronizes with the GPU.
+  // Writes that don't overlap the range being read can wait. Invalidating the vertex cache makes
+  // everything that's been written visible, though:
+  if(buffer.invalid && (length == 0 || (start < buffer.invalid_end && buffer.invalid_start < (start + length)))) {
+    ctx -> invalid.parts.vertex_cache = 1;
 
-    buffer.invalid = 1;
+    buffer.invalid = 0;
+    buffer.invalid_start = 0;
+    buffer.invalid_end = 0;
   }
 }
@@ -13,6 +13,9 @@
 #include "gl_object.h"
 #include "arena.h"
 
+#include <algorithm>
+#include <vector>
+
 enum rsxgl_buffer_target {
   RSXGL_ARRAY_BUFFER = 0,
   RSXGL_COPY_READ_BUFFER = 1,
@@ -52,6 +55,14 @@ enum rsxgl_buffer_usage {
   RSXGL_DYNAMIC_COPY = 8
 };
 
+// The indices found when the CPU scanned part of a buffer for an element draw (valid when valid
+// is set):
+struct buffer_element_range_t {
+  rsx_size_t offset, count;
+  uint32_t restart_index, min, max;
+  uint8_t valid:1, type:2, restart:1;
+};
+
 struct buffer_t {
   typedef bindable_gl_object< buffer_t, RSXGL_MAX_BUFFERS, RSXGL_MAX_BUFFER_TARGETS > gl_object_type;
   typedef typename gl_object_type::name_type name_type;
@@ -66,7 +77,20 @@ struct buffer_t {
   uint32_t deleted:1, timestamp:31;
   uint32_t ref_count;
 
-  uint8_t invalid:1,usage:4,mapped:2;
+  // Last timestamp at which the GPU writes to the buffer's memory, or 0. The CPU only has to wait
+  // for this, rather than for timestamp, before it reads the buffer:
+  uint32_t write_timestamp;
+
+  // mapped_explicit is set when the buffer was mapped with GL_MAP_FLUSH_EXPLICIT_BIT:
+  uint8_t invalid:1,usage:4,mapped:2,mapped_explicit:1;
+
+  // placed is set when the library chose where the buffer's memory is (no arena was bound); stream
+  // is set when that memory came from one of the context's streaming rings:
+  uint8_t placed:1,stream:1;
+
+  // How many times the CPU has written to, and read from, the buffer (saturating). Used to
+  // migrate buffers whose usage hint turns out to be wrong:
+  uint8_t cpu_writes, cpu_reads;
 
   memory_t memory;
   memory_arena_t::name_type arena;
@@ -74,21 +98,77 @@ struct buffer_t {
 
   rsx_size_t mapped_offset, mapped_size;
 
+  // Range of the buffer that's been written to since the GPU last read from it (valid when
+  // invalid is set). The GPU's vertex cache has to be invalidated before it reads from there:
+  rsx_size_t invalid_start, invalid_end;
+
+  // Reading the buffer back can be slow, so the ranges of indices that draws have scanned are kept
+  // until the buffer is written to. element_range_next is the entry that the next scan replaces:
+  buffer_element_range_t element_ranges[RSXGL_BUFFER_ELEMENT_RANGES];
+  uint8_t element_range_next;
+
   buffer_t()
-    : deleted(0), timestamp(0), ref_count(0), invalid(0), usage(0), mapped(0), arena(0), size(0), mapped_offset(0), mapped_size(0) {
+    : deleted(0), timestamp(0), ref_count(0), write_timestamp(0), invalid(0), usage(0), mapped(0), mapped_explicit(0), placed(0), stream(0), cpu_writes(0), cpu_reads(0), arena(0), size(0), mapped_offset(0), mapped_size(0), invalid_start(0), invalid_end(0),
+      element_ranges(), element_range_next(0) {
   }
 
   ~buffer_t();
 };
 
+template<> bool gl_object_in_use< buffer_t >(const buffer_t &);
+
 static inline uint32_t
 rsxgl_pointer_to_offset(const void * ptr)
 {
   return (uint32_t)((uint64_t)ptr);
 }
 
+// Memory that used to back a buffer, but that the GPU may still be reading from. Respecifying a
+// buffer that's in use gives it new memory right away; the old memory is freed once the GPU has
+// passed the timestamp:
+struct retired_buffer_memory_t {
+  memory_arena_t::name_type arena;
+  memory_t memory;
+  rsx_size_t size;
+  uint32_t timestamp;
+};
+
+typedef std::vector< retired_buffer_memory_t > retired_buffer_memory_list_t;
+
+// Record that part of a buffer has been written to:
+static inline void
+rsxgl_buffer_invalidate_range(buffer_t & buffer,const rsx_size_t offset,const rsx_size_t length)
+{
+  if(length == 0) return;
+
+  for(size_t i = 0;i < RSXGL_BUFFER_ELEMENT_RANGES;++i) {
+    buffer.element_ranges[i].valid = 0;
+  }
+
+  if(buffer.invalid) {
+    buffer.invalid_start = std::min(buffer.invalid_start,offset);
+    buffer.invalid_end = std::max(buffer.invalid_end,offset + length);
+  }
+  else {
+    buffer.invalid = 1;
+    buffer.invalid_start = offset;
+    buffer.invalid_end = offset + length;
+  }
+}
+
 struct rsxgl_context_t;
 
+// Called when the GPU is about to read length bytes of the buffer, starting at start (a length of
+// 0 means that the range isn't known). Tags the buffer with timestamp, and has the vertex cache
+// invalidated if any of that range was written to:
 void rsxgl_buffer_validate(rsxgl_context_t *,buffer_t &,const uint32_t,const uint32_t,const uint32_t);
 
+// The buffer's memory moved - vertex attributes that use it need to be sent to the GPU again:
+void rsxgl_buffer_invalidate_attribs(rsxgl_context_t *,const buffer_t::name_type);
+
+// Free retired memory that the GPU is done with. If wait is true, wait for at least one
+// allocation to become free. Returns how many allocations were freed - waiting frees nothing
+// while a command list is being recorded, if the memory was retired by the recorded commands:
+size_t rsxgl_buffer_reclaim_memory(rsxgl_context_t *,const bool wait = false);
+
 #endif
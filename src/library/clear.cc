@@ -98,7 +98,7 @@ glClear(GLbitfield mask)
 
   struct rsxgl_context_t * ctx = current_ctx();
   
-  const uint32_t timestamp = rsxgl_timestamp_create(ctx,1);
+  const uint32_t timestamp = rsxgl_timestamp_create(ctx);
   rsxgl_draw_framebuffer_validate(ctx,timestamp);
   rsxgl_state_validate(ctx);
   
@@ -118,8 +118,10 @@ glClear(GLbitfield mask)
 	      (mask & GL_STENCIL_BUFFER_BIT ? (write_mask.parts.stencil ? NV30_3D_CLEAR_BUFFERS_STENCIL : 0) : 0));
   
   gcm_finish_n_commands(context,2);
+
+  rsxgl_draw_framebuffer_written(ctx);
     
-  rsxgl_timestamp_post(ctx,timestamp);
+  rsxgl_flush_policy(ctx,1,0);
   
   RSXGL_NOERROR_();
 }
@@ -0,0 +1,199 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// client_arrays.cc - Copy client-side vertex arrays to RSX memory for drawing.
+
+#include "client_arrays.h"
+#include "migrate.h"
+
+#include "rsxgl_config.h"
+#include "rsxgl_assert.h"
+#include "rsxgl_limits.h"
+
+#include <rsx/gcm_sys.h>
+
+#include <string.h>
+
+namespace {
+
+  struct client_array_copy_t {
+    // Client data that was copied - first is counted in bytes from pointer:
+    const void * pointer;
+    uint32_t first, size;
+    uint64_t hash;
+
+    // Where it was copied to; address is 0 if the entry is unused:
+    void * address;
+    uint32_t offset;
+
+    // Migration buffer position just after the copy was made, and the last draw that used it:
+    uint32_t allocated, draw;
+  };
+
+}
+
+static client_array_copy_t rsxgl_client_array_cache[RSXGL_CLIENT_ARRAY_CACHE_SIZE];
+
+// Number of draws that have used client-side arrays:
+static uint32_t rsxgl_client_array_draw = 0;
+
+// Cached copies pin the migration buffer, which can't give back any space allocated after them
+// until they're freed. Give them up once this much has been allocated from it since, by anyone:
+static const uint32_t rsxgl_client_array_max_age = RSXGL_CONFIG_vertex_migrate_buffer_size / 2;
+
+// 64-bit FNV-1a, a word at a time:
+static inline uint64_t
+rsxgl_client_array_hash(const uint8_t * data,uint32_t size)
+{
+  uint64_t hash = 14695981039346656037ULL;
+  for(;size >= sizeof(uint32_t);size -= sizeof(uint32_t),data += sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word,data,sizeof(uint32_t));
+    hash = (hash ^ word) * 1099511628211ULL;
+  }
+  for(;size > 0;--size,++data) {
+    hash = (hash ^ *data) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+static inline void
+rsxgl_client_array_evict(gcmContextData * context,client_array_copy_t & copy)
+{
+  rsxgl_vertex_migrate_free(context,copy.address,copy.size);
+  copy.address = 0;
+}
+
+void
+rsxgl_client_arrays_begin()
+{
+  ++rsxgl_client_array_draw;
+}
+
+bool
+rsxgl_client_arrays_release(gcmContextData * context)
+{
+  bool released = false;
+  for(size_t i = 0;i < RSXGL_CLIENT_ARRAY_CACHE_SIZE;++i) {
+    client_array_copy_t & copy = rsxgl_client_array_cache[i];
+    if(copy.address != 0 && copy.draw != rsxgl_client_array_draw) {
+      rsxgl_client_array_evict(context,copy);
+      released = true;
+    }
+  }
+  return released;
+}
+
+// Allocate from the migration buffer, giving up cached copies to make room if necessary:
+static inline void *
+rsxgl_client_array_memalign(gcmContextData * context,const uint32_t size)
+{
+  void * address = rsxgl_vertex_migrate_memalign(context,RSXGL_VERTEX_MIGRATE_BUFFER_ALIGN,size);
+  if(address == 0 && rsxgl_client_arrays_release(context)) {
+    address = rsxgl_vertex_migrate_memalign(context,RSXGL_VERTEX_MIGRATE_BUFFER_ALIGN,size);
+  }
+  return address;
+}
+
+bool
+rsxgl_client_array_migrate(gcmContextData * context,const void * pointer,const uint32_t stride,const uint32_t element_bytes,const uint32_t start,const uint32_t length,uint32_t & offset,bool & uploaded)
+{
+  rsxgl_assert(length > 0);
+
+  uint32_t first = start * stride, size = (length - 1) * stride + element_bytes;
+  const uint8_t * data = (const uint8_t *)pointer + first;
+  const uint64_t hash = rsxgl_client_array_hash(data,size);
+
+  // Look for an earlier copy; give up old ones, and find somewhere to put a new one, along the way:
+  client_array_copy_t * hit = 0, * slot = 0;
+
+  for(size_t i = 0;i < RSXGL_CLIENT_ARRAY_CACHE_SIZE;++i) {
+    client_array_copy_t & copy = rsxgl_client_array_cache[i];
+
+    if(copy.address != 0) {
+      if(copy.pointer == pointer && copy.first == first && copy.size == size && copy.hash == hash) {
+	hit = &copy;
+	continue;
+      }
+      else if(copy.draw != rsxgl_client_array_draw && (rsxgl_vertex_migrate_allocated() - copy.allocated) > rsxgl_client_array_max_age) {
+	rsxgl_client_array_evict(context,copy);
+      }
+    }
+
+    // Prefer an empty entry, then the least recently used:
+    if(copy.address == 0) {
+      if(slot == 0 || slot -> address != 0) slot = &copy;
+    }
+    else if(copy.draw != rsxgl_client_array_draw && (slot == 0 || (slot -> address != 0 && (int32_t)(copy.draw - slot -> draw) < 0))) {
+      slot = &copy;
+    }
+  }
+
+  if(hit != 0) {
+    hit -> draw = rsxgl_client_array_draw;
+    offset = hit -> offset - first;
+    uploaded = false;
+    return true;
+  }
+
+  // There are more entries than attributes, so one is always free for this draw:
+  rsxgl_assert(slot != 0);
+  if(slot -> address != 0) rsxgl_client_array_evict(context,*slot);
+
+  void * address = rsxgl_client_array_memalign(context,size);
+  if(address == 0) return false;
+
+  int32_t s = gcmAddressToOffset(address,&offset);
+  rsxgl_assert(s == 0);
+
+  // Vertex 0 has to be at a representable offset; if it wouldn't be, copy from the start of the
+  // array instead:
+  if(offset < first) {
+    rsxgl_vertex_migrate_free(context,address,size);
+
+    size += first;
+    first = 0;
+    data = (const uint8_t *)pointer;
+
+    address = rsxgl_client_array_memalign(context,size);
+    if(address == 0) return false;
+
+    s = gcmAddressToOffset(address,&offset);
+    rsxgl_assert(s == 0);
+  }
+
+  memcpy(address,data,size);
+
+  slot -> pointer = pointer;
+  slot -> first = first;
+  slot -> size = size;
+  slot -> hash = (first == start * stride) ? hash : rsxgl_client_array_hash(data,size);
+  slot -> address = address;
+  slot -> offset = offset;
+  slot -> allocated = rsxgl_vertex_migrate_allocated();
+  slot -> draw = rsxgl_client_array_draw;
+
+  offset -= first;
+  uploaded = true;
+  return true;
+}
+
+// Bounds of RSX memory, as the CPU sees it:
+static const uint8_t * rsxgl_client_array_local_begin = 0, * rsxgl_client_array_local_end = 0;
+
+bool
+rsxgl_client_array_mapped(const void * pointer,uint32_t & offset,uint32_t & location)
+{
+  if(rsxgl_client_array_local_begin == 0) {
+    gcmConfiguration config;
+    gcmGetConfiguration(&config);
+    rsxgl_client_array_local_begin = (const uint8_t *)config.localAddress;
+    rsxgl_client_array_local_end = rsxgl_client_array_local_begin + config.localSize;
+  }
+
+  if(pointer == 0 || gcmAddressToOffset((void *)pointer,&offset) != 0) return false;
+
+  location = ((const uint8_t *)pointer >= rsxgl_client_array_local_begin && (const uint8_t *)pointer < rsxgl_client_array_local_end) ? RSXGL_MEMORY_LOCATION_LOCAL : RSXGL_MEMORY_LOCATION_MAIN;
+  return true;
+}
@@ -0,0 +1,42 @@
+//-*-C++-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// client_arrays.h - Copy client-side vertex arrays to RSX memory for drawing.
+//
+// The vertices that a draw uses are copied into the vertex migration buffer. Copies are kept in a
+// small cache, keyed by the client pointer, the range of bytes copied and a hash of their
+// contents, so that a mesh that's drawn repeatedly without changing is only copied once. Cached
+// copies hold on to their space in the migration buffer; they're given up once enough else has
+// been allocated from it after them (client-side indices included), or when it runs out of room.
+//
+// With GL_MAPPED_CLIENT_ARRAYS_RSX enabled, arrays that the RSX can already read aren't copied.
+
+#ifndef rsxgl_client_arrays_H
+#define rsxgl_client_arrays_H
+
+#include <stdint.h>
+
+typedef struct _gcmCtxData gcmContextData;
+
+// Called at the start of each draw that uses client-side arrays; copies made for the draw stay in
+// the cache at least until the next one:
+void rsxgl_client_arrays_begin();
+
+// Make the vertices [start,start + length) of a client-side array available to the GPU. Sets
+// offset to the RSX offset that vertex 0 would be at, and uploaded if the data had to be copied.
+// Returns false if there wasn't room in the migration buffer:
+bool rsxgl_client_array_migrate(gcmContextData *,const void * pointer,const uint32_t stride,const uint32_t element_bytes,const uint32_t start,const uint32_t length,uint32_t & offset,bool & uploaded);
+
+// Give up the cached copies that the current draw doesn't use, so that the migration buffer can
+// reclaim their space. Returns false if there weren't any:
+bool rsxgl_client_arrays_release(gcmContextData *);
+
+// GL_RSX_mapped_client_arrays - the application promises that the client pointers it draws from
+// are in memory that the RSX can read (RSX memory, or main memory mapped with gcmMapMainMemory),
+// and that it won't change the data until the GPU is done with it. Finds the RSX offset &
+// location of such a pointer; returns false if the RSX can't reach it:
+bool rsxgl_client_array_mapped(const void * pointer,uint32_t & offset,uint32_t & location);
+
+#endif
@@ -0,0 +1,335 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// command_list.cc - Record validated command streams for later replay (GL_RSX_command_list).
+
+#include "command_list.h"
+#include "rsxgl_context.h"
+#include "gl_fifo.h"
+#include "mem.h"
+#include "rsxgl_config.h"
+#include "rsxgl_assert.h"
+#include "debug.h"
+
+#include <GL3/gl3.h>
+#include "GL3/rsxgl3ext.h"
+#include "error.h"
+
+#include <rsx/gcm_sys.h>
+
+#include <malloc.h>
+#include <algorithm>
+
+#if defined(GLAPI)
+#undef GLAPI
+#endif
+#define GLAPI extern "C"
+
+// Segments are allocated from a single region of main memory that's mapped for the RSX:
+static void * rsxgl_command_list_buffer = 0;
+static uint32_t rsxgl_command_list_buffer_offset = 0;
+static mspace rsxgl_command_list_buffer_space = 0;
+
+static void *
+rsxgl_command_list_segment_allocate(const uint32_t length,uint32_t * offset)
+{
+  if(rsxgl_command_list_buffer == 0) {
+    void * buffer = memalign(1024 * 1024,RSXGL_CONFIG_command_list_buffer_size);
+    if(buffer == 0) {
+      return 0;
+    }
+
+    int32_t s = gcmMapMainMemory(buffer,RSXGL_CONFIG_command_list_buffer_size,&rsxgl_command_list_buffer_offset);
+    if(s != 0) {
+      free(buffer);
+      return 0;
+    }
+
+    rsxgl_command_list_buffer = buffer;
+    rsxgl_command_list_buffer_space = create_mspace_with_base(rsxgl_command_list_buffer,RSXGL_CONFIG_command_list_buffer_size,0);
+  }
+
+  void * segment = mspace_memalign(rsxgl_command_list_buffer_space,RSXGL_CACHE_LINE_SIZE,length * sizeof(uint32_t));
+  if(segment != 0) {
+    *offset = rsxgl_command_list_buffer_offset + ((uint8_t *)segment - (uint8_t *)rsxgl_command_list_buffer);
+  }
+  return segment;
+}
+
+static void
+rsxgl_command_list_segment_free(void * segment)
+{
+  rsxgl_assert(rsxgl_command_list_buffer != 0);
+  mspace_free(rsxgl_command_list_buffer_space,segment);
+}
+
+command_list_t::storage_type &
+command_list_t::storage()
+{
+  static command_list_t::storage_type _storage(RSXGL_MAX_COMMAND_LISTS);
+  return _storage;
+}
+
+command_list_t::command_list_t()
+  : timestamp(0), offset(0)
+{
+}
+
+command_list_t::~command_list_t()
+{
+  for(void * segment : segments) {
+    rsxgl_command_list_segment_free(segment);
+  }
+}
+
+// Start writing into a new segment, of at least count + 1 words (one word is kept free for the
+// "jump" or "return" command that ends it). Returns 0 on success.
+static int32_t
+rsxgl_command_list_begin_segment(gcmContextData * context,command_list_t & list,const uint32_t count,uint32_t * offset)
+{
+  const uint32_t length = std::max((uint32_t)RSXGL_COMMAND_LIST_SEGMENT_LENGTH,count + 1);
+
+  uint32_t * segment = (uint32_t *)rsxgl_command_list_segment_allocate(length,offset);
+  if(segment == 0) {
+    return -1;
+  }
+
+  list.segments.push_back(segment);
+
+  context -> current = segment;
+  context -> end = segment + length - 1;
+
+  return 0;
+}
+
+// Called by gcm_reserve_wrap when the command buffer is being redirected into a command list:
+extern "C" int32_t
+rsxgl_command_list_reserve(gcmContextData * context,uint32_t count)
+{
+  rsxgl_context_t * ctx = current_ctx();
+  rsxgl_assert(ctx -> command_list != 0);
+
+  command_list_t & list = command_list_t::storage().at(ctx -> command_list);
+
+  uint32_t * jump = context -> current;
+  uint32_t offset = 0;
+  const int32_t r = rsxgl_command_list_begin_segment(context,list,count,&offset);
+  if(r == 0) {
+    gcm_emit_at(jump,0,gcm_jump_cmd(offset));
+  }
+  else {
+    __rsxgl_assert_func(__FILE__,__LINE__,__PRETTY_FUNCTION__,"failed to allocate command list segment");
+  }
+  return r;
+}
+
+// Hand segments that the GPU may still call over to an orphaned list, which
+// rsxgl_reclaim_orphans() destroys once timestamp has passed:
+static void
+rsxgl_command_list_orphan_segments(const uint32_t timestamp,const uint32_t offset,std::vector< void * > & segments)
+{
+  const command_list_t::name_type name = command_list_t::storage().create_name_and_object();
+  command_list_t & list = command_list_t::storage().at(name);
+  list.timestamp = timestamp;
+  list.offset = offset;
+  list.segments.swap(segments);
+  command_list_t::storage().orphan(name);
+}
+
+uint32_t *
+rsxgl_command_list_subroutine(const uint32_t length,const uint32_t timestamp,uint32_t * offset)
+{
+  uint32_t * segment = (uint32_t *)rsxgl_command_list_segment_allocate(length,offset);
+  if(segment == 0) {
+    return 0;
+  }
+
+  std::vector< void * > segments(1,segment);
+  rsxgl_command_list_orphan_segments(timestamp,*offset,segments);
+
+  return segment;
+}
+
+// Creating the orphan can move the storage that list lives in, so look it up again afterwards:
+static inline void
+rsxgl_command_list_clear(rsxgl_context_t * ctx,command_list_t & list)
+{
+  const uint32_t timestamp = list.timestamp, offset = list.offset;
+  std::vector< void * > segments;
+  segments.swap(list.segments);
+  list.timestamp = 0;
+  list.offset = 0;
+
+  if(rsxgl_timestamp_busy(ctx,timestamp)) {
+    rsxgl_command_list_orphan_segments(timestamp,offset,segments);
+  }
+  else {
+    for(void * segment : segments) {
+      rsxgl_command_list_segment_free(segment);
+    }
+  }
+}
+
+GLAPI void APIENTRY
+glGenCommandListsRSX(GLsizei n, GLuint * lists)
+{
+  if(n < 0) {
+    RSXGL_ERROR_(GL_INVALID_VALUE);
+  }
+
+  GLsizei count = command_list_t::storage().create_names(n,lists);
+
+  if(count != n) {
+    RSXGL_ERROR_(GL_OUT_OF_MEMORY);
+  }
+
+  RSXGL_NOERROR_();
+}
+
+GLAPI void APIENTRY
+glDeleteCommandListsRSX(GLsizei n, const GLuint * lists)
+{
+  if(n < 0) {
+    RSXGL_ERROR_(GL_INVALID_VALUE);
+  }
+
+  rsxgl_context_t * ctx = current_ctx();
+
+  for(GLsizei i = 0;i < n;++i,++lists) {
+    const GLuint list_name = *lists;
+
+    if(list_name == 0) continue;
+
+    if(list_name == ctx -> command_list) {
+      RSXGL_ERROR_(GL_INVALID_OPERATION);
+    }
+
+    if(command_list_t::storage().is_object(list_name)) {
+      // If the GPU may still call the list, it's destroyed later by rsxgl_reclaim_orphans():
+      if(rsxgl_timestamp_busy(ctx,command_list_t::storage().at(list_name).timestamp)) {
+	command_list_t::storage().orphan(list_name);
+      }
+      else {
+	command_list_t::storage().destroy(list_name);
+      }
+    }
+    else if(command_list_t::storage().is_name(list_name)) {
+      command_list_t::storage().destroy(list_name);
+    }
+  }
+
+  RSXGL_NOERROR_();
+}
+
+GLAPI GLboolean APIENTRY
+glIsCommandListRSX(GLuint list)
+{
+  return command_list_t::storage().is_object(list);
+}
+
+GLAPI void APIENTRY
+glNewCommandListRSX(GLuint list_name)
+{
+  if(list_name == 0 || !command_list_t::storage().is_name(list_name)) {
+    RSXGL_ERROR_(GL_INVALID_VALUE);
+  }
+
+  rsxgl_context_t * ctx = current_ctx();
+
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  if(!command_list_t::storage().is_object(list_name)) {
+    command_list_t::storage().create_object(list_name);
+  }
+
+  rsxgl_command_list_clear(ctx,command_list_t::storage().at(list_name));
+  command_list_t & list = command_list_t::storage().at(list_name);
+
+  gcmContextData * context = ctx -> gcm_context();
+
+  // Submit what's been queued so far:
+  rsxgl_flush(ctx);
+
+  uint32_t * current = context -> current, * end = context -> end;
+
+  if(rsxgl_command_list_begin_segment(context,list,0,&list.offset) != 0) {
+    RSXGL_ERROR_(GL_OUT_OF_MEMORY);
+  }
+
+  ctx -> command_list = list_name;
+  ctx -> command_list_saved_current = current;
+  ctx -> command_list_saved_end = end;
+
+  // The list can't make any assumptions about the state of the GPU when it's called:
+  rsxgl_invalidate(ctx);
+
+  RSXGL_NOERROR_();
+}
+
+GLAPI void APIENTRY
+glEndCommandListRSX(void)
+{
+  rsxgl_context_t * ctx = current_ctx();
+
+  if(ctx -> command_list == 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  gcmContextData * context = ctx -> gcm_context();
+
+  // There is always one word left at the end of a segment:
+  gcm_emit_at(context -> current,0,gcm_return_cmd());
+
+  context -> current = ctx -> command_list_saved_current;
+  context -> end = ctx -> command_list_saved_end;
+
+  ctx -> command_list = 0;
+  ctx -> command_list_saved_current = 0;
+  ctx -> command_list_saved_end = 0;
+
+  // State that was validated while recording hasn't actually been sent to the GPU:
+  rsxgl_invalidate(ctx);
+
+  RSXGL_NOERROR_();
+}
+
+GLAPI void APIENTRY
+glCallCommandListRSX(GLuint list_name)
+{
+  if(!command_list_t::storage().is_object(list_name)) {
+    RSXGL_ERROR_(GL_INVALID_VALUE);
+  }
+
+  rsxgl_context_t * ctx = current_ctx();
+
+  // The RSX can't nest calls:
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  command_list_t & list = command_list_t::storage().at(list_name);
+
+  if(list.segments.empty()) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  const uint32_t timestamp = rsxgl_timestamp_create(ctx);
+
+  gcmContextData * context = ctx -> gcm_context();
+
+  uint32_t * buffer = gcm_reserve(context,1);
+  gcm_emit_at(buffer,0,gcm_call_cmd(list.offset));
+  gcm_finish_n_commands(context,1);
+
+  list.timestamp = timestamp;
+
+  // The list leaves the GPU in whatever state it was recorded with:
+  rsxgl_invalidate(ctx);
+
+  rsxgl_flush_policy(ctx,1,0);
+
+  RSXGL_NOERROR_();
+}
@@ -0,0 +1,48 @@
+//-*-C++-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// command_list.h - Record validated command streams for later replay (GL_RSX_command_list).
+
+#ifndef rsxgl_command_list_H
+#define rsxgl_command_list_H
+
+#include "gl_object.h"
+#include "rsxgl_limits.h"
+
+#include <vector>
+
+// A command list is a chain of segments, allocated from a region of main memory that's mapped
+// for the RSX, that's invoked by a single "call" command. Each segment but the last ends with
+// a "jump" to the next one; the last segment ends with a "return".
+//
+// The commands that are recorded refer directly to the memory owned by buffers, textures, etc.,
+// at the time of recording. Modifying or deleting those objects while a list is in use gives
+// undefined results.
+//
+// Calls that wait for the GPU, or that need timestamps posted in order (glFinish, sync objects,
+// queries, eglSwapBuffers), give GL_INVALID_OPERATION while a list is being recorded.
+struct command_list_t {
+  typedef gl_object< command_list_t, RSXGL_MAX_COMMAND_LISTS > gl_object_type;
+  typedef typename gl_object_type::name_type name_type;
+  typedef typename gl_object_type::storage_type storage_type;
+
+  static storage_type & storage();
+
+  uint32_t timestamp;
+
+  // RSX offset of the first segment:
+  uint32_t offset;
+  std::vector< void * > segments;
+
+  command_list_t();
+  ~command_list_t();
+};
+
+// Allocate length words of command list memory for a subroutine that the GPU calls until
+// timestamp has passed. It's freed after that by rsxgl_reclaim_orphans(). Returns 0 if there's
+// no room for it.
+uint32_t * rsxgl_command_list_subroutine(const uint32_t length,const uint32_t timestamp,uint32_t * offset);
+
+#endif
@@ -0,0 +1,211 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// compact.cc - Defragment memory arenas by having the GPU move objects' storage to lower addresses.
+
+#include "rsxgl_context.h"
+#include "arena.h"
+#include "slab.h"
+#include "buffer.h"
+#include "textures.h"
+#include "framebuffer.h"
+#include "timestamp.h"
+
+#include <GL3/gl3.h>
+#include "GL3/rsxgl3ext.h"
+#include "error.h"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(GLAPI)
+#undef GLAPI
+#endif
+#define GLAPI extern "C"
+
+namespace {
+
+  enum rsxgl_compact_object_type {
+    RSXGL_COMPACT_BUFFER = 0,
+    RSXGL_COMPACT_TEXTURE = 1,
+    RSXGL_COMPACT_RENDERBUFFER = 2
+  };
+
+  struct compact_object_t {
+    uint32_t offset;
+    uint32_t type;
+    uint32_t name;
+
+    compact_object_t(const uint32_t _offset,const uint32_t _type,const uint32_t _name)
+      : offset(_offset), type(_type), name(_name) {
+    }
+
+    bool operator <(const compact_object_t & rhs) const {
+      return offset < rhs.offset;
+    }
+  };
+
+}
+
+// Give memory a new home in the arena if there's room for it at a lower address, and have the GPU
+// copy its contents there. Returns true if it moved. The old memory is added to retired - it can't
+// be freed until the GPU has copied from it, since the mspace keeps its bookkeeping in free memory:
+static bool
+rsxgl_compact_relocate(rsxgl_context_t * ctx,memory_arena_t & arena,memory_t & memory,std::vector< memory_t > & retired)
+{
+  void * address = rsxgl_arena_address(arena,memory);
+
+  // Small allocations are packed into slabs already:
+  if(arena.slabs != 0 && rsxgl_slab_owns(arena.slabs,address)) return false;
+
+  const rsx_size_t size = mspace_usable_size(address);
+
+  memory_t new_memory = rsxgl_arena_allocate(arena,128,size);
+  if(!new_memory) return false;
+
+  if(new_memory.offset >= memory.offset) {
+    rsxgl_arena_free(arena,new_memory);
+    return false;
+  }
+
+  rsxgl_memory_transfer(ctx -> gcm_context(),new_memory,size,1,memory,size,1,size,1);
+
+  retired.push_back(memory);
+
+  new_memory.owner = memory.owner;
+  memory = new_memory;
+
+  return true;
+}
+
+static bool
+rsxgl_framebuffer_attaches(const framebuffer_t & framebuffer,const uint32_t type,const uint32_t name)
+{
+  for(framebuffer_t::attachment_types_t::const_iterator it = framebuffer.attachment_types.begin();!it.done();it.next(framebuffer.attachment_types)) {
+    if(it.value() == type && framebuffer.attachments[it.index()] == name) return true;
+  }
+  return false;
+}
+
+GLAPI void APIENTRY
+glCompactMemoryArenaRSX(GLuint arena_name)
+{
+  if(!rsxgl_arena_is_object(arena_name)) {
+    RSXGL_ERROR_(GL_INVALID_VALUE);
+  }
+
+  rsxgl_context_t * ctx = current_ctx();
+
+  // Offsets recorded into a command list would go stale:
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  memory_arena_t & arena = memory_arena_t::storage().at(arena_name);
+
+  // An arena whose mspace couldn't be created has nothing to compact:
+  if(arena.space == 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  // Nothing may be moved while the GPU might still use it. Wait for it to finish, then free
+  // everything that was waiting on it:
+  rsxgl_timestamp_wait(ctx,rsxgl_timestamp_create(ctx));
+  rsxgl_buffer_reclaim_memory(ctx);
+  rsxgl_reclaim_orphans(ctx);
+
+  std::vector< compact_object_t > objects, moved;
+  std::vector< memory_t > retired;
+
+  // Memory given up by a pass is only freed once the GPU has copied from it, so the next pass can
+  // move objects into it:
+  bool again = true;
+  while(again) {
+    // Collect the storage that can be moved:
+    objects.clear();
+
+    for(buffer_t::name_type name = 1,n = buffer_t::storage().contents_size();name < n;++name) {
+      if(!gl_object_has_storage< buffer_t >(name)) continue;
+
+      const buffer_t & buffer = buffer_t::storage().at(name);
+      if(buffer.arena == arena_name && buffer.memory && !buffer.mapped) {
+	objects.push_back(compact_object_t(buffer.memory.offset,RSXGL_COMPACT_BUFFER,name));
+      }
+    }
+
+    for(texture_t::name_type name = 1,n = texture_t::storage().contents_size();name < n;++name) {
+      if(!gl_object_has_storage< texture_t >(name)) continue;
+
+      const texture_t & texture = texture_t::storage().at(name);
+      if(texture.arena == arena_name && texture.memory && texture.memory.owner) {
+	objects.push_back(compact_object_t(texture.memory.offset,RSXGL_COMPACT_TEXTURE,name));
+      }
+    }
+
+    for(renderbuffer_t::name_type name = 1,n = renderbuffer_t::storage().contents_size();name < n;++name) {
+      if(!gl_object_has_storage< renderbuffer_t >(name)) continue;
+
+      const renderbuffer_t & renderbuffer = renderbuffer_t::storage().at(name);
+      if(renderbuffer.arena == arena_name && renderbuffer.surface.memory) {
+	objects.push_back(compact_object_t(renderbuffer.surface.memory.offset,RSXGL_COMPACT_RENDERBUFFER,name));
+      }
+    }
+
+    // Move the lowest objects first, so that they take the lowest free space:
+    std::sort(objects.begin(),objects.end());
+
+    for(std::vector< compact_object_t >::const_iterator it = objects.begin(),it_end = objects.end();it != it_end;++it) {
+      if(it -> type == RSXGL_COMPACT_BUFFER) {
+	buffer_t & buffer = buffer_t::storage().at(it -> name);
+	if(rsxgl_compact_relocate(ctx,arena,buffer.memory,retired)) {
+	  buffer.invalid = 0;
+	  rsxgl_buffer_invalidate_range(buffer,0,buffer.size);
+	  rsxgl_buffer_invalidate_attribs(ctx,it -> name);
+	  moved.push_back(*it);
+	}
+      }
+      else if(it -> type == RSXGL_COMPACT_TEXTURE) {
+	texture_t & texture = texture_t::storage().at(it -> name);
+	if(rsxgl_compact_relocate(ctx,arena,texture.memory,retired)) {
+	  ctx -> invalid_textures |= texture.binding_bitfield;
+	  ctx -> invalid.parts.texture_cache = 1;
+	  moved.push_back(*it);
+	}
+      }
+      else if(it -> type == RSXGL_COMPACT_RENDERBUFFER) {
+	renderbuffer_t & renderbuffer = renderbuffer_t::storage().at(it -> name);
+	if(rsxgl_compact_relocate(ctx,arena,renderbuffer.surface.memory,retired)) {
+	  moved.push_back(*it);
+	}
+      }
+    }
+
+    again = !retired.empty();
+    if(again) {
+      rsxgl_timestamp_wait(ctx,rsxgl_timestamp_create(ctx));
+
+      for(std::vector< memory_t >::const_iterator it = retired.begin(),it_end = retired.end();it != it_end;++it) {
+	rsxgl_arena_free(arena,*it);
+      }
+      retired.clear();
+    }
+  }
+
+  // Framebuffers keep their own copies of their attachments' surfaces:
+  for(framebuffer_t::name_type name = 1,n = framebuffer_t::storage().contents_size();name < n;++name) {
+    if(!gl_object_has_storage< framebuffer_t >(name)) continue;
+
+    framebuffer_t & framebuffer = framebuffer_t::storage().at(name);
+
+    for(std::vector< compact_object_t >::const_iterator it = moved.begin(),it_end = moved.end();it != it_end;++it) {
+      if((it -> type == RSXGL_COMPACT_TEXTURE && rsxgl_framebuffer_attaches(framebuffer,RSXGL_ATTACHMENT_TYPE_TEXTURE,it -> name)) ||
+	 (it -> type == RSXGL_COMPACT_RENDERBUFFER && rsxgl_framebuffer_attaches(framebuffer,RSXGL_ATTACHMENT_TYPE_RENDERBUFFER,it -> name))) {
+	rsxgl_framebuffer_invalidate(ctx,name,framebuffer);
+	break;
+      }
+    }
+  }
+
+  RSXGL_NOERROR_();
+}
@@ -26,10 +26,13 @@
 #include "debug.h"
 #include "rsxgl_assert.h"
 #include "migrate.h"
+#include "client_arrays.h"
+#include "command_list.h"
 
 #include <string.h>
 #include <boost/integer/static_log2.hpp>
 #include <algorithm>
+#include <numeric>
 
 #if defined(GLAPI)
 #undef GLAPI
@@ -131,6 +134,11 @@ rsxgl_check_draw_arrays(rsxgl_context_t * ctx,GLenum mode)
   rsxgl_check_unmapped_arrays(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].attribs_enabled);
   RSXGL_FORWARD_ERROR(~0);
 
+  // Client-side vertex arrays are copied into memory that's recycled, so they can't be recorded into a command list:
+  if(ctx -> command_list != 0 && rsxgl_attribs_client_arrays(ctx)) {
+    RSXGL_ERROR(GL_INVALID_OPERATION,~0U);
+  }
+
   // Check for compatibility with transform feedback settings:
   rsxgl_check_transform_feedback(ctx,rsx_primitive_type);
   RSXGL_FORWARD_ERROR(~0);
@@ -159,6 +167,11 @@ rsxgl_check_draw_elements(rsxgl_context_t * ctx,GLenum mode,GLenum type)
   rsxgl_check_unmapped_arrays(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].attribs_enabled);
   RSXGL_FORWARD_ERROR(std::make_pair(~0U, RSXGL_MAX_ELEMENT_TYPES));
 
+  // Client-side indices and vertex arrays are copied into memory that's recycled, so they can't be recorded into a command list:
+  if(ctx -> command_list != 0 && (ctx -> buffer_binding.names[RSXGL_ELEMENT_ARRAY_BUFFER] == 0 || rsxgl_attribs_client_arrays(ctx))) {
+    RSXGL_ERROR(GL_INVALID_OPERATION,std::make_pair(~0U,RSXGL_MAX_ELEMENT_TYPES));
+  }
+
   // Check for compatibility with transform feedback settings:
   rsxgl_check_transform_feedback(ctx,rsx_primitive_type);
   RSXGL_FORWARD_ERROR(std::make_pair(~0U, RSXGL_MAX_ELEMENT_TYPES));
@@ -349,11 +362,12 @@ struct rsxgl_draw_array_operations {
   static const uint32_t batch_size = primitive_traits_type::batch_size;
   static const uint32_t repeat_offset = primitive_traits_type::repeat_offset;
   
+  mutable gcmContextData * context;
   mutable uint32_t * buffer;
   mutable uint32_t first, current;
   
   rsxgl_draw_array_operations(const uint32_t first)
-    : buffer(0), first(first), current(0) {
+    : context(0), buffer(0), first(first), current(0) {
   }
 
   static inline rsxgl_process_batch_work_t
@@ -365,7 +379,7 @@ struct rsxgl_draw_array_operations {
   count(const uint32_t ninvoc,const uint32_t ninvocremainder,const uint32_t nbatchremainder) {
     const uint32_t nmethods = 1 + ninvoc + (ninvocremainder ? 1 : 0);
     const uint32_t nargs = 1 + (ninvoc * RSXGL_VERTEX_BATCH_MAX_FIFO_METHOD_ARGS) + ninvocremainder;
-    const uint32_t nwords = nmethods + nargs + 4 + 6;
+    const uint32_t nwords = nmethods + nargs + 4;
 
     return nwords;
   }
@@ -373,30 +387,26 @@ struct rsxgl_draw_array_operations {
   // ninvoc - number of full draw method invocations (2047 * 256 vertices)
   // ninvocremainder - number of vertex batches for an additional draw method invocation (ninvocremainder * 256 vertices)
   // nbatchremainder - size of one additional vertex batch (nbatchremainder vertices)
+  // Each group is reserved separately, so that a draw of any size fits in the command ring:
   inline void
-  begin(gcmContextData * context,const uint32_t ninvoc,const uint32_t ninvocremainder,const uint32_t nbatchremainder) const {
-    buffer = gcm_reserve(context,count(ninvoc,ninvocremainder,nbatchremainder));
+  begin(gcmContextData * _context,const uint32_t ninvoc,const uint32_t ninvocremainder,const uint32_t nbatchremainder) const {
+    context = _context;
+    buffer = gcm_reserve(context,2);
 
     current = 0;
 
-    gcm_emit_method_at(buffer,0,NV40_3D_VTX_CACHE_INVALIDATE,1);
-    gcm_emit_at(buffer,1,0);
-    
-    gcm_emit_method_at(buffer,2,NV40_3D_VTX_CACHE_INVALIDATE,1);
-    gcm_emit_at(buffer,3,0);
-    
-    gcm_emit_method_at(buffer,4,NV40_3D_VTX_CACHE_INVALIDATE,1);
-    gcm_emit_at(buffer,5,0);
-    
-    gcm_emit_method_at(buffer,6,NV30_3D_VERTEX_BEGIN_END,1);
-    gcm_emit_at(buffer,7,rsx_primitive_type);
+    // The vertex cache was invalidated by rsxgl_attribs_validate, if it needed to be:
+    gcm_emit_method_at(buffer,0,NV30_3D_VERTEX_BEGIN_END,1);
+    gcm_emit_at(buffer,1,rsx_primitive_type);
 
-    buffer += 8;
+    buffer += 2;
   }
   
   // n is number of arguments to this method:
   inline void
   begin_group(const uint32_t n) const {
+    gcm_finish_commands(context,&buffer);
+    buffer = gcm_reserve(context,n + 1);
     gcm_emit_method_at(buffer,0,NV30_3D_VB_VERTEX_BATCH,n);
     ++buffer;
   }
@@ -423,6 +433,8 @@ struct rsxgl_draw_array_operations {
   
   inline void
   end() const {
+    gcm_finish_commands(context,&buffer);
+    buffer = gcm_reserve(context,2);
     gcm_emit_method_at(buffer,0,NV30_3D_VERTEX_BEGIN_END,1);
     gcm_emit_at(buffer,1,NV30_3D_VERTEX_BEGIN_END_STOP);
     
@@ -440,11 +452,12 @@ struct rsxgl_draw_array_elements_operations {
   static const uint32_t batch_size = primitive_traits_type::batch_size;
   static const uint32_t repeat_offset = primitive_traits_type::repeat_offset;
   
+  mutable gcmContextData * context;
   mutable uint32_t * buffer;
   mutable uint32_t current;
   
   rsxgl_draw_array_elements_operations()
-    : buffer(0), current(0) {
+    : context(0), buffer(0), current(0) {
   }
 
   static inline rsxgl_process_batch_work_t
@@ -461,9 +474,11 @@ struct rsxgl_draw_array_elements_operations {
     return nwords;
   }
   
+  // Each group is reserved separately, so that a draw of any size fits in the command ring:
   inline void
-  begin(gcmContextData * context,const uint32_t ninvoc,const uint32_t ninvocremainder,const uint32_t nbatchremainder) const {
-    buffer = gcm_reserve(context,count(ninvoc,ninvocremainder,nbatchremainder));
+  begin(gcmContextData * _context,const uint32_t ninvoc,const uint32_t ninvocremainder,const uint32_t nbatchremainder) const {
+    context = _context;
+    buffer = gcm_reserve(context,2);
 
     gcm_emit_method_at(buffer,0,NV30_3D_VERTEX_BEGIN_END,1);
     gcm_emit_at(buffer,1,rsx_primitive_type);
@@ -474,6 +489,8 @@ struct rsxgl_draw_array_elements_operations {
   // n is number of arguments to this method:
   inline void
   begin_group(const uint32_t n) const {
+    gcm_finish_commands(context,&buffer);
+    buffer = gcm_reserve(context,n + 1);
     gcm_emit_method_at(buffer,0,NV30_3D_VB_INDEX_BATCH,n);
     ++buffer;
   }
@@ -500,6 +517,8 @@ struct rsxgl_draw_array_elements_operations {
   
   inline void
   end() const {
+    gcm_finish_commands(context,&buffer);
+    buffer = gcm_reserve(context,2);
     gcm_emit_method_at(buffer,0,NV30_3D_VERTEX_BEGIN_END,1);
     gcm_emit_at(buffer,1,NV30_3D_VERTEX_BEGIN_END_STOP);
     
@@ -528,7 +547,7 @@ namespace {
   };
 
   template< typename ElementRangePolicy, typename IterationPolicy, typename DrawPolicy >
-  void rsxgl_draw(rsxgl_context_t * ctx,const ElementRangePolicy & elementRangePolicy,const IterationPolicy & iterationPolicy,const DrawPolicy & drawPolicy)
+  void rsxgl_draw(rsxgl_context_t * ctx,const ElementRangePolicy & elementRangePolicy,const IterationPolicy & iterationPolicy,const DrawPolicy & drawPolicy,const uint32_t vertexCount)
   {
 #if 0
     rsxgl_debug_printf("%s\n",__PRETTY_FUNCTION__);
@@ -540,29 +559,36 @@ namespace {
     // Iteration:
     typename IterationPolicy::iterator it = iterationPolicy.begin(), it_end = iterationPolicy.end();
 
-    // Timestamps, determined by the number of iterations:
-    const size_t timestampCount = it_end - it;
-    uint32_t timestamp = rsxgl_timestamp_create(ctx,timestampCount);
-    const uint32_t lastTimestamp = timestamp + timestampCount - 1;
+    const size_t drawCount = it_end - it;
+
+    // Every object that this draw call uses is tagged with the timestamp that the next flush posts:
+    const uint32_t timestamp = rsxgl_timestamp_create(ctx);
 
     // Validate state:
-    rsxgl_draw_framebuffer_validate(ctx,lastTimestamp);
+    rsxgl_draw_framebuffer_validate(ctx,timestamp);
     rsxgl_state_validate(ctx);
-    rsxgl_program_validate(ctx,lastTimestamp);
-    rsxgl_attribs_validate(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM],index_range.first,index_range.second,lastTimestamp);
+    rsxgl_program_validate(ctx,timestamp);
+    if(!rsxgl_attribs_validate(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM],index_range.first,index_range.second,timestamp)) {
+      RSXGL_ERROR_(GL_OUT_OF_MEMORY);
+    }
     rsxgl_uniforms_validate(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM]);
-    rsxgl_textures_validate(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM],lastTimestamp);
+    rsxgl_textures_validate(ctx,ctx -> program_binding[RSXGL_ACTIVE_PROGRAM],timestamp);
 
     // Draw functions:
     gcmContextData * gcm_context = ctx -> gcm_context();
 
     if(!ctx -> state.enable.rasterizer_discard) {
-      drawPolicy.begin(gcm_context,timestamp);
-      for(;it != it_end;++it,++timestamp) {
+      // There wasn't room to copy client-side indices:
+      if(!drawPolicy.begin(gcm_context,timestamp)) {
+	RSXGL_ERROR_(GL_OUT_OF_MEMORY);
+      }
+
+      for(;it != it_end;++it) {
 	drawPolicy.draw(gcm_context,timestamp,it);
-	rsxgl_timestamp_post(ctx,timestamp);
       }
       drawPolicy.end(gcm_context,timestamp);
+
+      rsxgl_draw_framebuffer_written(ctx);
     }
 
     // Transform feedback:
@@ -575,91 +601,44 @@ namespace {
 
 	const uint32_t vertexid_index = ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].streamvp_vertexid_index;
 
-	rsxgl_feedback_framebuffer_validate(ctx,0,count,lastTimestamp);
+	rsxgl_feedback_framebuffer_validate(ctx,0,count,timestamp);
+
+	register_cache_t & registers = ctx -> registers;
 
 	// set feedback "viewport":
 	{
-	  uint32_t * buffer = gcm_reserve(gcm_context,17);
-
-	  gcm_emit_method(&buffer,NV30_3D_VIEWPORT_HORIZ,2);
-	  gcm_emit(&buffer,((uint32_t)w << 16));
-	  gcm_emit(&buffer,((uint32_t)h << 16));
-	  
-	  gcm_emit_method(&buffer,NV30_3D_DEPTH_RANGE_NEAR,2);
-	  gcm_emit(&buffer,_ieee32_t(0.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(1.0f).u);
-	  
-	  gcm_emit_method(&buffer,NV30_3D_VIEWPORT_TRANSLATE,8);
-	  gcm_emit(&buffer,_ieee32_t(0.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(0.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(0.5f).u);
-	  gcm_emit(&buffer,_ieee32_t(0.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(1.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(1.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(0.0f).u);
-	  gcm_emit(&buffer,_ieee32_t(0.0f).u);
-	  
-	  gcm_emit_method(&buffer,NV30_3D_DEPTH_CONTROL,1);
-	  gcm_emit(&buffer,((uint32_t)0));
-	  
-	  gcm_finish_commands(gcm_context,&buffer);
-	}
+	  const uint32_t viewport[2] = { ((uint32_t)w << 16), ((uint32_t)h << 16) };
+	  rsxgl_emit_registers(gcm_context,registers,NV30_3D_VIEWPORT_HORIZ,2,viewport);
 
-	// disable depth test:
-	{
-	  uint32_t * buffer = gcm_reserve(gcm_context,2);
+	  const uint32_t depth_range[2] = { _ieee32_t(0.0f).u, _ieee32_t(1.0f).u };
+	  rsxgl_emit_registers(gcm_context,registers,NV30_3D_DEPTH_RANGE_NEAR,2,depth_range);
+
+	  const uint32_t translate_scale[8] = {
+	    _ieee32_t(0.0f).u, _ieee32_t(0.0f).u, _ieee32_t(0.5f).u, _ieee32_t(0.0f).u,
+	    _ieee32_t(1.0f).u, _ieee32_t(1.0f).u, _ieee32_t(0.0f).u, _ieee32_t(0.0f).u
+	  };
+	  rsxgl_emit_registers(gcm_context,registers,NV30_3D_VIEWPORT_TRANSLATE,8,translate_scale);
 
-	  gcm_emit_method_at(buffer,0,NV30_3D_DEPTH_TEST_ENABLE,1);
-	  gcm_emit_at(buffer,1,0);
-	  
-	  gcm_finish_n_commands(gcm_context,2);
+	  rsxgl_emit_register(gcm_context,registers,NV30_3D_DEPTH_CONTROL,0);
 	}
 
+	// disable depth test:
+	rsxgl_emit_register(gcm_context,registers,NV30_3D_DEPTH_TEST_ENABLE,0);
+
 	// point size:
-	{
-	  uint32_t * buffer = gcm_reserve(gcm_context,2);
-	  
-	  gcm_emit_method_at(buffer,0,NV30_3D_POINT_SIZE,1);
-	  gcm_emit_at(buffer,1,_ieee32_t(1.0f).u);
-	  
-	  gcm_finish_n_commands(gcm_context,2);
-	}
+	rsxgl_emit_register(gcm_context,registers,NV30_3D_POINT_SIZE,_ieee32_t(1.0f).u);
 
-	rsxgl_feedback_program_validate(ctx,lastTimestamp);
+	rsxgl_feedback_program_validate(ctx,timestamp);
 
-	// invalidate vertex cache
-	{
-	  uint32_t * buffer = gcm_reserve(gcm_context,8);
-    
-	  gcm_emit_method_at(buffer,0,0x1710,1);
-	  gcm_emit_at(buffer,1,0);
-
-	  gcm_emit_method_at(buffer,2,NV40_3D_VTX_CACHE_INVALIDATE,1);
-	  gcm_emit_at(buffer,3,0);
-	  
-	  gcm_emit_method_at(buffer,4,NV40_3D_VTX_CACHE_INVALIDATE,1);
-	  gcm_emit_at(buffer,5,0);
-	  
-	  gcm_emit_method_at(buffer,6,NV40_3D_VTX_CACHE_INVALIDATE,1);
-	  gcm_emit_at(buffer,7,0);
-	  
-	  gcm_finish_n_commands(gcm_context,8);
-	}
+	// invalidate vertex cache, if anything that's read has been written since the draw above:
+	rsxgl_vertex_cache_validate(ctx);
 
 	// disable buffer reads for the vertexid_index
-	{
-	  uint32_t * buffer = gcm_reserve(gcm_context,4);
-
-	  gcm_emit_method_at(buffer,0,NV30_3D_VTXBUF(vertexid_index),1);
-	  gcm_emit_at(buffer,1,0);
-	  gcm_emit_method_at(buffer,2,NV30_3D_VTXFMT(vertexid_index),1);
-	  gcm_emit_at(buffer,3,
-		      0 |
-		      0 |
-		      ((uint32_t)RSXGL_VERTEX_S16_UN & 0x7));
-	  
-	  gcm_finish_n_commands(gcm_context,4);
-	}
+	rsxgl_emit_register(gcm_context,registers,NV30_3D_VTXBUF(vertexid_index),0);
+	rsxgl_emit_register(gcm_context,registers,NV30_3D_VTXFMT(vertexid_index),
+			    0 |
+			    0 |
+			    ((uint32_t)RSXGL_VERTEX_S16_UN & 0x7));
 
 	// Draw this stuff:
 	{
@@ -707,6 +686,9 @@ namespace {
 	  gcm_finish_n_commands(gcm_context,ncommands);
 	}
 	
+	// The vertices above changed the current value of the vertexid_index attribute:
+	registers.invalidate(NV30_3D_VTX_ATTR_4F(vertexid_index),4);
+
 	// For the next draw invocation:
 	ctx -> invalid.parts.draw_framebuffer = 1;
 	ctx -> state.invalid.parts.draw_framebuffer = 1;
@@ -716,21 +698,136 @@ namespace {
 	ctx -> invalid_attribs.set(vertexid_index);
       }
     }
-  }
 
-  struct ignore_element_range_policy {
-    std::pair< uint32_t, uint32_t > range() const {
-      return std::pair< uint32_t, uint32_t >(0,0);
-    }
-  };
+    // Kick the command buffer if enough work has piled up:
+    rsxgl_flush_policy(ctx,drawCount,vertexCount);
+  }
 
   struct start_end_element_range_policy {
     const GLuint start, end;
+    const GLint basevertex;
     
-    start_end_element_range_policy(GLuint _start,GLuint _end) : start(_start), end(_end) {}
+    start_end_element_range_policy(GLuint _start,GLuint _end,GLint _basevertex = 0) : start(_start), end(_end), basevertex(_basevertex) {}
     
+    // end is inclusive:
     std::pair< uint32_t, uint32_t > range() const {
-      return std::pair< uint32_t, uint32_t >(start,end - start);
+      return std::pair< uint32_t, uint32_t >(start + basevertex,end - start + 1);
+    }
+  };
+
+  template< typename Index >
+  void rsxgl_scan_indices(const Index * indices,GLsizei count,const bool restart,const uint32_t restart_index,uint32_t & min_index,uint32_t & max_index)
+  {
+    for(;count > 0;--count,++indices) {
+      const uint32_t index = *indices;
+      if(restart && index == restart_index) continue;
+      min_index = std::min(min_index,index);
+      max_index = std::max(max_index,index);
+    }
+  }
+
+  // Element draws only need to know which vertices they use when client-side vertex arrays have
+  // to be copied to the GPU; the indices are read to find out:
+  struct scan_element_range_policy {
+    rsxgl_context_t * ctx;
+    const uint32_t rsx_element_type;
+    const GLsizei * count;
+    const GLvoid * const * indices;
+    const GLsizei primcount;
+    const GLint * basevertex;
+
+    scan_element_range_policy(rsxgl_context_t * _ctx,uint32_t _rsx_element_type,const GLsizei * _count,const GLvoid * const * _indices,GLsizei _primcount,const GLint * _basevertex = 0)
+      : ctx(_ctx), rsx_element_type(_rsx_element_type), count(_count), indices(_indices), primcount(_primcount), basevertex(_basevertex) {}
+
+    std::pair< uint32_t, uint32_t > range() const {
+      if(!rsxgl_attribs_client_arrays(ctx)) {
+	return std::pair< uint32_t, uint32_t >(0,0);
+      }
+
+      const bool restart = ctx -> state.enable.primitive_restart;
+      const uint32_t restart_index = ctx -> state.primitiveRestartIndex;
+
+      // Indices in a buffer are read from RSX memory, once the GPU has finished writing to it. The
+      // last few ranges that were found are kept with the buffer, so that redrawing the same
+      // indices doesn't read them again:
+      buffer_t * index_buffer = 0;
+      const uint8_t * base = 0;
+      if(ctx -> buffer_binding.names[RSXGL_ELEMENT_ARRAY_BUFFER] != 0) {
+	index_buffer = &ctx -> buffer_binding[RSXGL_ELEMENT_ARRAY_BUFFER];
+	if(!index_buffer -> memory) {
+	  return std::pair< uint32_t, uint32_t >(0,0);
+	}
+      }
+
+      int64_t start = std::numeric_limits< int64_t >::max(), end = std::numeric_limits< int64_t >::min();
+
+      for(GLsizei i = 0;i < primcount;++i) {
+	uint32_t min_index = std::numeric_limits< uint32_t >::max(), max_index = 0;
+
+	const buffer_element_range_t * cached = 0;
+	for(size_t j = 0;index_buffer != 0 && cached == 0 && j < RSXGL_BUFFER_ELEMENT_RANGES;++j) {
+	  const buffer_element_range_t & element_range = index_buffer -> element_ranges[j];
+	  if(element_range.valid &&
+	     element_range.offset == (uintptr_t)indices[i] && element_range.count == (rsx_size_t)count[i] &&
+	     element_range.type == rsx_element_type && element_range.restart == restart &&
+	     (!restart || element_range.restart_index == restart_index)) {
+	    cached = &element_range;
+	  }
+	}
+
+	if(cached != 0) {
+	  min_index = cached -> min;
+	  max_index = cached -> max;
+	}
+	else {
+	  // Draws that only read the buffer can carry on:
+	  if(index_buffer != 0 && base == 0) {
+	    if(rsxgl_timestamp_busy(ctx,index_buffer -> write_timestamp)) {
+	      rsxgl_timestamp_wait(ctx,index_buffer -> write_timestamp);
+	    }
+	    base = (const uint8_t *)rsxgl_arena_address(memory_arena_t::storage().at(index_buffer -> arena),index_buffer -> memory);
+	  }
+
+	  const uint8_t * p = base + (uintptr_t)indices[i];
+
+	  if(rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_INT) {
+	    rsxgl_scan_indices((const uint32_t *)p,count[i],restart,restart_index,min_index,max_index);
+	  }
+	  else if(rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_SHORT) {
+	    rsxgl_scan_indices((const uint16_t *)p,count[i],restart,restart_index,min_index,max_index);
+	  }
+	  else if(rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_BYTE) {
+	    rsxgl_scan_indices((const uint8_t *)p,count[i],restart,restart_index,min_index,max_index);
+	  }
+
+	  if(index_buffer != 0) {
+	    buffer_element_range_t & element_range = index_buffer -> element_ranges[index_buffer -> element_range_next];
+	    index_buffer -> element_range_next = (index_buffer -> element_range_next + 1) % RSXGL_BUFFER_ELEMENT_RANGES;
+
+	    element_range.valid = 1;
+	    element_range.offset = (uintptr_t)indices[i];
+	    element_range.count = count[i];
+	    element_range.type = rsx_element_type;
+	    element_range.restart = restart;
+	    element_range.restart_index = restart_index;
+	    element_range.min = min_index;
+	    element_range.max = max_index;
+	  }
+	}
+
+	if(min_index > max_index) continue;
+
+	const int64_t offset = (basevertex != 0) ? basevertex[i] : 0;
+	start = std::min(start,(int64_t)min_index + offset);
+	end = std::max(end,(int64_t)max_index + offset + 1);
+      }
+
+      if(start >= end) {
+	return std::pair< uint32_t, uint32_t >(0,0);
+      }
+
+      start = std::max(start,(int64_t)0);
+      return std::pair< uint32_t, uint32_t >((uint32_t)start,(uint32_t)(end - start));
     }
   };
 
@@ -835,6 +932,52 @@ namespace {
     }
   };
 
+  // Command buffer words needed to send count indices inline - 16-bit (and 8-bit) indices are
+  // packed two to a word:
+  inline uint32_t
+  rsxgl_inline_elements_words(const uint32_t rsx_element_type,const uint32_t count)
+  {
+    const uint32_t npacked = (rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_INT) ? 0 : (count >> 1), nsingle = count - (npacked << 1);
+    return 4 +
+      npacked + ((npacked + GCM_MAX_METHOD_ARGS - 1) / GCM_MAX_METHOD_ARGS) +
+      nsingle + ((nsingle + GCM_MAX_METHOD_ARGS - 1) / GCM_MAX_METHOD_ARGS);
+  }
+
+  template< typename Index >
+  void rsxgl_emit_inline_elements(gcmContextData * context,const uint32_t rsx_primitive_type,const uint32_t rsx_element_type,const Index * indices,const uint32_t count)
+  {
+    const uint32_t npacked = (sizeof(Index) < sizeof(uint32_t)) ? (count >> 1) : 0, nsingle = count - (npacked << 1);
+
+    uint32_t * buffer = gcm_reserve(context,rsxgl_inline_elements_words(rsx_element_type,count));
+
+    gcm_emit_method(&buffer,NV30_3D_VERTEX_BEGIN_END,1);
+    gcm_emit(&buffer,rsx_primitive_type);
+
+    for(uint32_t remaining = npacked;remaining > 0;) {
+      const uint32_t n = std::min(remaining,(uint32_t)GCM_MAX_METHOD_ARGS);
+      gcm_emit_method_noninc(&buffer,NV30_3D_VB_ELEMENT_U16,n);
+      for(uint32_t i = 0;i < n;++i,indices += 2) {
+	gcm_emit(&buffer,((uint32_t)indices[0] << NV30_3D_VB_ELEMENT_U16_0__SHIFT) | ((uint32_t)indices[1] << NV30_3D_VB_ELEMENT_U16_1__SHIFT));
+      }
+      remaining -= n;
+    }
+
+    // 32-bit indices, or the odd one left over:
+    for(uint32_t remaining = nsingle;remaining > 0;) {
+      const uint32_t n = std::min(remaining,(uint32_t)GCM_MAX_METHOD_ARGS);
+      gcm_emit_method_noninc(&buffer,NV30_3D_VB_ELEMENT_U32,n);
+      for(uint32_t i = 0;i < n;++i,++indices) {
+	gcm_emit(&buffer,(uint32_t)*indices);
+      }
+      remaining -= n;
+    }
+
+    gcm_emit_method(&buffer,NV30_3D_VERTEX_BEGIN_END,1);
+    gcm_emit(&buffer,NV30_3D_VERTEX_BEGIN_END_STOP);
+
+    gcm_finish_commands(context,&buffer);
+  }
+
   struct element_draw_policy {
     rsxgl_context_t * ctx;
     const uint32_t rsx_primitive_type, rsx_element_type;
@@ -845,14 +988,19 @@ namespace {
       : ctx(_ctx), rsx_primitive_type(_rsx_primitive_type), rsx_element_type(_rsx_element_type),
 
 	client_indices(ctx -> buffer_binding.names[RSXGL_ELEMENT_ARRAY_BUFFER] == 0),
-	migrate_buffer(0), migrate_buffer_size(0) {}
+	migrate_buffer(0), migrate_buffer_size(0), inline_indices(false) {}
 
   protected:
     mutable void * migrate_buffer;
     mutable uint32_t migrate_buffer_size;
     mutable uint32_t index_buffer_offset, index_buffer_location;
 
-    void begin(gcmContextData * context,uint32_t timestamp,const GLsizei * count,const GLvoid * const* indices,GLsizei primcount,uint32_t * offsets) const {
+    // Client-side indices are written straight into the command buffer:
+    mutable bool inline_indices;
+
+    // Policies that draw with emitElements can have small client-side index arrays sent inline.
+    // Returns false if client-side indices couldn't be copied to RSX memory:
+    bool begin(gcmContextData * context,uint32_t timestamp,const GLsizei * count,const GLvoid * const* indices,GLsizei primcount,uint32_t * offsets,const bool allow_inline = false) const {
       static const uint8_t rsxgl_element_type_bytes[RSXGL_MAX_ELEMENT_TYPES] = {
 	sizeof(uint32_t),
 	sizeof(uint16_t),
@@ -861,12 +1009,44 @@ namespace {
 
       index_buffer_offset = 0;
       index_buffer_location = 0;
-      
+      inline_indices = false;
+
+      // GL_RSX_mapped_client_arrays - fetch client-side indices where they are, if the GPU can
+      // reach all of them in the same location:
+      bool mapped = client_indices && ctx -> state.enable.mapped_client_arrays;
+      for(GLsizei i = 0;mapped && i < primcount;++i) {
+	uint32_t location = 0;
+	mapped = rsxgl_client_array_mapped(indices[i],offsets[i],location) && (i == 0 || location == index_buffer_location);
+	index_buffer_location = location;
+      }
+
+      // Sending a few indices inline costs less than allocating space for them, copying them, and
+      // having the GPU signal when it's done with that space:
+      if(!mapped && client_indices && allow_inline) {
+	uint32_t nwords = 0;
+	for(GLsizei i = 0;i < primcount && nwords <= RSXGL_INLINE_INDEX_MAX_WORDS;++i) {
+	  nwords += rsxgl_inline_elements_words(rsx_element_type,count[i]);
+	}
+	inline_indices = nwords <= RSXGL_INLINE_INDEX_MAX_WORDS;
+      }
+
+      if(mapped || inline_indices) {
+	migrate_buffer = 0;
+
+	// The application may have changed mapped indices since the GPU last read them:
+	if(mapped) ctx -> invalid.parts.vertex_cache = 1;
+      }
       // Migrate client-side index array to RSX:
-      if(client_indices) {
+      else if(client_indices) {
 	migrate_buffer_size = (uint32_t)rsxgl_element_type_bytes[rsx_element_type] * std::accumulate(count,count + primcount,0);
 	migrate_buffer = rsxgl_vertex_migrate_memalign(context,16,migrate_buffer_size);
 
+	// Cached client-side vertex arrays may be holding the space:
+	if(migrate_buffer == 0 && rsxgl_client_arrays_release(context)) {
+	  migrate_buffer = rsxgl_vertex_migrate_memalign(context,16,migrate_buffer_size);
+	}
+	if(migrate_buffer == 0) return false;
+
 	uint8_t * pmigrate_buffer = (uint8_t *)migrate_buffer;
 	uint32_t offset = 0;
 	for(GLsizei i = 0;i < primcount;++i) {
@@ -884,6 +1064,9 @@ namespace {
 	rsxgl_assert(s == 0);
 	
 	index_buffer_location = RSXGL_VERTEX_MIGRATE_BUFFER_LOCATION;
+
+	// The vertex cache may hold whatever was at that memory before:
+	ctx -> invalid.parts.vertex_cache = 1;
       }
       // Validate the RSX buffer:
       else {
@@ -900,12 +1083,18 @@ namespace {
 	  ++offsets;
 	}
 
-	rsxgl_buffer_validate(ctx,ctx -> buffer_binding[RSXGL_ELEMENT_ARRAY_BUFFER],start,end - start,timestamp + primcount - 1);
+	rsxgl_buffer_validate(ctx,ctx -> buffer_binding[RSXGL_ELEMENT_ARRAY_BUFFER],start,end - start,timestamp);
 	
 	const buffer_t & index_buffer = ctx -> buffer_binding[RSXGL_ELEMENT_ARRAY_BUFFER];
 	index_buffer_offset = index_buffer.memory.offset;
 	index_buffer_location = index_buffer.memory.location;
       }
+
+      // Indices are validated after the attributes are, so check the vertex cache again before
+      // any of them are drawn:
+      rsxgl_vertex_cache_validate(ctx);
+
+      return true;
     }
 
     void emitIndexBufferCommands(gcmContextData * gcm_context,uint32_t offset) const {
@@ -927,6 +1116,28 @@ namespace {
       gcm_finish_n_commands(gcm_context,3);
     }
 
+    void emitInlineDrawCommands(gcmContextData * gcm_context,const GLvoid * indices,uint32_t count) const {
+      if(rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_INT) {
+	rsxgl_emit_inline_elements(gcm_context,rsx_primitive_type,rsx_element_type,(const uint32_t *)indices,count);
+      }
+      else if(rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_SHORT) {
+	rsxgl_emit_inline_elements(gcm_context,rsx_primitive_type,rsx_element_type,(const uint16_t *)indices,count);
+      }
+      else if(rsx_element_type == RSXGL_ELEMENT_TYPE_UNSIGNED_BYTE) {
+	rsxgl_emit_inline_elements(gcm_context,rsx_primitive_type,rsx_element_type,(const uint8_t *)indices,count);
+      }
+    }
+
+    void emitElements(gcmContextData * gcm_context,uint32_t offset,const GLvoid * indices,uint32_t count) const {
+      if(inline_indices) {
+	emitInlineDrawCommands(gcm_context,indices,count);
+      }
+      else {
+	emitIndexBufferCommands(gcm_context,offset);
+	emitDrawCommands(gcm_context,count);
+      }
+    }
+
     void emitDrawCommands(gcmContextData * gcm_context,uint32_t count) const {
       if(rsx_primitive_type == NV30_3D_VERTEX_BEGIN_END_POINTS) {
 	rsxgl_draw_array_elements_operations< RSXGL_MAX_DRAW_BATCH_SIZE, rsxgl_draw_points > op;
@@ -956,9 +1167,9 @@ namespace {
     }
 
     void end(gcmContextData * context) const {
-      if(client_indices) {
-	rsxgl_assert(migrate_buffer != 0);
+      if(migrate_buffer != 0) {
 	rsxgl_vertex_migrate_free(context,migrate_buffer,migrate_buffer_size);
+	migrate_buffer = 0;
       }
     }
 
@@ -1001,42 +1212,54 @@ namespace {
     }
   };
 
+  // Instances share one copy of the draw commands, a subroutine that each instance calls after
+  // setting its instance ID. The subroutine is kept out of the command ring, whose space behind
+  // GET is reused while calls to the subroutine are still queued. If there's no room for it,
+  // each instance's draw commands are emitted inline.
   struct instanced_draw_policy : public multi_draw_policy {
     const uint32_t instanceid_index;
 
-    mutable uint32_t call_offset, call_cmd;
+    // 0 if instances are drawn inline:
+    mutable uint32_t call_cmd;
 
     instanced_draw_policy(rsxgl_context_t * _ctx)
-      : multi_draw_policy(_ctx), instanceid_index(_ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].instanceid_index) {}
+      : multi_draw_policy(_ctx), instanceid_index(_ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].instanceid_index), call_cmd(0) {}
     
   protected:
+    mutable uint32_t * saved_current, * saved_end;
+
+    // Returns true if the subroutine is being recorded - the caller emits nwords of draw commands,
+    // and then calls endInstance:
+    bool beginInstance(gcmContextData * gcm_context,uint32_t timestamp,uint32_t nwords) const {
+      uint32_t call_offset = 0;
+      uint32_t * subroutine = rsxgl_command_list_subroutine(nwords + 1,timestamp,&call_offset);
+      if(subroutine == 0) {
+	call_cmd = 0;
+	return false;
+      }
 
-    void beginInstance(gcmContextData * gcm_context,uint32_t nwords) const {
-      gcm_reserve(gcm_context,nwords + 2);
-
-      // call location - current position + 1
-      // jump location - current position + 1 word + nwords + 1 word
-      call_offset = 0;
-      uint32_t jump_offset = 0;
-      int32_t s = 0;
-      
-      s = gcmAddressToOffset(gcm_context -> current + 1,&call_offset);
-      rsxgl_assert(s == 0);
-      
-      s = gcmAddressToOffset(gcm_context -> current + nwords + 2,&jump_offset);
-      rsxgl_assert(s == 0);
+      call_cmd = gcm_call_cmd(call_offset);
 
-      gcm_emit_at(gcm_context -> current,0,gcm_jump_cmd(jump_offset)); ++gcm_context -> current;
+      saved_current = gcm_context -> current;
+      saved_end = gcm_context -> end;
+      gcm_context -> current = subroutine;
+      gcm_context -> end = subroutine + nwords;
 
-      call_cmd = gcm_call_cmd(call_offset);
+      return true;
     }
 
     void endInstance(gcmContextData * gcm_context) const {
-      gcm_emit_at(gcm_context -> current,0,gcm_return_cmd()); ++gcm_context -> current;
+      gcm_emit_at(gcm_context -> current,0,gcm_return_cmd());
+
+      gcm_context -> current = saved_current;
+      gcm_context -> end = saved_end;
     }
 
-    void draw(gcmContextData * gcm_context,unsigned int i) const {
-      uint32_t * buffer = gcm_reserve(gcm_context,4);
+    // Returns true if the caller needs to emit the instance's draw commands itself, and then call
+    // multi_draw_policy::draw:
+    bool draw(gcmContextData * gcm_context,unsigned int i) const {
+      const uint32_t n = (call_cmd != 0) ? 4 : 3;
+      uint32_t * buffer = gcm_reserve(gcm_context,n);
 
       ieee32_t tmp;
       tmp.f = (float)i;
@@ -1044,11 +1267,19 @@ namespace {
       gcm_emit_method_at(buffer,0,NV30_3D_VP_UPLOAD_CONST_ID,2);
       gcm_emit_at(buffer,1,instanceid_index);
       gcm_emit_at(buffer,2,tmp.u);
-      gcm_emit_at(buffer,3,call_cmd);
+      if(call_cmd != 0) {
+	gcm_emit_at(buffer,3,call_cmd);
+      }
 
-      gcm_finish_n_commands(gcm_context,4);
+      gcm_finish_n_commands(gcm_context,n);
 
-      multi_draw_policy::draw(gcm_context);
+      if(call_cmd != 0) {
+	multi_draw_policy::draw(gcm_context);
+	return false;
+      }
+      else {
+	return true;
+      }
     }
   };
 }
@@ -1073,7 +1304,7 @@ namespace {
       : array_draw_policy(_rsx_primitive_type), first(_first), count(_count) {
     }
     
-    void begin(gcmContextData * context,uint32_t) const {}
+    bool begin(gcmContextData * context,uint32_t) const { return true; }
     void end(gcmContextData * context,uint32_t) const {}
     
     void draw(gcmContextData * gcm_context,uint32_t,unsigned int) const {
@@ -1097,7 +1328,7 @@ glDrawArrays (GLenum mode, GLint first, GLsizei count)
   }
 
   if(rsx_primitive_type != ~0 && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {    
-    rsxgl_draw(ctx,arrays_element_range_policy(first,count),single_iteration_policy(),draw_arrays_policy(rsx_primitive_type,first,count));
+    rsxgl_draw(ctx,arrays_element_range_policy(first,count),single_iteration_policy(),draw_arrays_policy(rsx_primitive_type,first,count),count);
   }
 
   RSXGL_NOERROR_();
@@ -1145,7 +1376,7 @@ glMultiDrawArrays (GLenum mode, const GLint *first, const GLsizei *count, const
 	: array_draw_policy(_rsx_primitive_type), multi_draw_policy(_ctx), first(_first), count(_count) {
       }
 
-      void begin(gcmContextData * context,uint32_t) const {}
+      bool begin(gcmContextData * context,uint32_t) const { return true; }
       void end(gcmContextData * context,uint32_t) const {}
 
       void draw(gcmContextData * gcm_context,uint32_t,unsigned int i) const {
@@ -1154,7 +1385,7 @@ glMultiDrawArrays (GLenum mode, const GLint *first, const GLsizei *count, const
       }
     };
 
-    rsxgl_draw(ctx,element_range_policy(first,count,primcount),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,first,count));
+    rsxgl_draw(ctx,element_range_policy(first,count,primcount),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,first,count),std::accumulate(count,count + primcount,0));
   }
 }
 
@@ -1167,13 +1398,12 @@ namespace {
     
     draw_elements_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,uint32_t _rsx_element_type,GLsizei _count,const GLvoid * _indices) : element_draw_policy(_ctx,_rsx_primitive_type,_rsx_element_type), count(_count), indices(_indices) {}
     
-    void begin(gcmContextData * gcm_context,uint32_t timestamp) const {
-      element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset);
+    bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+      return element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset,true);
     }
 
     void draw(gcmContextData * gcm_context,uint32_t timestamp,unsigned int) const {
-      element_draw_policy::emitIndexBufferCommands(gcm_context,offset);
-      element_draw_policy::emitDrawCommands(gcm_context,count);
+      element_draw_policy::emitElements(gcm_context,offset,indices,count);
     }
 
     void end(gcmContextData * gcm_context,uint32_t) const {
@@ -1206,7 +1436,7 @@ glDrawElements (GLenum mode, GLsizei count, GLenum type, const GLvoid* indices)
   }
 
   if(rsx_primitive_type != ~0 && rsx_element_type != RSXGL_MAX_ELEMENT_TYPES && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
-    rsxgl_draw(ctx,ignore_element_range_policy(),single_iteration_policy(),draw_elements_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices));
+    rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,&count,&indices,1),single_iteration_policy(),draw_elements_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices),count);
   }
 
   RSXGL_NOERROR_();
@@ -1235,7 +1465,7 @@ glDrawRangeElements (GLenum mode, GLuint start, GLuint end, GLsizei count, GLenu
   }
 
   if(rsx_primitive_type != ~0 && rsx_element_type != RSXGL_MAX_ELEMENT_TYPES && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
-    rsxgl_draw(ctx,start_end_element_range_policy(start,end),single_iteration_policy(),draw_elements_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices));    
+    rsxgl_draw(ctx,start_end_element_range_policy(start,end),single_iteration_policy(),draw_elements_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices),count);
   }
 
   RSXGL_NOERROR_();
@@ -1251,8 +1481,8 @@ namespace {
     
     draw_elements_base_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,uint32_t _rsx_element_type,GLsizei _count,const GLvoid * _indices,GLint _basevertex) : element_draw_policy(_ctx,_rsx_primitive_type,_rsx_element_type), count(_count), indices(_indices), basevertex(_basevertex) {}
     
-    void begin(gcmContextData * gcm_context,uint32_t timestamp) const {
-      element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset);
+    bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+      return element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset);
     }
     
     void draw(gcmContextData * gcm_context,uint32_t timestamp,unsigned int) const {
@@ -1287,7 +1517,7 @@ glDrawElementsBaseVertex (GLenum mode, GLsizei count, GLenum type, const GLvoid
   }
 
   if(rsx_primitive_type != ~0 && rsx_element_type != RSXGL_MAX_ELEMENT_TYPES && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
-    rsxgl_draw(ctx,ignore_element_range_policy(),single_iteration_policy(),draw_elements_base_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex));
+    rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,&count,&indices,1,&basevertex),single_iteration_policy(),draw_elements_base_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex),count);
   }
 
   RSXGL_NOERROR_();
@@ -1316,7 +1546,7 @@ glDrawRangeElementsBaseVertex (GLenum mode, GLuint start, GLuint end, GLsizei co
   }
 
   if(rsx_primitive_type != ~0 && rsx_element_type != RSXGL_MAX_ELEMENT_TYPES && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
-    rsxgl_draw(ctx,start_end_element_range_policy(start,end),single_iteration_policy(),draw_elements_base_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex));
+    rsxgl_draw(ctx,start_end_element_range_policy(start,end,basevertex),single_iteration_policy(),draw_elements_base_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex),count);
   }
 
   RSXGL_NOERROR_();
@@ -1350,13 +1580,12 @@ glMultiDrawElements (const GLenum mode, const GLsizei *count, GLenum type, const
 
       draw_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,uint32_t _rsx_element_type,const GLsizei * _count,const GLvoid * const * _indices,GLsizei _primcount) : element_draw_policy(_ctx,_rsx_primitive_type,_rsx_element_type), multi_draw_policy(_ctx), count(_count), indices(_indices), primcount(_primcount), offsets(new uint32_t[primcount]) {}
       
-      void begin(gcmContextData * gcm_context,uint32_t timestamp) const {
-	element_draw_policy::begin(gcm_context,timestamp,count,indices,primcount,offsets.get());
+      bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+	return element_draw_policy::begin(gcm_context,timestamp,count,indices,primcount,offsets.get(),true);
       }
       
       void draw(gcmContextData * gcm_context,uint32_t timestamp,unsigned int i) const {
-	element_draw_policy::emitIndexBufferCommands(gcm_context,offsets.get()[i]);
-	element_draw_policy::emitDrawCommands(gcm_context,count[i]);
+	element_draw_policy::emitElements(gcm_context,offsets.get()[i],indices[i],count[i]);
 
 	multi_draw_policy::draw(gcm_context);
       }
@@ -1366,7 +1595,7 @@ glMultiDrawElements (const GLenum mode, const GLsizei *count, GLenum type, const
       }
     };
 
-    rsxgl_draw(ctx,ignore_element_range_policy(),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,primcount));
+    rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,count,indices,primcount),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,primcount),std::accumulate(count,count + primcount,0));
   }
 
   RSXGL_NOERROR_();
@@ -1401,8 +1630,8 @@ glMultiDrawElementsBaseVertex (GLenum mode, const GLsizei *count, GLenum type, c
 
       draw_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,uint32_t _rsx_element_type,const GLsizei * _count,const GLvoid * const * _indices,GLsizei _primcount,const GLint * _basevertex) : element_draw_policy(_ctx,_rsx_primitive_type,_rsx_element_type), multi_draw_policy(_ctx), count(_count), indices(_indices), primcount(_primcount), basevertex(_basevertex), offsets(new uint32_t[primcount]) {}
       
-      void begin(gcmContextData * gcm_context,uint32_t timestamp) const {
-	element_draw_policy::begin(gcm_context,timestamp,count,indices,primcount,offsets.get());
+      bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+	return element_draw_policy::begin(gcm_context,timestamp,count,indices,primcount,offsets.get());
       }
       
       void draw(gcmContextData * gcm_context,uint32_t timestamp,unsigned int i) const {
@@ -1418,7 +1647,7 @@ glMultiDrawElementsBaseVertex (GLenum mode, const GLsizei *count, GLenum type, c
       }
     };
 
-    rsxgl_draw(ctx,ignore_element_range_policy(),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,primcount,basevertex));
+    rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,count,indices,primcount,basevertex),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,primcount,basevertex),std::accumulate(count,count + primcount,0));
   }
 
   RSXGL_NOERROR_();
@@ -1442,6 +1671,11 @@ glDrawArraysInstanced (GLenum mode, GLint first, GLsizei count, GLsizei primcoun
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
+  // Instances are drawn by calling a subroutine, and the RSX can't nest calls:
+  if(ctx -> command_list != 0 && primcount > 1) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   if(rsx_primitive_type != ~0 && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
     struct draw_policy : public array_draw_policy, public instanced_draw_policy {
       const GLint first;
@@ -1450,24 +1684,29 @@ glDrawArraysInstanced (GLenum mode, GLint first, GLsizei count, GLsizei primcoun
       draw_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,const GLsizei _first,const GLsizei _count)
 	: array_draw_policy(_rsx_primitive_type), instanced_draw_policy(_ctx), first(_first), count(_count) {}
 
-      void begin(gcmContextData * gcm_context,uint32_t) const {
-	instanced_draw_policy::beginInstance(gcm_context,array_draw_policy::countDrawCommands(count));
-	array_draw_policy::emitDrawCommands(gcm_context,first,count);
-	instanced_draw_policy::endInstance(gcm_context);
+      bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+	if(instanced_draw_policy::beginInstance(gcm_context,timestamp,array_draw_policy::countDrawCommands(count))) {
+	  array_draw_policy::emitDrawCommands(gcm_context,first,count);
+	  instanced_draw_policy::endInstance(gcm_context);
+	}
+	return true;
       }
 
       void draw(gcmContextData * gcm_context,uint32_t,unsigned int i) const {
-	instanced_draw_policy::draw(gcm_context,i);
+	if(instanced_draw_policy::draw(gcm_context,i)) {
+	  array_draw_policy::emitDrawCommands(gcm_context,first,count);
+	  multi_draw_policy::draw(gcm_context);
+	}
       }
 
       void end(gcmContextData * gcm_context,uint32_t) const {}
     };
     
     if(ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].instanceid_index != ~0 && primcount > 1) {
-      rsxgl_draw(ctx,ignore_element_range_policy(),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,first,count));
+      rsxgl_draw(ctx,arrays_element_range_policy(first,count),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,first,count),count * primcount);
     }
     else {
-      rsxgl_draw(ctx,arrays_element_range_policy(first,count),single_iteration_policy(),draw_arrays_policy(rsx_primitive_type,first,count));
+      rsxgl_draw(ctx,arrays_element_range_policy(first,count),single_iteration_policy(),draw_arrays_policy(rsx_primitive_type,first,count),count);
     }
   }
 
@@ -1492,6 +1731,11 @@ glDrawElementsInstanced (const GLenum mode, const GLsizei count, const GLenum ty
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
+  // Instances are drawn by calling a subroutine, and the RSX can't nest calls:
+  if(ctx -> command_list != 0 && primcount > 1) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   if(rsx_primitive_type != ~0 && rsx_element_type != RSXGL_MAX_ELEMENT_TYPES && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
     struct draw_policy : public element_draw_policy, public instanced_draw_policy {
       const GLsizei count;
@@ -1502,17 +1746,22 @@ glDrawElementsInstanced (const GLenum mode, const GLsizei count, const GLenum ty
       draw_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,uint32_t _rsx_element_type,const GLsizei _count,const GLvoid * _indices)
 	: element_draw_policy(_ctx,_rsx_primitive_type,_rsx_element_type), instanced_draw_policy(_ctx), count(_count), indices(_indices) {}
 
-      void begin(gcmContextData * gcm_context,uint32_t timestamp) const {
-	element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset);
+      bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+	if(!element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset)) return false;
 	element_draw_policy::emitIndexBufferCommands(gcm_context,offset);
 
-	instanced_draw_policy::beginInstance(gcm_context,element_draw_policy::countDrawCommands(count));
-	element_draw_policy::emitDrawCommands(gcm_context,count);
-	instanced_draw_policy::endInstance(gcm_context);
+	if(instanced_draw_policy::beginInstance(gcm_context,timestamp,element_draw_policy::countDrawCommands(count))) {
+	  element_draw_policy::emitDrawCommands(gcm_context,count);
+	  instanced_draw_policy::endInstance(gcm_context);
+	}
+	return true;
       }
 
       void draw(gcmContextData * gcm_context,uint32_t,unsigned int i) const {
-	instanced_draw_policy::draw(gcm_context,i);
+	if(instanced_draw_policy::draw(gcm_context,i)) {
+	  element_draw_policy::emitDrawCommands(gcm_context,count);
+	  multi_draw_policy::draw(gcm_context);
+	}
       }
 
       void end(gcmContextData * gcm_context,uint32_t) const {
@@ -1521,10 +1770,10 @@ glDrawElementsInstanced (const GLenum mode, const GLsizei count, const GLenum ty
     };
 
     if(ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].instanceid_index != ~0 && primcount > 1) {
-      rsxgl_draw(ctx,ignore_element_range_policy(),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices));
+      rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,&count,&indices,1),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices),count * primcount);
     }
     else {
-      rsxgl_draw(ctx,ignore_element_range_policy(),single_iteration_policy(),draw_elements_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices));
+      rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,&count,&indices,1),single_iteration_policy(),draw_elements_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices),count);
     }
   }
 
@@ -1549,6 +1798,11 @@ glDrawElementsInstancedBaseVertex (GLenum mode, GLsizei count, GLenum type, cons
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
+  // Instances are drawn by calling a subroutine, and the RSX can't nest calls:
+  if(ctx -> command_list != 0 && primcount > 1) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   if(rsx_primitive_type != ~0 && rsx_element_type != RSXGL_MAX_ELEMENT_TYPES && ctx -> state.enable.conditional_render_status != RSXGL_CONDITIONAL_RENDER_ACTIVE_WAIT_FAIL) {
     struct draw_policy : public element_draw_policy, public base_element_draw_policy, public instanced_draw_policy {
       const GLsizei count;
@@ -1560,18 +1814,23 @@ glDrawElementsInstancedBaseVertex (GLenum mode, GLsizei count, GLenum type, cons
       draw_policy(rsxgl_context_t * _ctx,uint32_t _rsx_primitive_type,uint32_t _rsx_element_type,GLsizei _count,const GLvoid * _indices,GLint _basevertex)
 	: element_draw_policy(_ctx,_rsx_primitive_type,_rsx_element_type), instanced_draw_policy(_ctx), count(_count), indices(_indices), basevertex(_basevertex) {}
 
-      void begin(gcmContextData * gcm_context,uint32_t timestamp) const {
-	element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset);
+      bool begin(gcmContextData * gcm_context,uint32_t timestamp) const {
+	if(!element_draw_policy::begin(gcm_context,timestamp,&count,&indices,1,&offset)) return false;
 	base_element_draw_policy::draw(gcm_context,basevertex);
 	element_draw_policy::emitIndexBufferCommands(gcm_context,offset);
 
-	instanced_draw_policy::beginInstance(gcm_context,element_draw_policy::countDrawCommands(count));
-	element_draw_policy::emitDrawCommands(gcm_context,count);
-	instanced_draw_policy::endInstance(gcm_context);
+	if(instanced_draw_policy::beginInstance(gcm_context,timestamp,element_draw_policy::countDrawCommands(count))) {
+	  element_draw_policy::emitDrawCommands(gcm_context,count);
+	  instanced_draw_policy::endInstance(gcm_context);
+	}
+	return true;
       }
 
       void draw(gcmContextData * gcm_context,uint32_t,unsigned int i) const {
-	instanced_draw_policy::draw(gcm_context,i);
+	if(instanced_draw_policy::draw(gcm_context,i)) {
+	  element_draw_policy::emitDrawCommands(gcm_context,count);
+	  multi_draw_policy::draw(gcm_context);
+	}
       }
 
       void end(gcmContextData * gcm_context,uint32_t) const {
@@ -1580,10 +1839,10 @@ glDrawElementsInstancedBaseVertex (GLenum mode, GLsizei count, GLenum type, cons
     };
 
     if(ctx -> program_binding[RSXGL_ACTIVE_PROGRAM].instanceid_index != ~0 && primcount > 1) {
-      rsxgl_draw(ctx,ignore_element_range_policy(),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex));
+      rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,&count,&indices,1,&basevertex),multi_iteration_policy(primcount),draw_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex),count * primcount);
     }
     else {
-      rsxgl_draw(ctx,ignore_element_range_policy(),single_iteration_policy(),draw_elements_base_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex));
+      rsxgl_draw(ctx,scan_element_range_policy(ctx,rsx_element_type,&count,&indices,1,&basevertex),single_iteration_policy(),draw_elements_base_policy(ctx,rsx_primitive_type,rsx_element_type,count,indices,basevertex),count);
     }
   }
 
@@ -21,7 +21,7 @@ static uint32_t rsxgl_vertex_migrate_size = RSXGL_CONFIG_vertex_migrate_buffer_s
 static void * _rsxgl_vertex_migrate_buffer = 0;
 
 // Tail position - nothing else:
-static uint32_t rsxgl_vertex_migrate_tail = 0;
+static uint32_t rsxgl_vertex_migrate_tail = 0, rsxgl_vertex_migrate_peak = 0;
 
 // memalign/free calls do not stack - this is here to ensure that
 #if !defined(NDEBUG)
@@ -67,6 +67,7 @@ rsxgl_dumb_migrate_memalign(gcmContextData *,const rsx_size_t align,const rsx_si
   }
   else {
     rsxgl_vertex_migrate_tail = new_tail;
+    if(new_tail > rsxgl_vertex_migrate_peak) rsxgl_vertex_migrate_peak = new_tail;
     return (uint8_t *)buffer + offset;
   }
 }
@@ -87,3 +88,18 @@ rsxgl_dumb_migrate_reset(gcmContextData *)
 {
   rsxgl_vertex_migrate_tail = 0;
 }
+
+uint32_t
+rsxgl_dumb_migrate_allocated()
+{
+  return rsxgl_vertex_migrate_tail;
+}
+
+void
+rsxgl_dumb_migrate_info(struct rsxgl_memory_info_t * info)
+{
+  info -> size = (_rsxgl_vertex_migrate_buffer != 0) ? rsxgl_vertex_migrate_size : 0;
+  info -> used = rsxgl_vertex_migrate_tail;
+  info -> free = info -> largest_free = info -> size - rsxgl_vertex_migrate_tail;
+  info -> peak = rsxgl_vertex_migrate_peak;
+}
@@ -1,9 +1,11 @@
 #include "mem.h"
 #include "nv40.h"
+#include "gl_fifo.h"
 
 #include "egl_types.h"
 #include "rsxgl_config.h"
 #include "rsxgl_limits.h"
+#include "wait.h"
 
 #include "util/u_format.h"
 #include "nouveau/nouveau_winsys.h"
@@ -18,6 +20,7 @@
 
 #include <sysutil/video.h>
 #include <rsx/gcm_sys.h>
+#include <ppu_intrinsics.h>
 
 //
 #if !defined(NDEBUG)
@@ -112,7 +115,14 @@ struct rsxgl_init_parameters_t rsxgl_init_parameters = {
   .max_swap_wait_iterations = 100000,
   .swap_wait_interval = RSXGL_SYNC_SLEEP_INTERVAL,
   .rsx_mspace_offset = 0,
-  .rsx_mspace_size = 0
+  .rsx_mspace_size = 0,
+  .flush_draw_threshold = RSXGL_CONFIG_default_flush_draw_threshold,
+  .flush_word_threshold = RSXGL_CONFIG_default_flush_word_threshold,
+  .flush_vertex_threshold = RSXGL_CONFIG_default_flush_vertex_threshold,
+  .wait_spin_time = RSXGL_WAIT_SPIN_TIME,
+  .wait_max_sleep = RSXGL_WAIT_MAX_SLEEP,
+  .main_buffer_arena_size = RSXGL_CONFIG_default_main_buffer_arena_size,
+  .buffer_migration = 0
 };
 
 static void * rsx_shared_memory = 0;
@@ -132,6 +142,11 @@ rsxglConfigure(struct rsxgl_init_parameters_t const * parameters)
     RSXEGL_ERROR_(EGL_BAD_PARAMETER);
   }
 
+  // Automatic flushes must happen before the command buffer fills up:
+  if(parameters -> flush_word_threshold >= parameters -> command_buffer_length) {
+    RSXEGL_ERROR_(EGL_BAD_PARAMETER);
+  }
+
   rsxgl_init_parameters = *parameters;
 }
 
@@ -159,6 +174,7 @@ eglInitialize(EGLDisplay dpy,EGLint * major,EGLint * minor)
       RSXEGL_ERROR(EGL_BAD_ALLOC,EGL_FALSE);
     }
     rsx_gcm_context = _rsx_gcm_context;
+    gcm_ring_init(rsx_gcm_context);
 
     gcmSetFlipMode(GCM_FLIP_VSYNC);
     gcmResetFlipStatus();
@@ -180,11 +196,14 @@ eglInitialize(EGLDisplay dpy,EGLint * major,EGLint * minor)
     RSXEGL_ERROR(EGL_NOT_INITIALIZED,(RETURN));	\
   }
 
+// Upper bound on the number of command words written by gcmSetFlip and gcmSetWaitFlip:
+#define RSXEGL_SWAP_COMMAND_LENGTH 64
+
 void
 rsx_flush()
 {
   gcmControlRegister *control = gcmGetControlRegister();
-  __asm __volatile__("sync"); // Sync, to make sure the command was written;
+  __sync(); // Sync, to make sure the command was written;
   uint32_t offset;
   gcmAddressToOffset(rsx_gcm_context->current, &offset);
   control->put = offset;
@@ -622,6 +641,7 @@ eglCreateWindowSurface(EGLDisplay _dpy,EGLConfig _config,EGLNativeWindowType win
   gcmResetFlipStatus();
   
   assert(rsx_gcm_context != 0);
+  gcm_reserve(rsx_gcm_context,RSXEGL_SWAP_COMMAND_LENGTH);
   int r = gcmSetFlip(rsx_gcm_context,1);
   assert(r == 0);
   rsx_flush(rsx_gcm_context);
@@ -939,6 +959,15 @@ EGLAPI EGLBoolean eglSwapBuffers(EGLDisplay dpy,EGLSurface _surface)
 
   if(surface -> double_buffered == EGL_BACK_BUFFER) {
     assert(rsx_gcm_context != 0);
+
+    // The GL refuses while a command list is being recorded:
+    if((*current_rsxgl_ctx -> callback)(current_rsxgl_ctx,RSXEGL_PRE_CPU_SWAP) != 0) {
+      RSXEGL_ERROR(EGL_BAD_ACCESS,EGL_FALSE);
+    }
+
+    // Make room for the flip commands, so that libgcm never has to grow the command buffer itself:
+    gcm_reserve(rsx_gcm_context,RSXEGL_SWAP_COMMAND_LENGTH);
+
     int r = gcmSetFlip(rsx_gcm_context, surface -> buffer);
     assert(r == 0);
 
@@ -949,15 +978,18 @@ EGLAPI EGLBoolean eglSwapBuffers(EGLDisplay dpy,EGLSurface _surface)
     (*current_rsxgl_ctx -> callback)(current_rsxgl_ctx,RSXEGL_POST_CPU_SWAP);
 
     // wait for the GPU to finish:
-    uint32_t iter = 0;
-    while(((rsxgl_init_parameters.max_swap_wait_iterations == 0) || (iter < rsxgl_init_parameters.max_swap_wait_iterations)) &&
-	  gcmGetFlipStatus()) {
-      usleep(rsxgl_init_parameters.swap_wait_interval);
-      ++iter;
+    int flipped = (gcmGetFlipStatus() == 0);
+    if(!flipped) {
+      const uint64_t timeout = (uint64_t)rsxgl_init_parameters.max_swap_wait_iterations * (uint64_t)rsxgl_init_parameters.swap_wait_interval;
+
+      struct rsxgl_wait_t wait;
+      rsxgl_wait_begin(&wait,(timeout == 0) ? RSXGL_WAIT_FOREVER : timeout);
+      while(!(flipped = (gcmGetFlipStatus() == 0)) && rsxgl_wait_step(&wait));
+      rsxgl_wait_end(&wait,flipped);
     }
     (*current_rsxgl_ctx -> callback)(current_rsxgl_ctx,RSXEGL_POST_GPU_SWAP);
 
-    RSXEGL_NOERROR(((rsxgl_init_parameters.max_swap_wait_iterations == 0) || (iter < rsxgl_init_parameters.max_swap_wait_iterations)) ? EGL_TRUE : EGL_FALSE);
+    RSXEGL_NOERROR(flipped ? EGL_TRUE : EGL_FALSE);
   }
   else {
     RSXEGL_NOERROR(EGL_FALSE);
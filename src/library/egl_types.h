@@ -58,7 +58,8 @@ enum rsxegl_context_callbacks {
   RSXEGL_MAKE_CONTEXT_CURRENT = 0,
   RSXEGL_POST_CPU_SWAP = 1,
   RSXEGL_POST_GPU_SWAP = 2,
-  RSXEGL_DESTROY_CONTEXT = 3
+  RSXEGL_DESTROY_CONTEXT = 3,
+  RSXEGL_PRE_CPU_SWAP = 4
 };
 
 struct rsxegl_context_t {
@@ -71,10 +72,10 @@ struct rsxegl_context_t {
 
   gcmContextData * gcm_context;
 
-  void (*callback)(struct rsxegl_context_t *,const uint8_t);
+  // Returns non-zero if the operation mustn't proceed:
+  int (*callback)(struct rsxegl_context_t *,const uint8_t);
 
   struct pipe_screen * screen;
-  uint32_t sync_sleep_interval;
 };
 
 #ifdef __cplusplus
@@ -5,6 +5,7 @@
 // enable.c - glEnable and glDisable functions.
 
 #include <GL3/gl3.h>
+#include "GL3/rsxgl3ext.h"
 
 #include "rsxgl_context.h"
 #include "gl_constants.h"
@@ -51,6 +52,9 @@ glEnable (GLenum cap)
   case GL_RASTERIZER_DISCARD:
     ctx -> state.enable.rasterizer_discard = 1;
     break;
+  case GL_MAPPED_CLIENT_ARRAYS_RSX:
+    ctx -> state.enable.mapped_client_arrays = 1;
+    break;
   default:
     RSXGL_ERROR_(GL_INVALID_ENUM);
   };
@@ -94,6 +98,9 @@ glDisable (GLenum cap)
   case GL_RASTERIZER_DISCARD:
     ctx -> state.enable.rasterizer_discard = 0;
     break;
+  case GL_MAPPED_CLIENT_ARRAYS_RSX:
+    ctx -> state.enable.mapped_client_arrays = 0;
+    break;
   default:
     RSXGL_ERROR_(GL_INVALID_ENUM);
   };
@@ -130,6 +137,9 @@ glIsEnabled (GLenum cap)
   case GL_RASTERIZER_DISCARD:
     RSXGL_NOERROR(ctx -> state.enable.rasterizer_discard);
     break;
+  case GL_MAPPED_CLIENT_ARRAYS_RSX:
+    RSXGL_NOERROR(ctx -> state.enable.mapped_client_arrays);
+    break;
   default:
     RSXGL_ERROR(GL_INVALID_ENUM,GL_FALSE);
   };
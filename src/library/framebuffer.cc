@@ -93,14 +93,8 @@ glDeleteRenderbuffers (GLsizei count, const GLuint *renderbuffers)
     if(renderbuffer_t::storage().is_object(renderbuffer_name)) {
       ctx -> renderbuffer_binding.unbind_from_all(renderbuffer_name);
 
-      // TODO - orphan it, instead of doing this:
-      renderbuffer_t & renderbuffer = renderbuffer_t::storage().at(renderbuffer_name);
-      if(renderbuffer.timestamp > 0) {
-	rsxgl_timestamp_wait(ctx,renderbuffer.timestamp);
-	renderbuffer.timestamp = 0;
-      }
-
-      renderbuffer_t::gl_object_type::maybe_delete(renderbuffer_name);
+      // If the GPU is still using the renderbuffer, it's destroyed later by rsxgl_reclaim_orphans():
+      renderbuffer_t::gl_object_type::maybe_delete_or_orphan(rsxgl_timestamp_busy(ctx,renderbuffer_t::storage().at(renderbuffer_name).timestamp),renderbuffer_name);
     }
     else if(renderbuffer_t::storage().is_name(renderbuffer_name)) {
       renderbuffer_t::storage().destroy(renderbuffer_name);
@@ -346,10 +340,10 @@ framebuffer_t::~framebuffer_t()
       continue;
     }
     else if(attachment_type == RSXGL_ATTACHMENT_TYPE_RENDERBUFFER && attachments[i] != 0) {
-      renderbuffer_t::gl_object_type::unref_and_maybe_delete(attachments[i]);
+      renderbuffer_t::gl_object_type::unref_and_maybe_delete_or_orphan(gl_object_in_use(renderbuffer_t::storage().at(attachments[i])),attachments[i]);
     }
     else if(attachment_type == RSXGL_ATTACHMENT_TYPE_TEXTURE && attachments[i] != 0) {
-      texture_t::gl_object_type::unref_and_maybe_delete(attachments[i]);
+      texture_t::gl_object_type::unref_and_maybe_delete_or_orphan(gl_object_in_use(texture_t::storage().at(attachments[i])),attachments[i]);
     }
   }
 }
@@ -360,12 +354,10 @@ rsxgl_framebuffer_detach(framebuffer_t & framebuffer,const uint32_t rsx_attachme
   if(framebuffer.attachments[rsx_attachment] != 0) {
     const uint32_t attachment_type = framebuffer.attachment_types.get(rsx_attachment);
     if(attachment_type == RSXGL_ATTACHMENT_TYPE_RENDERBUFFER) {
-      // TODO - maybe orphan:
-      renderbuffer_t::gl_object_type::unref_and_maybe_delete(framebuffer.attachments[rsx_attachment]);
+      renderbuffer_t::gl_object_type::unref_and_maybe_delete_or_orphan(gl_object_in_use(renderbuffer_t::storage().at(framebuffer.attachments[rsx_attachment])),framebuffer.attachments[rsx_attachment]);
     }
     else if(attachment_type == RSXGL_ATTACHMENT_TYPE_TEXTURE) {
-      // TODO - maybe orphan:
-      texture_t::gl_object_type::unref_and_maybe_delete(framebuffer.attachments[rsx_attachment]);
+      texture_t::gl_object_type::unref_and_maybe_delete_or_orphan(gl_object_in_use(texture_t::storage().at(framebuffer.attachments[rsx_attachment])),framebuffer.attachments[rsx_attachment]);
     }
     framebuffer.attachment_types.set(rsx_attachment,RSXGL_ATTACHMENT_TYPE_NONE);
     framebuffer.attachments[rsx_attachment] = 0;
@@ -374,7 +366,7 @@ rsxgl_framebuffer_detach(framebuffer_t & framebuffer,const uint32_t rsx_attachme
   }
 }
 
-static inline void
+void
 rsxgl_framebuffer_invalidate(rsxgl_context_t * ctx,const framebuffer_t::name_type framebuffer_name,framebuffer_t & framebuffer)
 {
   framebuffer.invalid = 1;
@@ -1006,7 +998,7 @@ glReadBuffer (GLenum mode)
 }
 
 static inline void
-rsxgl_emit_surface(gcmContextData * context,const uint8_t which,surface_t const & surface)
+rsxgl_emit_surface(gcmContextData * context,register_cache_t & registers,const uint8_t which,surface_t const & surface)
 {
   static const uint32_t
     rsxgl_dma_methods[] = {
@@ -1041,18 +1033,26 @@ rsxgl_emit_surface(gcmContextData * context,const uint8_t which,surface_t const
 		     surface.memory.location,surface.memory.offset,surface.pitch);
 #endif
 
-  uint32_t * buffer = gcm_reserve(context,6);
+  rsxgl_emit_register(context,registers,rsxgl_dma_methods[which],(surface.memory.location == RSXGL_MEMORY_LOCATION_LOCAL) ? RSXGL_DMA_MEMORY_FRAME_BUFFER : RSXGL_DMA_MEMORY_HOST_BUFFER);
+  rsxgl_emit_register(context,registers,rsxgl_offset_methods[which],surface.memory.offset);
+  rsxgl_emit_register(context,registers,rsxgl_pitch_methods[which],surface.pitch);
+}
 
-  gcm_emit_method_at(buffer,0,rsxgl_dma_methods[which],1);
-  gcm_emit_at(buffer,1,(surface.memory.location == RSXGL_MEMORY_LOCATION_LOCAL) ? RSXGL_DMA_MEMORY_FRAME_BUFFER : RSXGL_DMA_MEMORY_HOST_BUFFER);
-  
-  gcm_emit_method_at(buffer,2,rsxgl_offset_methods[which],1);
-  gcm_emit_at(buffer,3,surface.memory.offset);
-  
-  gcm_emit_method_at(buffer,4,rsxgl_pitch_methods[which],1);
-  gcm_emit_at(buffer,5,surface.pitch);
-  
-  gcm_finish_n_commands(context,6);
+static inline void
+rsxgl_emit_render_targets(gcmContextData * context,register_cache_t & registers,
+			  const uint32_t format,const uint16_t w,const uint16_t h,const uint32_t coord_conventions,
+			  const uint32_t color_targets,const uint32_t color_mask,const uint32_t color_mask_mrt,const uint32_t depth_mask)
+{
+  rsxgl_emit_register(context,registers,NV30_3D_RT_FORMAT,format | ((31 - __builtin_clz(w)) << NV30_3D_RT_FORMAT_LOG2_WIDTH__SHIFT) | ((31 - __builtin_clz(h)) << NV30_3D_RT_FORMAT_LOG2_HEIGHT__SHIFT));
+
+  const uint32_t size[2] = { (uint32_t)w << 16, (uint32_t)h << 16 };
+  rsxgl_emit_registers(context,registers,NV30_3D_RT_HORIZ,2,size);
+
+  rsxgl_emit_register(context,registers,NV30_3D_COORD_CONVENTIONS,coord_conventions);
+  rsxgl_emit_register(context,registers,NV30_3D_RT_ENABLE,color_targets);
+  rsxgl_emit_register(context,registers,NV30_3D_COLOR_MASK,color_mask);
+  rsxgl_emit_register(context,registers,NV40_3D_MRT_COLOR_MASK,color_mask_mrt);
+  rsxgl_emit_register(context,registers,NV30_3D_DEPTH_WRITE_ENABLE,depth_mask);
 }
 
 void
@@ -1529,10 +1529,11 @@ rsxgl_draw_framebuffer_validate(rsxgl_context_t * ctx,uint32_t timestamp)
       const uint32_t depth_mask = framebuffer.depth_mask;
 
       gcmContextData * context = ctx -> gcm_context();
+      register_cache_t & registers = ctx -> registers;
       
       if(format != 0 && color_targets != 0) {
 	for(framebuffer_t::attachment_size_type i = 0;i < RSXGL_MAX_FRAMEBUFFER_SURFACES;++i) {
-	  rsxgl_emit_surface(context,i,framebuffer.draw_surfaces[i]);
+	  rsxgl_emit_surface(context,registers,i,framebuffer.draw_surfaces[i]);
 	}
 
 	const uint16_t w = framebuffer.size[0], h = framebuffer.size[1];
@@ -1542,39 +1543,11 @@ rsxgl_draw_framebuffer_validate(rsxgl_context_t * ctx,uint32_t timestamp)
 			   format,color_targets,(unsigned int)w,(unsigned int)h,color_mask,color_mask_mrt,depth_mask);
 #endif
 	
-	uint32_t * buffer = gcm_reserve(context,15);
-	
-	gcm_emit_method_at(buffer,0,NV30_3D_RT_FORMAT,1);
-	gcm_emit_at(buffer,1,format | ((31 - __builtin_clz(w)) << NV30_3D_RT_FORMAT_LOG2_WIDTH__SHIFT) | ((31 - __builtin_clz(h)) << NV30_3D_RT_FORMAT_LOG2_HEIGHT__SHIFT));
-	
-	gcm_emit_method_at(buffer,2,NV30_3D_RT_HORIZ,2);
-	gcm_emit_at(buffer,3,w << 16);
-	gcm_emit_at(buffer,4,h << 16);
-	
-	gcm_emit_method_at(buffer,5,NV30_3D_COORD_CONVENTIONS,1);
-	gcm_emit_at(buffer,6,h | NV30_3D_COORD_CONVENTIONS_ORIGIN_NORMAL);
-	
-	gcm_emit_method_at(buffer,7,NV30_3D_RT_ENABLE,1);
-	gcm_emit_at(buffer,8,color_targets);
-
-	gcm_emit_method_at(buffer,9,NV30_3D_COLOR_MASK,1);
-	gcm_emit_at(buffer,10,color_mask);
-
-	gcm_emit_method_at(buffer,11,NV40_3D_MRT_COLOR_MASK,1);
-	gcm_emit_at(buffer,12,color_mask_mrt);
-
-	gcm_emit_method_at(buffer,13,NV30_3D_DEPTH_WRITE_ENABLE,1);
-	gcm_emit_at(buffer,14,depth_mask);
-	
-	gcm_finish_n_commands(context,15);
+	rsxgl_emit_render_targets(context,registers,format,w,h,h | NV30_3D_COORD_CONVENTIONS_ORIGIN_NORMAL,
+				  color_targets,color_mask,color_mask_mrt,depth_mask);
       }
       else {
-	uint32_t * buffer = gcm_reserve(context,2);
-	
-	gcm_emit_method_at(buffer,0,NV30_3D_RT_ENABLE,1);
-	gcm_emit_at(buffer,1,0);
-	
-	gcm_finish_n_commands(context,2);
+	rsxgl_emit_register(context,registers,NV30_3D_RT_ENABLE,0);
       }
 
       ctx -> invalid.parts.draw_framebuffer = 0;
@@ -1582,6 +1555,21 @@ rsxgl_draw_framebuffer_validate(rsxgl_context_t * ctx,uint32_t timestamp)
   }
 }
 
+void
+rsxgl_draw_framebuffer_written(rsxgl_context_t * ctx)
+{
+  const framebuffer_t & framebuffer = ctx -> framebuffer_binding[RSXGL_DRAW_FRAMEBUFFER];
+
+  if(!framebuffer.is_default) {
+    for(framebuffer_t::attachment_types_t::const_iterator it = framebuffer.attachment_types.begin();!it.done();it.next(framebuffer.attachment_types)) {
+      if(it.value() == RSXGL_ATTACHMENT_TYPE_TEXTURE) {
+	ctx -> invalid.parts.texture_cache = 1;
+	return;
+      }
+    }
+  }
+}
+
 bool
 rsxgl_feedback_framebuffer_check(rsxgl_context_t * ctx,uint32_t offset,uint32_t count)
 {
@@ -1630,7 +1618,11 @@ rsxgl_feedback_framebuffer_validate(rsxgl_context_t * ctx,uint32_t offset,uint32
 
     rsxgl_buffer_validate(ctx,buffer,buffer_offset,length,timestamp);
 
-    rsxgl_emit_surface(context,surface,surface_t(buffer.memory + buffer_offset,pitch));
+    // The GPU writes this range; the vertex cache mustn't serve its old contents afterwards:
+    rsxgl_buffer_invalidate_range(buffer,buffer_offset,length);
+    buffer.write_timestamp = timestamp;
+
+    rsxgl_emit_surface(context,ctx -> registers,surface,surface_t(buffer.memory + buffer_offset,pitch));
 
     if(i == 0) {
       color_targets |= (NV30_3D_RT_ENABLE_COLOR0);
@@ -1645,7 +1637,7 @@ rsxgl_feedback_framebuffer_validate(rsxgl_context_t * ctx,uint32_t offset,uint32
     }
   }
 
-  rsxgl_emit_surface(context,RSXGL_FRAMEBUFFER_SURFACE_DEPTH,surface_t());
+  rsxgl_emit_surface(context,ctx -> registers,RSXGL_FRAMEBUFFER_SURFACE_DEPTH,surface_t());
 
   const uint16_t
     w = RSXGL_MAX_RENDERBUFFER_SIZE,
@@ -1656,29 +1648,6 @@ rsxgl_feedback_framebuffer_validate(rsxgl_context_t * ctx,uint32_t offset,uint32
 		     format,color_targets,(unsigned int)w,(unsigned int)h,color_mask,color_mask_mrt,depth_mask,(unsigned int)w,(unsigned int)h);
 #endif
 
-  uint32_t * buffer = gcm_reserve(context,15);
-  
-  gcm_emit_method_at(buffer,0,NV30_3D_RT_FORMAT,1);
-  gcm_emit_at(buffer,1,format | ((31 - __builtin_clz(w)) << NV30_3D_RT_FORMAT_LOG2_WIDTH__SHIFT) | ((31 - __builtin_clz(h)) << NV30_3D_RT_FORMAT_LOG2_HEIGHT__SHIFT));
-  
-  gcm_emit_method_at(buffer,2,NV30_3D_RT_HORIZ,2);
-  gcm_emit_at(buffer,3,w << 16);
-  gcm_emit_at(buffer,4,h << 16);
-  
-  gcm_emit_method_at(buffer,5,NV30_3D_COORD_CONVENTIONS,1);
-  gcm_emit_at(buffer,6,h | NV30_3D_COORD_CONVENTIONS_ORIGIN_NORMAL | NV30_3D_COORD_CONVENTIONS_CENTER_INTEGER);
-  
-  gcm_emit_method_at(buffer,7,NV30_3D_RT_ENABLE,1);
-  gcm_emit_at(buffer,8,color_targets);
-  
-  gcm_emit_method_at(buffer,9,NV30_3D_COLOR_MASK,1);
-  gcm_emit_at(buffer,10,color_mask);
-  
-  gcm_emit_method_at(buffer,11,NV40_3D_MRT_COLOR_MASK,1);
-  gcm_emit_at(buffer,12,color_mask_mrt);
-  
-  gcm_emit_method_at(buffer,13,NV30_3D_DEPTH_WRITE_ENABLE,1);
-  gcm_emit_at(buffer,14,depth_mask);
-  
-  gcm_finish_n_commands(context,15);
+  rsxgl_emit_render_targets(context,ctx -> registers,format,w,h,h | NV30_3D_COORD_CONVENTIONS_ORIGIN_NORMAL | NV30_3D_COORD_CONVENTIONS_CENTER_INTEGER,
+			    color_targets,color_mask,color_mask_mrt,depth_mask);
 }
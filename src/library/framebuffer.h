@@ -76,6 +76,8 @@ struct renderbuffer_t {
   ~renderbuffer_t();
 };
 
+template<> bool gl_object_in_use< renderbuffer_t >(const renderbuffer_t &);
+
 enum rsxgl_framebuffer_target {
   RSXGL_DRAW_FRAMEBUFFER = 0,
   RSXGL_READ_FRAMEBUFFER = 1,
@@ -149,9 +151,16 @@ struct framebuffer_t {
 
 struct rsxgl_context_t;
 
+// Something attached to the framebuffer changed; its surfaces need to be validated again:
+void rsxgl_framebuffer_invalidate(rsxgl_context_t *,const framebuffer_t::name_type,framebuffer_t &);
+
 void rsxgl_renderbuffer_validate(rsxgl_context_t *,renderbuffer_t &,uint32_t);
 void rsxgl_framebuffer_validate(rsxgl_context_t *,framebuffer_t &,uint32_t);
 void rsxgl_draw_framebuffer_validate(rsxgl_context_t *,uint32_t);
+
+// Commands that write to the draw framebuffer have been emitted. If it has textures attached,
+// the texture cache needs to be invalidated before they're sampled:
+void rsxgl_draw_framebuffer_written(rsxgl_context_t *);
 bool rsxgl_feedback_framebuffer_check(rsxgl_context_t *,uint32_t,uint32_t);
 void rsxgl_feedback_framebuffer_validate(rsxgl_context_t *,uint32_t,uint32_t,uint32_t);
 
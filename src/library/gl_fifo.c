@@ -1,8 +1,17 @@
 #include "gl_fifo.h"
+#include "rsxgl_limits.h"
+#include "wait.h"
+
+#include <ppu_intrinsics.h>
+#include <unistd.h>
 
 int32_t __attribute__((noinline))
 gcm_reserve_callback(gcmContextData *context,uint32_t count)
 {
+#if defined(RSXGL_HOST)
+  // The host's stand-in for libgcm uses ordinary function pointers:
+  return context -> callback(context,count);
+#else
   register int32_t result asm("3");
   asm volatile (
 		"stdu	1,-128(1)\n"
@@ -17,4 +26,134 @@ gcm_reserve_callback(gcmContextData *context,uint32_t count)
 		: "r31", "r0", "r1", "r2", "lr"
 		);
   return result;
+#endif
+}
+
+// Bounds of the command buffer, which is treated as a ring. context -> end is used as a soft
+// limit that is kept behind the GPU's GET pointer, so that the fast path in gcm_reserve never
+// overwrites commands that haven't been executed yet.
+static struct {
+  uint32_t * begin, * end;
+  uint32_t begin_offset, end_offset;
+} gcm_ring = { 0, 0, 0, 0 };
+
+void
+gcm_ring_init(gcmContextData * context)
+{
+  gcm_ring.begin = context -> begin;
+  gcm_ring.end = context -> end;
+
+  int32_t s = gcmAddressToOffset(gcm_ring.begin,&gcm_ring.begin_offset);
+  rsxgl_assert(s == 0);
+  s = gcmAddressToOffset(gcm_ring.end,&gcm_ring.end_offset);
+  rsxgl_assert(s == 0);
+}
+
+static inline void
+gcm_ring_put(gcmContextData * context)
+{
+  gcmControlRegister volatile *control = gcmGetControlRegister();
+  uint32_t offset;
+
+  __sync();
+  gcmAddressToOffset(context -> current,&offset);
+  control -> put = offset;
+}
+
+// Returns 0 if the GPU is outside of the ring (e.g., it is executing a called command list):
+static inline uint32_t *
+gcm_ring_get()
+{
+  gcmControlRegister volatile *control = gcmGetControlRegister();
+  const uint32_t offset = control -> get;
+
+  if(offset >= gcm_ring.begin_offset && offset <= gcm_ring.end_offset) {
+    return gcm_ring.begin + ((offset - gcm_ring.begin_offset) >> 2);
+  }
+  else {
+    return 0;
+  }
+}
+
+uint32_t
+gcm_reserve_limit()
+{
+  if(gcm_ring.begin == 0) {
+    return ~0U;
+  }
+  else {
+    return ((uint32_t)(gcm_ring.end - 1 - gcm_ring.begin) / 2) - 1;
+  }
+}
+
+int32_t
+gcm_reserve_wrap(gcmContextData * context,uint32_t count)
+{
+  // The ring hasn't been set up - defer to libgcm:
+  if(gcm_ring.begin == 0) {
+    const int32_t r = gcm_reserve_callback(context,count);
+    if(r != 0) {
+      __rsxgl_assert_func(__FILE__,__LINE__,__func__,"libgcm failed to make room in the command buffer");
+    }
+    return r;
+  }
+
+  // Commands are being recorded somewhere other than the ring:
+  if(context -> current < gcm_ring.begin || context -> current > gcm_ring.end) {
+    return rsxgl_command_list_reserve(context,count);
+  }
+
+  // Requests have to be satisfiable without waiting for the writer's own commands. Callers that
+  // can emit an unbounded number of words (draw commands) reserve them in pieces, so this is
+  // a bug in the caller, and writing past the reservation would corrupt the ring:
+  if(count > gcm_reserve_limit()) {
+    __rsxgl_assert_func(__FILE__,__LINE__,__func__,"command buffer request is larger than the ring allows");
+  }
+
+  // One word at the end of the ring is always kept free for the jump back to its beginning:
+  uint32_t * const usable_end = gcm_ring.end - 1;
+
+  struct rsxgl_wait_t wait;
+  int waiting = 0;
+
+  while(1) {
+    uint32_t * const get = gcm_ring_get();
+    uint32_t * const current = context -> current;
+
+    if(get != 0) {
+      // GPU is behind the writer in the previous lap - can write up to (but not onto) GET:
+      if(get > current) {
+	if((uint32_t)(get - current) > count) {
+	  context -> end = get - 1;
+	  if(waiting) rsxgl_wait_end(&wait,1);
+	  return 0;
+	}
+      }
+      // Room between the writer and the end of the ring:
+      else if((current + count) <= usable_end) {
+	context -> end = usable_end;
+	if(waiting) rsxgl_wait_end(&wait,1);
+	return 0;
+      }
+      // Wrap around. If GET is sitting at the beginning of the ring, then the GPU hasn't
+      // started on this lap yet, and the writer mustn't catch up to it:
+      else if(get > gcm_ring.begin || get == current) {
+	gcm_emit_at(current,0,gcm_jump_cmd(gcm_ring.begin_offset));
+	context -> current = gcm_ring.begin;
+	context -> end = gcm_ring.begin;
+
+	gcm_ring_put(context);
+	continue;
+      }
+    }
+
+    // Make sure the GPU has everything up to the writer, and wait for it to advance:
+    gcm_ring_put(context);
+
+    if(!waiting) {
+      rsxgl_wait_begin(&wait,RSXGL_WAIT_FOREVER);
+      waiting = 1;
+    }
+    rsxgl_wait_step(&wait);
+  }
 }
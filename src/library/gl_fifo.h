@@ -12,14 +12,26 @@ extern "C" {
 
 int32_t __attribute__((noinline)) gcm_reserve_callback(gcmContextData *,uint32_t);
 
-// TODO - Compile-time option to make the command buffer length checking in gcm_reserve
-// a no-op. The application would need to make sure that it creates an adequately-sized
-// command buffer that is flushed regularly.
+// Treat the command buffer that context currently describes as a ring. Call once, after gcmInitBody.
+void gcm_ring_init(gcmContextData *);
+
+// Largest number of words that a single gcm_reserve may ask for.
+uint32_t gcm_reserve_limit(void);
+
+// Slow path of gcm_reserve. Inserts a jump back to the beginning of the command buffer when the
+// end of it is reached, and waits for the GPU's GET pointer to leave the region that's about to be
+// written. Requests that can never be satisfied (more than gcm_reserve_limit() words) are fatal,
+// in release builds too.
+int32_t gcm_reserve_wrap(gcmContextData *,uint32_t);
+
+// Slow path of gcm_reserve while commands are being recorded into a command list (see command_list.cc):
+int32_t rsxgl_command_list_reserve(gcmContextData *,uint32_t);
+
 static inline uint32_t *
 gcm_reserve(gcmContextData * context,const uint32_t length)
 {
   if((context -> current + length) > context -> end) {
-    int32_t r = gcm_reserve_callback(context,length);
+    int32_t r = gcm_reserve_wrap(context,length);
     rsxgl_assert(r == 0);
   }
   return context -> current;
@@ -40,6 +52,13 @@ gcm_emit_method(uint32_t ** buffer,const uint32_t method,const uint32_t n)
   gcm_emit(buffer,method | (n << 18));
 }
 
+// The arguments all go to the same method, rather than to consecutive ones:
+static inline void
+gcm_emit_method_noninc(uint32_t ** buffer,const uint32_t method,const uint32_t n)
+{
+  gcm_emit(buffer,method | (n << 18) | 0x40000000);
+}
+
 static inline void
 gcm_emit_channel_method(uint32_t ** buffer,const uint32_t channel,const uint32_t method,const uint32_t n)
 {
@@ -108,6 +127,8 @@ gcm_return_cmd()
   return 0x00020000;
 }
 
+// The list between gcm_begin_list and gcm_finish_list must not straddle the end of the command
+// buffer, so reserve enough room for all of it up front.
 static inline uint32_t
 gcm_begin_list(gcmContextData * context)
 {
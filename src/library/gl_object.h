@@ -17,6 +17,25 @@
 #include "gl_object_storage.h"
 #include "bit_set.h"
 
+// True if the GPU may still be using an object, so that it has to be orphaned instead of being
+// destroyed when its last reference goes away. Object types that own GPU resources specialize
+// this; others are never in use:
+template< typename ObjectT >
+inline bool
+gl_object_in_use(const ObjectT &)
+{
+  return false;
+}
+
+// True if name refers to an object that has storage - including one that has been deleted, but
+// that is still attached to something:
+template< typename ObjectT >
+inline bool
+gl_object_has_storage(const typename ObjectT::name_type name)
+{
+  return ObjectT::storage().is_name(name) && ObjectT::storage().is_constructed(name);
+}
+
 template< typename ObjectT,
 	  size_t Max,
 	  int DefaultObject = 0 >
@@ -232,9 +251,15 @@ struct object_container_type {
   ~object_container_type() {
     for(size_type i = 0;i < Size;++i) {
       if(names[i] == 0) continue;
-      object_type::gl_object_type::unref_and_maybe_delete(names[i]);
+      release(names[i]);
     }
   }
+
+  // Drop a reference. If it was the last one to an object that's been deleted, and the GPU
+  // might still be using the object, it's orphaned rather than destroyed:
+  static void release(const name_type name) {
+    object_type::gl_object_type::unref_and_maybe_delete_or_orphan(gl_object_in_use(object_type::storage().at(name)),name);
+  }
   
   void bind(const size_type target,const name_type name) {
     assert(target < Size);
@@ -243,7 +268,7 @@ struct object_container_type {
     names[target] = name;
 
     if(name != 0) object_type::gl_object_type::ref(name);
-    if(prev_name != 0) object_type::gl_object_type::unref_and_maybe_delete(prev_name);
+    if(prev_name != 0) release(prev_name);
   }
 
   bool is_bound(const size_type target,const name_type name) const {
@@ -268,7 +293,8 @@ struct object_container_type {
 
     for(size_type target = 0;target < Size;++target) {
       if(names[target] == name) {
-	typename object_type::gl_object_type::unref_and_maybe_delete(name);
+	names[target] = 0;
+	release(name);
       }
     }
   }
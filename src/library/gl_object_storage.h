@@ -142,8 +142,21 @@ public:
       }
     } p(m_name_space);
 
+    // The orphans list is indexed by position, not by name:
+    struct orphan_predicate {
+      const orphan_size_type num_orphans;
+
+      orphan_predicate(const orphan_size_type _num_orphans)
+	: num_orphans(_num_orphans) {
+      }
+
+      bool operator()(const orphan_size_type i) const {
+	return i < num_orphans;
+      }
+    } q(m_num_orphans);
+
     contents().destruct(p);
-    orphans().destruct(p);
+    orphans().destruct(q);
   }
 
   name_type create_name() {
@@ -212,10 +225,15 @@ public:
     m_num_orphans = 0;
   }
 
+  // Destroy one orphan. The last orphan takes its place, so indices of other orphans beyond i
+  // are not stable across calls to this function:
   void destroy_orphan(const orphan_size_type i) {
     rsxgl_assert(i < m_num_orphans);
     orphans().destruct_item(i);
     --m_num_orphans;
+    if(i != m_num_orphans) {
+      contents_type::move_item(orphans(),i,orphans(),m_num_orphans);
+    }
   }
 
   void create_object(const name_type name) {
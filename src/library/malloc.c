@@ -5391,6 +5391,46 @@ struct mallinfo mspace_mallinfo(mspace msp) {
 }
 #endif /* NO_MALLINFO */
 
+/*
+  mspace_free_info reports the total usable size of the free chunks in
+  the given space (including top), and the usable size of the largest
+  one. Added for RSXGL, to report on fragmentation.
+*/
+void mspace_free_info(mspace msp, size_t* total, size_t* largest) {
+  mstate ms = (mstate)msp;
+  size_t mfree = 0;
+  size_t mlargest = 0;
+  if (!ok_magic(ms)) {
+    USAGE_ERROR_ACTION(ms,ms);
+  }
+  else if (!PREACTION(ms)) {
+    check_malloc_state(ms);
+    if (is_initialized(ms)) {
+      msegmentptr s = &ms->seg;
+      if (ms->topsize > CHUNK_OVERHEAD) {
+        mfree = mlargest = ms->topsize - CHUNK_OVERHEAD;
+      }
+      while (s != 0) {
+        mchunkptr q = align_as_chunk(s->base);
+        while (segment_holds(s, q) &&
+               q != ms->top && q->head != FENCEPOST_HEAD) {
+          if (!is_inuse(q)) {
+            size_t sz = chunksize(q) - CHUNK_OVERHEAD;
+            mfree += sz;
+            if (sz > mlargest)
+              mlargest = sz;
+          }
+          q = next_chunk(q);
+        }
+        s = s->next;
+      }
+    }
+    POSTACTION(ms);
+  }
+  *total = mfree;
+  *largest = mlargest;
+}
+
 size_t mspace_usable_size(void* mem) {
   if (mem != 0) {
     mchunkptr p = mem2chunk(mem);
@@ -21,11 +21,13 @@
 
 extern struct rsxgl_init_parameters_t rsxgl_init_parameters;
 
+static mspace _rsx_mspace = 0;
+static rsx_size_t _rsx_mspace_size = 0;
+static struct rsxgl_memory_usage_t _rsx_usage = { 0, 0 };
+
 mspace
 rsxgl_rsx_mspace()
 {
-  static mspace _rsx_mspace = 0;
-
   if(_rsx_mspace == 0) {
     gcmConfiguration config;
     gcmGetConfiguration(&config);
@@ -39,6 +41,7 @@ rsxgl_rsx_mspace()
 		       size,available,offset,(uint64_t)config.localAddress + offset);
 
     _rsx_mspace = create_mspace_with_base((uint8_t *)config.localAddress + offset,size,0);
+    _rsx_mspace_size = size;
   }
 
   assert(_rsx_mspace != 0);
@@ -46,26 +49,70 @@ rsxgl_rsx_mspace()
   return _rsx_mspace;
 }
 
+void
+rsxgl_mspace_info(mspace space,const rsx_size_t size,const struct rsxgl_memory_usage_t * usage,struct rsxgl_memory_info_t * info)
+{
+  size_t free_size = 0, largest_free = 0;
+  if(space != 0) mspace_free_info(space,&free_size,&largest_free);
+
+  info -> size = size;
+  info -> used = usage -> used;
+  info -> free = free_size;
+  info -> largest_free = largest_free;
+  info -> peak = usage -> peak;
+}
+
+void *
+rsxgl_mspace_memalign(mspace space,rsx_size_t alignment,rsx_size_t size)
+{
+  void * mem = mspace_memalign(space,alignment,size);
+  if(mem != 0 && space == _rsx_mspace) rsxgl_memory_usage_allocate(&_rsx_usage,mspace_usable_size(mem));
+  return mem;
+}
+
+void
+rsxgl_mspace_free(mspace space,void * mem)
+{
+  if(mem != 0 && space == _rsx_mspace) rsxgl_memory_usage_free(&_rsx_usage,mspace_usable_size(mem));
+  mspace_free(space,mem);
+}
+
 void *
 rsxgl_rsx_malloc(rsx_size_t size)
 {  
-  return mspace_malloc(rsxgl_rsx_mspace(),size);
+  void * mem = mspace_malloc(rsxgl_rsx_mspace(),size);
+  if(mem != 0) rsxgl_memory_usage_allocate(&_rsx_usage,mspace_usable_size(mem));
+  return mem;
 }
 
 void *
 rsxgl_rsx_memalign(rsx_size_t alignment,rsx_size_t size)
 {
-  return mspace_memalign(rsxgl_rsx_mspace(),alignment,size);
+  return rsxgl_mspace_memalign(rsxgl_rsx_mspace(),alignment,size);
 }
 
 void *
 rsxgl_rsx_realloc(void * mem,rsx_size_t size)
 {
-  return mspace_realloc(rsxgl_rsx_mspace(),mem,size);
+  const rsx_size_t old_size = mspace_usable_size(mem);
+  void * new_mem = mspace_realloc(rsxgl_rsx_mspace(),mem,size);
+
+  if(new_mem != 0 || size == 0) {
+    rsxgl_memory_usage_free(&_rsx_usage,old_size);
+    if(new_mem != 0) rsxgl_memory_usage_allocate(&_rsx_usage,mspace_usable_size(new_mem));
+  }
+
+  return new_mem;
 }
 
 void
 rsxgl_rsx_free(void * mem)
 {
-  mspace_free(rsxgl_rsx_mspace(),mem);
+  rsxgl_mspace_free(rsxgl_rsx_mspace(),mem);
+}
+
+void
+rsxgl_rsx_info(struct rsxgl_memory_info_t * info)
+{
+  rsxgl_mspace_info(rsxgl_rsx_mspace(),_rsx_mspace_size,&_rsx_usage,info);
 }
@@ -1,6 +1,7 @@
 #ifndef rsxgl_mem_H
 #define rsxgl_mem_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define MSPACES 1
@@ -24,6 +25,43 @@ void * rsxgl_rsx_memalign(rsx_size_t,rsx_size_t);
 void * rsxgl_rsx_realloc(void *,rsx_size_t);
 void rsxgl_rsx_free(void *);
 
+// Defined by malloc.c, but not declared by its header:
+size_t mspace_usable_size(void *);
+void mspace_free_info(mspace,size_t *,size_t *);
+
+// Memory handed out by an allocator, and the most that it's had handed out at once:
+struct rsxgl_memory_usage_t {
+  rsx_size_t used, peak;
+};
+
+static inline void
+rsxgl_memory_usage_allocate(struct rsxgl_memory_usage_t * usage,const rsx_size_t size)
+{
+  usage -> used += size;
+  if(usage -> used > usage -> peak) usage -> peak = usage -> used;
+}
+
+static inline void
+rsxgl_memory_usage_free(struct rsxgl_memory_usage_t * usage,const rsx_size_t size)
+{
+  usage -> used -= size;
+}
+
+// What the GL_RSX_memory_info extension reports about a pool of memory:
+struct rsxgl_memory_info_t {
+  rsx_size_t size, used, free, largest_free, peak;
+};
+
+// Fill in info for an mspace of the given size. The free space is found by walking the mspace:
+void rsxgl_mspace_info(mspace,const rsx_size_t size,const struct rsxgl_memory_usage_t *,struct rsxgl_memory_info_t *);
+
+// Allocate from, or free to, an mspace. Allocations from the RSX heap are counted towards its
+// usage, whether they're made through these functions or through the rsxgl_rsx_* functions:
+void * rsxgl_mspace_memalign(mspace,rsx_size_t,rsx_size_t);
+void rsxgl_mspace_free(mspace,void *);
+
+void rsxgl_rsx_info(struct rsxgl_memory_info_t *);
+
 #ifdef __cplusplus
 }
 #endif
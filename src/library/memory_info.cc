@@ -0,0 +1,180 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// memory_info.cc - Report how the memory pools that the library allocates from are being used.
+
+#include "rsxgl_context.h"
+#include "arena.h"
+#include "stream.h"
+#include "migrate.h"
+#include "texture_migrate.h"
+#include "buffer.h"
+#include "textures.h"
+#include "framebuffer.h"
+
+#include <GL3/gl3.h>
+#include "GL3/rsxgl3ext.h"
+#include "error.h"
+
+#include "util/u_format.h"
+
+#if defined(GLAPI)
+#undef GLAPI
+#endif
+#define GLAPI extern "C"
+
+GLAPI void APIENTRY
+glGetMemoryPoolParameterivRSX(GLenum pool,GLenum pname,GLint * params)
+{
+  rsxgl_context_t * ctx = current_ctx();
+
+  rsxgl_memory_info_t info;
+
+  if(pool == GL_GPU_MEMORY_POOL_RSX) {
+    rsxgl_rsx_info(&info);
+  }
+  else if(pool == GL_VERTEX_MIGRATE_POOL_RSX) {
+    rsxgl_vertex_migrate_info(&info);
+  }
+  else if(pool == GL_TEXTURE_MIGRATE_POOL_RSX) {
+    rsxgl_texture_migrate_info(&info);
+  }
+  else if(pool == GL_GPU_STREAM_POOL_RSX) {
+    rsxgl_stream_info(ctx,RSXGL_MEMORY_LOCATION_LOCAL,&info);
+  }
+  else if(pool == GL_MAIN_STREAM_POOL_RSX) {
+    rsxgl_stream_info(ctx,RSXGL_MEMORY_LOCATION_MAIN,&info);
+  }
+  else {
+    RSXGL_ERROR_(GL_INVALID_ENUM);
+  }
+
+  if(pname == GL_POOL_SIZE_RSX) {
+    *params = info.size;
+  }
+  else if(pname == GL_POOL_USED_RSX) {
+    *params = info.used;
+  }
+  else if(pname == GL_POOL_FREE_RSX) {
+    *params = info.free;
+  }
+  else if(pname == GL_POOL_LARGEST_FREE_RSX) {
+    *params = info.largest_free;
+  }
+  else if(pname == GL_POOL_PEAK_USED_RSX) {
+    *params = info.peak;
+  }
+  else {
+    RSXGL_ERROR_(GL_INVALID_ENUM);
+  }
+
+  RSXGL_NOERROR_();
+}
+
+namespace {
+
+  struct object_memory_t {
+    uint32_t count;
+    rsx_size_t bytes[2];
+
+    object_memory_t()
+      : count(0) {
+      bytes[RSXGL_MEMORY_LOCATION_LOCAL] = 0;
+      bytes[RSXGL_MEMORY_LOCATION_MAIN] = 0;
+    }
+
+    void add(const memory_t & memory,const rsx_size_t size) {
+      ++count;
+      bytes[memory.location] += size;
+    }
+  };
+
+}
+
+static inline void
+rsxgl_memory_info_add(object_memory_t & totals,const buffer_t & buffer)
+{
+  if(buffer.memory) totals.add(buffer.memory,buffer.size);
+}
+
+static inline void
+rsxgl_memory_info_add(object_memory_t & totals,const texture_t & texture)
+{
+  if(texture.memory && texture.memory.owner) totals.add(texture.memory,rsxgl_texture_storage_size(texture,texture.pitch));
+}
+
+static inline void
+rsxgl_memory_info_add(object_memory_t & totals,const renderbuffer_t & renderbuffer)
+{
+  if(renderbuffer.surface.memory) totals.add(renderbuffer.surface.memory,util_format_get_2d_size(renderbuffer.pformat,renderbuffer.surface.pitch,renderbuffer.size[1]));
+}
+
+template< typename Object >
+static inline void
+rsxgl_memory_info_add_objects(object_memory_t & totals)
+{
+  for(typename Object::name_type name = 1,n = Object::storage().contents_size();name < n;++name) {
+    if(!gl_object_has_storage< Object >(name)) continue;
+    rsxgl_memory_info_add(totals,Object::storage().at(name));
+  }
+}
+
+// Deleted objects that the GPU was still using when they were destroyed; their memory is freed
+// once the GPU is done with them:
+template< typename Object >
+static inline void
+rsxgl_memory_info_add_orphans(object_memory_t & totals)
+{
+  for(size_t i = 0,n = Object::storage().num_orphans();i < n;++i) {
+    rsxgl_memory_info_add(totals,Object::storage().orphan_at(i));
+  }
+}
+
+GLAPI void APIENTRY
+glGetObjectMemoryParameterivRSX(GLenum type,GLenum pname,GLint * params)
+{
+  if(!(pname == GL_OBJECT_COUNT_RSX || pname == GL_OBJECT_GPU_MEMORY_RSX || pname == GL_OBJECT_MAIN_MEMORY_RSX)) {
+    RSXGL_ERROR_(GL_INVALID_ENUM);
+  }
+
+  rsxgl_context_t * ctx = current_ctx();
+
+  object_memory_t totals;
+
+  if(type == GL_BUFFER_OBJECTS_RSX) {
+    rsxgl_memory_info_add_objects< buffer_t >(totals);
+  }
+  else if(type == GL_TEXTURE_OBJECTS_RSX) {
+    rsxgl_memory_info_add_objects< texture_t >(totals);
+  }
+  else if(type == GL_RENDERBUFFER_OBJECTS_RSX) {
+    rsxgl_memory_info_add_objects< renderbuffer_t >(totals);
+  }
+  else if(type == GL_ORPHANED_OBJECTS_RSX) {
+    rsxgl_memory_info_add_orphans< buffer_t >(totals);
+    rsxgl_memory_info_add_orphans< texture_t >(totals);
+    rsxgl_memory_info_add_orphans< renderbuffer_t >(totals);
+  }
+  else if(type == GL_RETIRED_BUFFER_MEMORY_RSX) {
+    // Memory that buffers gave up while the GPU was still using it:
+    for(retired_buffer_memory_list_t::const_iterator it = ctx -> retired_buffer_memory.begin(),it_end = ctx -> retired_buffer_memory.end();it != it_end;++it) {
+      totals.add(it -> memory,it -> size);
+    }
+  }
+  else {
+    RSXGL_ERROR_(GL_INVALID_ENUM);
+  }
+
+  if(pname == GL_OBJECT_COUNT_RSX) {
+    *params = totals.count;
+  }
+  else if(pname == GL_OBJECT_GPU_MEMORY_RSX) {
+    *params = totals.bytes[RSXGL_MEMORY_LOCATION_LOCAL];
+  }
+  else if(pname == GL_OBJECT_MAIN_MEMORY_RSX) {
+    *params = totals.bytes[RSXGL_MEMORY_LOCATION_MAIN];
+  }
+
+  RSXGL_NOERROR_();
+}
@@ -17,17 +17,25 @@ typedef struct _gcmCtxData gcmContextData;
 void * rsxgl_ringbuffer_migrate_memalign(gcmContextData *,const rsx_size_t,const rsx_size_t);
 void rsxgl_ringbuffer_migrate_free(gcmContextData *,const void *,const rsx_size_t);
 void rsxgl_ringbuffer_migrate_reset(gcmContextData *);
+void rsxgl_ringbuffer_migrate_info(struct rsxgl_memory_info_t *);
+uint32_t rsxgl_ringbuffer_migrate_allocated();
 
 void * rsxgl_dumb_migrate_memalign(gcmContextData *,const rsx_size_t,const rsx_size_t);
 void rsxgl_dumb_migrate_free(gcmContextData *,const void *,const rsx_size_t);
 void rsxgl_dumb_migrate_reset(gcmContextData *);
+void rsxgl_dumb_migrate_info(struct rsxgl_memory_info_t *);
+uint32_t rsxgl_dumb_migrate_allocated();
 
 //#define rsxgl_vertex_migrate_memalign rsxgl_dumb_migrate_memalign
 //#define rsxgl_vertex_migrate_free rsxgl_dumb_migrate_free
 //#define rsxgl_vertex_migrate_reset rsxgl_dumb_migrate_reset
+//#define rsxgl_vertex_migrate_info rsxgl_dumb_migrate_info
+//#define rsxgl_vertex_migrate_allocated rsxgl_dumb_migrate_allocated
 
 #define rsxgl_vertex_migrate_memalign rsxgl_ringbuffer_migrate_memalign
 #define rsxgl_vertex_migrate_free rsxgl_ringbuffer_migrate_free
 #define rsxgl_vertex_migrate_reset rsxgl_ringbuffer_migrate_reset
+#define rsxgl_vertex_migrate_info rsxgl_ringbuffer_migrate_info
+#define rsxgl_vertex_migrate_allocated rsxgl_ringbuffer_migrate_allocated
 
 #endif
@@ -329,14 +329,8 @@ glDeleteProgram (GLuint program_name)
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  // TODO: orphan it, instead of doing this:
-  program_t & program = program_t::storage().at(program_name);
-  if(program.timestamp > 0) {
-    rsxgl_timestamp_wait(current_ctx(),program.timestamp);
-    program.timestamp = 0;
-  }
-
-  program_t::gl_object_type::maybe_delete(program_name);
+  // If the GPU is still using the program, it's destroyed later by rsxgl_reclaim_orphans():
+  program_t::gl_object_type::maybe_delete_or_orphan(rsxgl_timestamp_busy(current_ctx(),program_t::storage().at(program_name).timestamp),program_name);
 
   // TODO: destroy mesa resources
   
@@ -1621,7 +1615,6 @@ rsxgl_program_validate(rsxgl_context_t * ctx,const uint32_t timestamp)
   if(ctx -> program_binding.names[RSXGL_ACTIVE_PROGRAM] != 0) {
     program_t & program = ctx -> program_binding[RSXGL_ACTIVE_PROGRAM];
 
-    rsxgl_assert(timestamp >= program.timestamp);
     program.timestamp = timestamp;    
   }
 
@@ -1823,7 +1816,6 @@ rsxgl_feedback_program_validate(rsxgl_context_t * ctx,const uint32_t timestamp)
   if(ctx -> program_binding.names[RSXGL_ACTIVE_PROGRAM] != 0) {
     program_t & program = ctx -> program_binding[RSXGL_ACTIVE_PROGRAM];
 
-    rsxgl_assert(timestamp >= program.timestamp);
     program.timestamp = timestamp;    
   }
 
@@ -17,6 +17,7 @@
 #include <string>
 #include <cstddef>
 #include <cassert>
+#include <vector>
 
 #include <boost/integer.hpp>
 #include <boost/container/flat_set.hpp>
@@ -199,6 +200,8 @@ struct program_t {
   std::unique_ptr< instruction_size_type[] > program_offsets;
 };
 
+template<> bool gl_object_in_use< program_t >(const program_t &);
+
 struct rsxgl_context_t;
 
 void rsxgl_program_validate(rsxgl_context_t *,const uint32_t);
@@ -149,6 +149,11 @@ glBeginQuery (GLenum target, GLuint id)
 
   rsxgl_context_t * ctx = current_ctx();
 
+  // Query results are tied to timestamps, which a command list can't post:
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   if(ctx -> query_binding.is_anything_bound(rsx_target)) {
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
@@ -179,7 +184,7 @@ glBeginQuery (GLenum target, GLuint id)
 
   query.value = 0;
   query.status = RSXGL_QUERY_STATUS_ACTIVE;
-  query.timestamps[0] = rsxgl_timestamp_create(ctx,1);
+  query.timestamps[0] = rsxgl_timestamp_create(ctx);
 
   //
   gcmContextData * context = ctx -> gcm_context();
@@ -209,8 +214,6 @@ glBeginQuery (GLenum target, GLuint id)
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
 
-  rsxgl_timestamp_post(ctx,query.timestamps[0]);
-
   RSXGL_NOERROR_();
 }
 
@@ -224,6 +227,10 @@ glEndQuery (GLenum target)
 
   rsxgl_context_t * ctx = current_ctx();
 
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   if(!ctx -> query_binding.is_anything_bound(rsx_target)) {
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
@@ -236,7 +243,7 @@ glEndQuery (GLenum target)
 
   query.status = RSXGL_QUERY_STATUS_PENDING;
   rsxgl_assert(query.indices[0] != RSXGL_MAX_QUERY_OBJECTS);
-  query.timestamps[1] = rsxgl_timestamp_create(ctx,1);
+  query.timestamps[1] = rsxgl_timestamp_create(ctx);
 
   //
   gcmContextData * context = ctx -> gcm_context();
@@ -257,8 +264,6 @@ glEndQuery (GLenum target)
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
 
-  rsxgl_timestamp_post(ctx,query.timestamps[1]);
-
   ctx -> query_binding.bind(rsx_target,0);
 
   RSXGL_NOERROR_();
@@ -272,6 +277,12 @@ glQueryCounter (GLuint id, GLenum target)
   }
   const uint8_t rsx_target = RSXGL_QUERY_TIMESTAMP;
 
+  rsxgl_context_t * ctx = current_ctx();
+
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   if(id == 0 || !query_t::storage().is_name(id)) {
     RSXGL_ERROR_(GL_INVALID_OPERATION);
   }
@@ -282,8 +293,6 @@ glQueryCounter (GLuint id, GLenum target)
     rsxgl_free_query_object(id);
   }
 
-  rsxgl_context_t * ctx = current_ctx();
-
   query_t & query = query_t::storage().at(id);
 
   if(query.type == RSXGL_MAX_QUERY_TARGETS) {
@@ -296,8 +305,7 @@ glQueryCounter (GLuint id, GLenum target)
   query.status = RSXGL_QUERY_STATUS_PENDING;
   query.indices[0] = rsxgl_query_object_allocate();
   rsxgl_assert(query.indices[0] != RSXGL_MAX_QUERY_OBJECTS);
-  query.timestamps[0] = rsxgl_timestamp_create(ctx,1);
-  rsxgl_timestamp_post(ctx,query.timestamps[0]);
+  query.timestamps[0] = rsxgl_timestamp_create(ctx);
 
   gcmContextData * context = ctx -> gcm_context();
 
@@ -345,10 +353,10 @@ rsxgl_get_query_object_value(rsxgl_context_t * ctx,query_t & query)
       rsxgl_assert(query.indices[0] != RSXGL_MAX_QUERY_OBJECTS);
 
       uint32_t samples = 0;
-      const uint32_t last_timestamp = query.timestamps[1];
-      for(uint32_t timestamp = query.timestamps[0];(timestamp <= last_timestamp) && (samples == 0);++timestamp) {
+      for(uint32_t timestamp = query.timestamps[0];samples == 0;timestamp = rsxgl_timestamp_next(timestamp)) {
 	rsxgl_timestamp_wait(ctx,timestamp);
 	samples += rsxgl_query_object_get_value(query.indices[0]);
+	if(timestamp == query.timestamps[1]) break;
       }
       query.value = (samples > 0);
 
@@ -0,0 +1,83 @@
+//-*-C++-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// register_cache.h - Shadow copy of the 3D class's registers, used to avoid sending values to the
+// GPU that it already has.
+
+#ifndef rsxgl_register_cache_H
+#define rsxgl_register_cache_H
+
+#include "gl_fifo.h"
+#include "bit_set.h"
+
+// Covers the methods of the 3D class (subchannel 0) below 0x2000. Only methods that simply latch
+// a value should go through the cache - never ones that trigger work, like VERTEX_BEGIN_END,
+// CLEAR_BUFFERS, the cache invalidation methods, or the upload ports for programs & constants.
+//
+// Anything that leaves the GPU's registers in an unknown state (switching contexts, calling or
+// recording a command list) must call invalidate(); rsxgl_invalidate() takes care of this.
+struct register_cache_t {
+  static const uint32_t size = 0x2000 >> 2;
+
+  uint32_t values[size];
+  bit_set< size > valid;
+
+  register_cache_t() {
+    valid.reset();
+  }
+
+  void invalidate() {
+    valid.reset();
+  }
+
+  // Forget the values of n registers, starting at method. For methods that modify these registers
+  // without going through the cache:
+  void invalidate(const uint32_t method,const uint32_t n) {
+    rsxgl_assert(((method >> 2) + n) <= size);
+    for(uint32_t i = 0,j = method >> 2;i < n;++i,++j) {
+      valid.reset(j);
+    }
+  }
+};
+
+// Emit n consecutive registers, starting at method. Only the words from the first value that
+// differs from the cache to the last one are sent; if none differ, nothing is.
+static inline void
+rsxgl_emit_registers(gcmContextData * context,register_cache_t & cache,const uint32_t method,const uint32_t n,const uint32_t * values)
+{
+  const uint32_t base = method >> 2;
+  rsxgl_assert((base + n) <= register_cache_t::size);
+
+  uint32_t first = n, last = 0;
+  for(uint32_t i = 0,j = base;i < n;++i,++j) {
+    if(!cache.valid.test(j) || cache.values[j] != values[i]) {
+      if(first == n) first = i;
+      last = i;
+
+      cache.values[j] = values[i];
+      cache.valid.set(j);
+    }
+  }
+
+  if(first == n) return;
+
+  const uint32_t count = last - first + 1;
+  uint32_t * buffer = gcm_reserve(context,count + 1);
+
+  gcm_emit_method_at(buffer,0,method + (first << 2),count);
+  for(uint32_t i = 0;i < count;++i) {
+    gcm_emit_at(buffer,i + 1,values[first + i]);
+  }
+
+  gcm_finish_n_commands(context,count + 1);
+}
+
+static inline void
+rsxgl_emit_register(gcmContextData * context,register_cache_t & cache,const uint32_t method,const uint32_t value)
+{
+  rsxgl_emit_registers(context,cache,method,1,&value);
+}
+
+#endif
@@ -2,7 +2,19 @@
 //
 // Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
 //
-// ringbuffer_migrate.cc
+// ringbuffer_migrate.cc - Ring of RSX memory that client-side arrays are copied into for drawing.
+//
+// Space is handed out in order, and given back in order once the GPU has read it. Positions in
+// the ring are byte counts that only ever increase (wrapping around at 2^32); bytes that are
+// skipped when an allocation wraps around to the start of the ring count as used. Any number of
+// allocations may be outstanding. The GPU reports the position that it's finished with by writing
+// it to a semaphore; frees are batched, and a single semaphore write covering all of them is
+// emitted at the next allocation.
+//
+// If a request doesn't fit without waiting for the GPU, a larger segment of memory takes over
+// from the current one, up to RSXGL_CONFIG_vertex_migrate_max_buffer_size. A segment that has
+// been replaced is freed once the GPU has passed everything that was allocated from it. Requests
+// that can't be satisfied within that limit fail, and return 0.
 
 #include "migrate.h"
 
@@ -15,127 +27,307 @@
 
 #include <rsx/gcm_sys.h>
 
-// Size of migration buffer:
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+// Size of migration buffer - it's rounded up to a power of two:
 static uint32_t rsxgl_vertex_migrate_size = RSXGL_CONFIG_vertex_migrate_buffer_size, rsxgl_vertex_migrate_align = RSXGL_VERTEX_MIGRATE_BUFFER_ALIGN;
+static const uint32_t rsxgl_vertex_migrate_max_size = RSXGL_CONFIG_vertex_migrate_max_buffer_size;
+
+namespace {
+
+  struct segment_t {
+    void * address;
+
+    // Sizes are powers of two, so that positions map onto the segment as they wrap around:
+    uint32_t size;
+
+    // Position of the first byte allocated from the segment, and, once it's been replaced, the
+    // position after the last:
+    uint32_t base, retire;
+  };
+
+  struct allocation_t {
+    const void * address;
+    uint32_t end;
+    bool freed;
+  };
+
+}
+
+static segment_t rsxgl_vertex_migrate_segment = { 0, 0, 0, 0 };
+static std::vector< segment_t > rsxgl_vertex_migrate_retired;
 
-// 
-static void * _rsxgl_vertex_migrate_buffer = 0;
 static uint8_t rsxgl_vertex_migrate_sync = 0;
 
-// Head and tail position of the buffer:
-static uint32_t rsxgl_vertex_migrate_head = 0, rsxgl_vertex_migrate_tail = 0;
+// head - the position that the GPU was last seen to have finished with
+// tail - the position that the next allocation starts from
+// released - every allocation before this position has been freed
+// signalled - the position that the GPU has been told to write to the semaphore
+static uint32_t rsxgl_vertex_migrate_head = 0, rsxgl_vertex_migrate_tail = 0, rsxgl_vertex_migrate_released = 0, rsxgl_vertex_migrate_signalled = 0;
 
-// memalign/free calls do not stack - this is here to ensure that
-#if !defined(NDEBUG)
-static uint32_t rsxgl_vertex_migrate_stack = 0;
-#endif
+// Outstanding allocations, in the order that they were made:
+static std::deque< allocation_t > rsxgl_vertex_migrate_allocations;
 
-static inline
-void * rsxgl_vertex_migrate_buffer()
+// Most of the buffer that's been in use at once:
+static uint32_t rsxgl_vertex_migrate_peak = 0;
+
+// True if position is at or past target:
+static inline bool
+rsxgl_vertex_migrate_reached(const uint32_t position,const uint32_t target)
 {
-  if(_rsxgl_vertex_migrate_buffer == 0) {
-    //
+  return (int32_t)(position - target) >= 0;
+}
+
+// Smallest power of two that's at least size, or 0 if it can't be represented:
+static inline uint32_t
+rsxgl_vertex_migrate_pot(const uint32_t size)
+{
+  if(size > 0x80000000U) return 0;
+
+  uint32_t result = 1;
+  while(result < size) result <<= 1;
+  return result;
+}
+
+// The GPU isn't using any part of the current segment that's before its base:
+static inline uint32_t
+rsxgl_vertex_migrate_segment_head()
+{
+  return rsxgl_vertex_migrate_reached(rsxgl_vertex_migrate_head,rsxgl_vertex_migrate_segment.base) ? rsxgl_vertex_migrate_head : rsxgl_vertex_migrate_segment.base;
+}
+
+static inline uint32_t
+rsxgl_vertex_migrate_offset(const uint32_t position)
+{
+  return (position - rsxgl_vertex_migrate_segment.base) & (rsxgl_vertex_migrate_segment.size - 1);
+}
+
+// Replace the current segment with a new one of the given size:
+static bool
+rsxgl_vertex_migrate_segment_new(const uint32_t size)
+{
+  void * address = 0;
+
 #if (RSXGL_VERTEX_MIGRATE_BUFFER_LOCATION == RSXGL_MEMORY_LOCATION_LOCAL)
-    _rsxgl_vertex_migrate_buffer = rsxgl_rsx_memalign(rsxgl_vertex_migrate_align,rsxgl_vertex_migrate_size);
-    rsxgl_assert(_rsxgl_vertex_migrate_buffer != 0);
+  address = rsxgl_rsx_memalign(rsxgl_vertex_migrate_align,size);
 #elif (RSXGL_VERTEX_MIGRATE_BUFFER_LOCATION == RSXGL_MEMORY_LOCATION_MAIN)
-    rsxgl_assert(0);
+  rsxgl_assert(0);
 #else
-    rsxgl_assert(0);
+  rsxgl_assert(0);
 #endif
 
-    // 
+  if(address == 0) return false;
+
+  if(rsxgl_vertex_migrate_segment.address != 0) {
+    rsxgl_vertex_migrate_segment.retire = rsxgl_vertex_migrate_tail;
+    rsxgl_vertex_migrate_retired.push_back(rsxgl_vertex_migrate_segment);
+  }
+
+  rsxgl_vertex_migrate_segment.address = address;
+  rsxgl_vertex_migrate_segment.size = size;
+  rsxgl_vertex_migrate_segment.base = rsxgl_vertex_migrate_tail;
+  rsxgl_vertex_migrate_segment.retire = 0;
+
+  return true;
+}
+
+static inline void
+rsxgl_vertex_migrate_init()
+{
+  if(rsxgl_vertex_migrate_sync == 0) {
+    rsxgl_vertex_migrate_size = rsxgl_vertex_migrate_pot(rsxgl_vertex_migrate_size);
+
+    const bool created = rsxgl_vertex_migrate_segment_new(rsxgl_vertex_migrate_size);
+    rsxgl_assert(created);
+
+    //
     rsxgl_vertex_migrate_sync = rsxgl_sync_object_allocate();
     rsxgl_assert(rsxgl_vertex_migrate_sync != 0);
 
     rsxgl_sync_cpu_signal(rsxgl_vertex_migrate_sync,0);
   }
+}
+
+// Find out where the GPU has got to, and free the segments that it's finished with:
+static void
+rsxgl_vertex_migrate_update()
+{
+  // TODO - see if an actual mutex is needed here:
+  rsxgl_vertex_migrate_head = rsxgl_sync_value(rsxgl_vertex_migrate_sync);
 
-  return _rsxgl_vertex_migrate_buffer;
+  for(std::vector< segment_t >::iterator it = rsxgl_vertex_migrate_retired.begin();it != rsxgl_vertex_migrate_retired.end();) {
+    if(rsxgl_vertex_migrate_reached(rsxgl_vertex_migrate_head,it -> retire)) {
+      rsxgl_rsx_free(it -> address);
+      it = rsxgl_vertex_migrate_retired.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
 }
 
-void *
-rsxgl_ringbuffer_migrate_memalign(gcmContextData *,const rsx_size_t align,const rsx_size_t size)
+// Find the position that size bytes could be allocated from in the current segment without
+// waiting for the GPU:
+static bool
+rsxgl_vertex_migrate_fit(const rsx_size_t align,const rsx_size_t size,uint32_t & start)
 {
-  void * buffer = rsxgl_vertex_migrate_buffer();
+  if(size > rsxgl_vertex_migrate_segment.size) return false;
 
-  rsxgl_assert(buffer != 0);
-  rsxgl_assert(rsxgl_vertex_migrate_sync != 0);
+  const uint32_t offset = rsxgl_vertex_migrate_offset(rsxgl_vertex_migrate_tail);
+  const uint32_t aligned_offset = (offset + align - 1) & ~(align - 1);
+  uint32_t position = rsxgl_vertex_migrate_tail + (aligned_offset - offset);
 
-#if !defined(NDEBUG)
-  rsxgl_assert(rsxgl_vertex_migrate_stack == 0);
-  rsxgl_vertex_migrate_stack = 1;
-#endif
+  // Skip to the start of the segment:
+  if(aligned_offset + size > rsxgl_vertex_migrate_segment.size) {
+    position += rsxgl_vertex_migrate_segment.size - aligned_offset;
+  }
+
+  if((position + size - rsxgl_vertex_migrate_segment_head()) > rsxgl_vertex_migrate_segment.size) return false;
+
+  start = position;
+  return true;
+}
 
-  // TODO - Grow the ringbuffer
-  if(size > rsxgl_vertex_migrate_size) {
-    __rsxgl_assert_func(__FILE__,__LINE__,__PRETTY_FUNCTION__,"ringbuffer_migrate buffer is full, and growing it is currently unimplemented");
+void *
+rsxgl_ringbuffer_migrate_memalign(gcmContextData * context,const rsx_size_t align,const rsx_size_t size)
+{
+  rsxgl_vertex_migrate_init();
+
+  // Could never fit:
+  if(size > rsxgl_vertex_migrate_max_size || align > (rsxgl_vertex_migrate_max_size - size)) return 0;
+
+  // Have the GPU report when it's finished with everything that's been freed since the last
+  // allocation:
+  if(rsxgl_vertex_migrate_signalled != rsxgl_vertex_migrate_released) {
+    rsxgl_emit_sync_gpu_signal_read(context,rsxgl_vertex_migrate_sync,rsxgl_vertex_migrate_released);
+    rsxgl_vertex_migrate_signalled = rsxgl_vertex_migrate_released;
   }
 
-  const uint32_t tail_mod_align = rsxgl_vertex_migrate_tail & (align - 1);
-  const uint32_t offset = (tail_mod_align != 0) ? (rsxgl_vertex_migrate_tail + align - tail_mod_align) : rsxgl_vertex_migrate_tail;
-  const uint32_t new_tail = offset + size;
+  rsxgl_vertex_migrate_update();
 
-  const bool
-    wrap = new_tail > rsxgl_vertex_migrate_size,
-    bump = (offset < rsxgl_vertex_migrate_head) && (new_tail > rsxgl_vertex_migrate_head);
+  uint32_t start = 0;
+  while(!rsxgl_vertex_migrate_fit(align,size,start)) {
+    const uint32_t current_size = rsxgl_vertex_migrate_segment.size;
 
-  if(wrap || bump) {
-    volatile uint32_t * phead = gcmGetLabelAddress(rsxgl_vertex_migrate_sync);
-    rsxgl_assert(phead != 0);
+    // If the GPU has already been passed everything that it was told to report, the space is held
+    // by allocations that haven't been freed yet, and waiting wouldn't help:
+    const bool must_grow = rsxgl_vertex_migrate_head == rsxgl_vertex_migrate_signalled;
 
-    // TODO - see if an actual mutex is needed here:
-    uint32_t head = *phead;
-    while((wrap) ? (head < size) : (head < new_tail) && (head != rsxgl_vertex_migrate_tail)) {
-      usleep(RSXGL_SYNC_SLEEP_INTERVAL);
-      head = *phead;
-    }
+    uint32_t new_size = std::min(current_size << 1,rsxgl_vertex_migrate_max_size);
+    if((size + align) > new_size) new_size = rsxgl_vertex_migrate_pot(size + align);
 
-    if(head == rsxgl_vertex_migrate_tail) {
-      rsxgl_vertex_migrate_head = 0;
-      rsxgl_vertex_migrate_tail = size;
+    if(new_size > current_size && new_size <= rsxgl_vertex_migrate_max_size && rsxgl_vertex_migrate_segment_new(new_size)) continue;
 
-      return buffer;
-    }
-    else {
-      rsxgl_vertex_migrate_head = head;
-      rsxgl_vertex_migrate_tail = (bump) ? new_tail : size;
+    if(must_grow || size > current_size) return 0;
+
+    // Wait for the GPU to give some space back:
+    rsxgl_gcm_flush(context);
+
+    const uint32_t head = rsxgl_vertex_migrate_head;
+    if(rsxgl_sync_value(rsxgl_vertex_migrate_sync) == head) {
+      rsxgl_wait_t wait;
+      rsxgl_wait_begin(&wait,RSXGL_WAIT_FOREVER);
 
-      return (uint8_t *)buffer + (wrap ? 0 : offset);
+      while(rsxgl_sync_value(rsxgl_vertex_migrate_sync) == head) {
+	rsxgl_wait_step(&wait);
+      }
+
+      rsxgl_wait_end(&wait,1);
     }
+
+    rsxgl_vertex_migrate_update();
   }
-  else {
-    rsxgl_vertex_migrate_tail = new_tail;
-    return (uint8_t *)buffer + offset;
-  }
+
+  rsxgl_vertex_migrate_tail = start + size;
+
+  const uint32_t used = rsxgl_vertex_migrate_tail - rsxgl_vertex_migrate_segment_head();
+  if(used > rsxgl_vertex_migrate_peak) rsxgl_vertex_migrate_peak = used;
+
+  void * ptr = (uint8_t *)rsxgl_vertex_migrate_segment.address + rsxgl_vertex_migrate_offset(start);
+
+  const allocation_t allocation = { ptr, rsxgl_vertex_migrate_tail, false };
+  rsxgl_vertex_migrate_allocations.push_back(allocation);
+
+  return ptr;
 }
 
 void
-rsxgl_ringbuffer_migrate_free(gcmContextData * context,const void * ptr,const rsx_size_t size)
+rsxgl_ringbuffer_migrate_free(gcmContextData *,const void * ptr,const rsx_size_t)
 {
-  rsxgl_assert(_rsxgl_vertex_migrate_buffer != 0);
   rsxgl_assert(rsxgl_vertex_migrate_sync != 0);
 
-#if !defined(NDEBUG)
-  rsxgl_assert(rsxgl_vertex_migrate_stack == 1);
-  rsxgl_vertex_migrate_stack = 0;
-#endif
+  // Allocations are usually freed in the order that they were made, so this search is short:
+  std::deque< allocation_t >::iterator it = rsxgl_vertex_migrate_allocations.begin(), it_end = rsxgl_vertex_migrate_allocations.end();
+  while(it != it_end && (it -> address != ptr || it -> freed)) ++it;
+  rsxgl_assert(it != it_end);
 
-  // TODO - see if an actual mutex is needed here:
-  const uint32_t offset = (uint8_t *)ptr - (uint8_t *)_rsxgl_vertex_migrate_buffer + size;
+  it -> freed = true;
 
-  rsxgl_emit_sync_gpu_signal_read(context,rsxgl_vertex_migrate_sync,offset);
+  while(!rsxgl_vertex_migrate_allocations.empty() && rsxgl_vertex_migrate_allocations.front().freed) {
+    rsxgl_vertex_migrate_released = rsxgl_vertex_migrate_allocations.front().end;
+    rsxgl_vertex_migrate_allocations.pop_front();
+  }
 }
 
 void
 rsxgl_ringbuffer_migrate_reset(gcmContextData * context)
 {
   if(rsxgl_vertex_migrate_sync != 0) {
+    for(std::vector< segment_t >::const_iterator it = rsxgl_vertex_migrate_retired.begin(),it_end = rsxgl_vertex_migrate_retired.end();it != it_end;++it) {
+      rsxgl_rsx_free(it -> address);
+    }
+    rsxgl_vertex_migrate_retired.clear();
+    rsxgl_vertex_migrate_allocations.clear();
+
+    rsxgl_vertex_migrate_segment.base = 0;
     rsxgl_vertex_migrate_head = 0;
     rsxgl_vertex_migrate_tail = 0;
+    rsxgl_vertex_migrate_released = 0;
+    rsxgl_vertex_migrate_signalled = 0;
+
+    rsxgl_sync_cpu_signal(rsxgl_vertex_migrate_sync,0);
+  }
+}
+
+// Total bytes handed out, counting those skipped when allocations wrap around:
+uint32_t
+rsxgl_ringbuffer_migrate_allocated()
+{
+  return rsxgl_vertex_migrate_tail;
+}
+
+void
+rsxgl_ringbuffer_migrate_info(struct rsxgl_memory_info_t * info)
+{
+  info -> size = 0;
+  info -> used = 0;
+  info -> free = 0;
+  info -> largest_free = 0;
+  info -> peak = rsxgl_vertex_migrate_peak;
+
+  if(rsxgl_vertex_migrate_sync == 0) return;
+
+  rsxgl_vertex_migrate_update();
+
+  const uint32_t size = rsxgl_vertex_migrate_segment.size, head = rsxgl_vertex_migrate_segment_head(), tail = rsxgl_vertex_migrate_tail;
+
+  info -> size = size;
+  info -> used = std::min(tail - head,size);
+  info -> free = size - info -> used;
+
+  if(info -> used == 0) {
+    info -> largest_free = size;
+  }
+  else {
+    const uint32_t head_offset = rsxgl_vertex_migrate_offset(head), tail_offset = rsxgl_vertex_migrate_offset(tail);
+    info -> largest_free = (tail_offset > head_offset) ? std::max(size - tail_offset,head_offset) : (head_offset - tail_offset);
+  }
 
-    volatile uint32_t * phead = gcmGetLabelAddress(rsxgl_vertex_migrate_sync);
-    rsxgl_assert(phead != 0);
-    *phead = 0;
+  // Segments that have been replaced, but that the GPU may still be reading from:
+  for(std::vector< segment_t >::const_iterator it = rsxgl_vertex_migrate_retired.begin(),it_end = rsxgl_vertex_migrate_retired.end();it != it_end;++it) {
+    info -> size += it -> size;
+    info -> used += it -> size;
   }
 }
@@ -41,8 +41,7 @@ extern "C" {
 # endif /* !__RSXGL_ASSERT_FUNC */
 #endif /* !NDEBUG */
 
-void _EXFUN(__rsxgl_assert_func, (const char *, int, const char *, const char *)
-	    _ATTRIBUTE ((__noreturn__)));
+void __rsxgl_assert_func(const char *, int, const char *, const char *) __attribute__((__noreturn__));
 
 #ifdef __cplusplus
 }
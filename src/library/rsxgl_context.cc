@@ -2,6 +2,10 @@
 
 #include "debug.h"
 #include "framebuffer.h"
+#include "buffer.h"
+#include "textures.h"
+#include "program.h"
+#include "command_list.h"
 #include "migrate.h"
 #include "nv40.h"
 #include "timestamp.h"
@@ -10,6 +14,7 @@
 
 #include <GL3/gl3.h>
 #include "GL3/rsxgl.h"
+#include "error.h"
 
 #include <rsx/gcm_sys.h>
 
@@ -26,6 +31,9 @@ extern "C" {
 
 rsxgl_context_t * rsxgl_ctx = 0;
 
+// Defined in egl.c:
+extern "C" struct rsxgl_init_parameters_t rsxgl_init_parameters;
+
 extern "C"
 void *
 rsxgl_context_create(const struct rsxegl_config_t * config,gcmContextData * gcm_context,struct pipe_screen * screen,rsxgl_object_context_t * object_context)
@@ -42,7 +50,11 @@ rsxgl_object_context_create()
 }
 
 rsxgl_context_t::rsxgl_context_t(const struct rsxegl_config_t * config,gcmContextData * gcm_context,struct pipe_screen * screen,struct rsxgl_object_context_t * _object_context)
-  : m_object_context(_object_context), active_texture(0), any_samples_passed_query(RSXGL_MAX_QUERY_OBJECTS), ref(0), timestamp_sync(0), next_timestamp(1), last_timestamp(0), cached_timestamp(0), m_compiler_context(0)
+  : m_object_context(_object_context), active_texture(0), any_samples_passed_query(RSXGL_MAX_QUERY_OBJECTS), ref(0), timestamp_sync(0), next_timestamp(1), last_timestamp(0), pending_timestamp(0), cached_timestamp(0),
+    flush_draw_threshold(rsxgl_init_parameters.flush_draw_threshold), flush_word_threshold(rsxgl_init_parameters.flush_word_threshold), flush_vertex_threshold(rsxgl_init_parameters.flush_vertex_threshold),
+    flush_draws(0), flush_vertices(0), flush_mark(gcm_context -> current), flush_count(0),
+    command_list(0), command_list_saved_current(0), command_list_saved_end(0),
+    m_compiler_context(0)
 {
   base.api = EGL_OPENGL_API;
   base.config = config;
@@ -52,7 +64,6 @@ rsxgl_context_t::rsxgl_context_t(const struct rsxegl_config_t * config,gcmContex
   base.valid = 1;
   base.callback = rsxgl_context_t::egl_callback;
   base.screen = screen;
-  base.sync_sleep_interval = RSXGL_SYNC_SLEEP_INTERVAL;
 
   m_pctx = nvfx_create(screen,0);
   rsxgl_debug_printf("m_pctx: %lx\n",(unsigned long)m_pctx);
@@ -66,6 +77,30 @@ rsxgl_context_t::rsxgl_context_t(const struct rsxegl_config_t * config,gcmContex
   for(size_t i = 0,n = (RSXGL_MAX_TRANSFORM_FEEDBACK_BUFFER_BINDINGS + RSXGL_MAX_UNIFORM_BUFFER_BINDINGS);i < n;++i) {
     buffer_binding_offset_size[i] = std::make_pair(0,0);
   }
+
+  for(size_t i = 0;i < RSXGL_MAX_STREAM_RINGS;++i) {
+    stream_rings[i] = 0;
+  }
+}
+
+// Give back memory that the context keeps for itself, once the GPU has finished with the
+// commands that used it:
+static void
+rsxgl_context_release(rsxgl_context_t * ctx)
+{
+  rsxgl_flush(ctx);
+  if(ctx -> last_timestamp != 0) {
+    rsxgl_timestamp_wait(ctx,ctx -> last_timestamp);
+  }
+
+  // The GPU is done with all retired buffer memory; any retired by commands in an unfinished
+  // command list was never given to it:
+  for(retired_buffer_memory_list_t::const_iterator it = ctx -> retired_buffer_memory.begin(),it_end = ctx -> retired_buffer_memory.end();it != it_end;++it) {
+    rsxgl_arena_free(memory_arena_t::storage().at(it -> arena),it -> memory);
+  }
+  retired_buffer_memory_list_t().swap(ctx -> retired_buffer_memory);
+
+  rsxgl_stream_destroy(ctx);
 }
 
 rsxgl_context_t::~rsxgl_context_t()
@@ -80,7 +115,7 @@ rsxgl_context_t::~rsxgl_context_t()
   }
 }
 
-void
+int
 rsxgl_context_t::egl_callback(struct rsxegl_context_t * egl_ctx,const uint8_t op)
 {
   rsxgl_context_t * ctx = (rsxgl_context_t *)egl_ctx;
@@ -103,75 +138,86 @@ rsxgl_context_t::egl_callback(struct rsxegl_context_t * egl_ctx,const uint8_t op
 
       rsxgl_ctx = ctx;
     }
+    else {
+      // A frame has retired - reclaim the streamed buffer storage that it used:
+      rsxgl_stream_reclaim(ctx);
+    }
 
     //
-    framebuffer.invalid = 1;
-    framebuffer.invalid_complete = 1;
+    rsxgl_invalidate(ctx);
+  }
+  else if(op == RSXEGL_PRE_CPU_SWAP) {
+    // The flip mustn't end up in a command list:
+    if(ctx -> command_list != 0) {
+      RSXGL_ERROR(GL_INVALID_OPERATION,1);
+    }
 
-    ctx -> state.invalid.all = ~0;
-    ctx -> invalid.all = ~0;
-    
-    ctx -> invalid_attribs.set();
-    ctx -> invalid_textures.set();
-    ctx -> invalid_samplers.set();
+    // Let the GPU report that it's finished with everything used in this frame:
+    rsxgl_timestamp_post(ctx);
+  }
+  else if(op == RSXEGL_POST_CPU_SWAP) {
+    // eglSwapBuffers() has just flushed the command buffer:
+    ctx -> flush_draws = 0;
+    ctx -> flush_vertices = 0;
+    ctx -> flush_mark = ctx -> gcm_context() -> current;
+
+    // Once a frame, free whatever retired memory the GPU has finished with:
+    rsxgl_buffer_reclaim_memory(ctx);
+    rsxgl_reclaim_orphans(ctx);
   }
   else if(op == RSXEGL_DESTROY_CONTEXT) {
+    if(ctx -> base.valid) {
+      rsxgl_context_release(ctx);
+    }
     ctx -> base.valid = 0;
   }
+
+  return 0;
 }
 
-uint32_t
-rsxgl_timestamp_create(rsxgl_context_t * ctx,const uint32_t count)
+void
+rsxgl_invalidate(rsxgl_context_t * ctx)
 {
-  const uint32_t max_timestamp = RSXGL_MAX_TIMESTAMP;
-
-  const uint32_t current_timestamp = ctx -> next_timestamp;
-  rsxgl_assert(current_timestamp == (ctx -> last_timestamp + 1));
-
-  const uint32_t next_timestamp = current_timestamp + count;
+  framebuffer_t & framebuffer = ctx -> object_context() -> framebuffer_storage().at(0);
+  framebuffer.invalid = 1;
+  framebuffer.invalid_complete = 1;
 
-  // check for overflow:
-  if(next_timestamp > max_timestamp || next_timestamp < current_timestamp) {
-    // block until last_timestamp is reached:
-    rsxgl_timestamp_wait(ctx -> cached_timestamp,ctx -> timestamp_sync,ctx -> last_timestamp,ctx -> base.sync_sleep_interval);
+  ctx -> state.invalid.all = ~0;
+  ctx -> invalid.all = ~0;
 
-    // Buffers:
-    {
-      const buffer_t::name_type n = ctx -> object_context() -> buffer_storage().contents().size;
-      for(buffer_t::name_type i = 0;i < n;++i) {
-	if(!ctx -> object_context() -> buffer_storage().is_object(i)) continue;
-	ctx -> object_context() -> buffer_storage().at(i).timestamp = 0;
-      }
-    }
+  ctx -> registers.invalidate();
     
-    // Textures:
-    {
-      const texture_t::name_type n = ctx -> object_context() -> texture_storage().contents().size;
-      for(texture_t::name_type i = 0;i < n;++i) {
-	if(!ctx -> object_context() -> texture_storage().is_object(i)) continue;
-	ctx -> object_context() -> texture_storage().at(i).timestamp = 0;
-      }
-    }
+  ctx -> invalid_attribs.set();
+  ctx -> invalid_textures.set();
+  ctx -> invalid_samplers.set();
+}
 
-    //
-    ctx -> cached_timestamp = 0;
-    ctx -> next_timestamp = 1 + count;
-    return 1;
-  }
-  //
-  else {
-    ctx -> next_timestamp = next_timestamp;
-    return current_timestamp;
+uint32_t
+rsxgl_timestamp_create(rsxgl_context_t * ctx)
+{
+  // Everything up to the next flush shares a timestamp:
+  if(ctx -> pending_timestamp == 0) {
+    rsxgl_assert(ctx -> next_timestamp == rsxgl_timestamp_next(ctx -> last_timestamp));
+
+    // The timeline wraps around - see timestamp.h:
+    ctx -> pending_timestamp = ctx -> next_timestamp;
+    ctx -> next_timestamp = rsxgl_timestamp_next(ctx -> next_timestamp);
   }
+
+  return ctx -> pending_timestamp;
 }
 
 void
-rsxgl_timestamp_post(rsxgl_context_t * ctx,const uint32_t timestamp)
+rsxgl_timestamp_post(rsxgl_context_t * ctx)
 {
   rsxgl_assert(ctx -> timestamp_sync != 0);
 
-  rsxgl_emit_sync_gpu_signal_write(ctx -> base.gcm_context,ctx -> timestamp_sync,timestamp);
-  ctx -> last_timestamp = timestamp;
+  // Timestamps recorded into a command list would be replayed out of order:
+  if(ctx -> pending_timestamp == 0 || ctx -> command_list != 0) return;
+
+  rsxgl_emit_sync_gpu_signal_write(ctx -> base.gcm_context,ctx -> timestamp_sync,ctx -> pending_timestamp);
+  ctx -> last_timestamp = ctx -> pending_timestamp;
+  ctx -> pending_timestamp = 0;
 }
 
 void
@@ -179,8 +225,11 @@ rsxgl_timestamp_wait(rsxgl_context_t * ctx,const uint32_t timestamp)
 {
   rsxgl_assert(ctx -> timestamp_sync != 0);
 
-  rsxgl_gcm_flush(ctx -> gcm_context());
-  rsxgl_timestamp_wait(ctx -> cached_timestamp,ctx -> timestamp_sync,timestamp,ctx -> base.sync_sleep_interval);
+  // Commands that are being recorded into a command list haven't been given to the GPU:
+  if(ctx -> command_list != 0 && timestamp == ctx -> pending_timestamp) return;
+
+  rsxgl_flush(ctx);
+  rsxgl_timestamp_wait(ctx -> cached_timestamp,ctx -> timestamp_sync,timestamp,rsxgl_timestamp_issued(ctx));
 }
 
 bool
@@ -188,8 +237,111 @@ rsxgl_timestamp_passed(rsxgl_context_t * ctx,const uint32_t timestamp)
 {
   rsxgl_assert(ctx -> timestamp_sync != 0);
 
-  rsxgl_gcm_flush(ctx -> gcm_context());
-  return rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,timestamp);
+  if(ctx -> command_list != 0 && timestamp == ctx -> pending_timestamp) return true;
+
+  // Only flush if the GPU hasn't yet been told about the timestamp:
+  if(timestamp == ctx -> pending_timestamp) {
+    rsxgl_flush(ctx);
+  }
+  return rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,timestamp,rsxgl_timestamp_issued(ctx));
+}
+
+bool
+rsxgl_timestamp_busy(rsxgl_context_t * ctx,const uint32_t timestamp)
+{
+  rsxgl_assert(ctx -> timestamp_sync != 0);
+
+  return (timestamp != 0) &&
+    ((timestamp == ctx -> pending_timestamp) ||
+     !rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,timestamp,rsxgl_timestamp_issued(ctx)));
+}
+
+// Objects that lose their last reference while the GPU may still be using them are orphaned, and
+// reclaimed below:
+template< typename ObjectType >
+static inline bool
+rsxgl_object_in_use(const ObjectType & object)
+{
+  return rsxgl_ctx != 0 && rsxgl_timestamp_busy(rsxgl_ctx,object.timestamp);
+}
+
+template<>
+bool
+gl_object_in_use< buffer_t >(const buffer_t & buffer)
+{
+  return rsxgl_object_in_use(buffer);
+}
+
+template<>
+bool
+gl_object_in_use< texture_t >(const texture_t & texture)
+{
+  return rsxgl_object_in_use(texture);
+}
+
+template<>
+bool
+gl_object_in_use< renderbuffer_t >(const renderbuffer_t & renderbuffer)
+{
+  return rsxgl_object_in_use(renderbuffer);
+}
+
+template<>
+bool
+gl_object_in_use< program_t >(const program_t & program)
+{
+  return rsxgl_object_in_use(program);
+}
+
+template< typename StorageType >
+static inline void
+rsxgl_reclaim_orphans(rsxgl_context_t * ctx,StorageType & storage)
+{
+  for(typename StorageType::orphan_size_type i = 0;i < storage.num_orphans();) {
+    if(rsxgl_timestamp_busy(ctx,storage.orphan_at(i).timestamp)) {
+      ++i;
+    }
+    else {
+      // Another orphan is moved into slot i:
+      storage.destroy_orphan(i);
+    }
+  }
+}
+
+void
+rsxgl_reclaim_orphans(rsxgl_context_t * ctx)
+{
+  rsxgl_object_context_t * object_ctx = ctx -> object_context();
+
+  rsxgl_reclaim_orphans(ctx,object_ctx -> buffer_storage());
+  rsxgl_reclaim_orphans(ctx,object_ctx -> texture_storage());
+  rsxgl_reclaim_orphans(ctx,object_ctx -> program_storage());
+  rsxgl_reclaim_orphans(ctx,object_ctx -> renderbuffer_storage());
+  rsxgl_reclaim_orphans(ctx,command_list_t::storage());
+}
+
+void
+rsxgl_flush(rsxgl_context_t * ctx)
+{
+  gcmContextData * context = ctx -> gcm_context();
+
+  // While a command list is being recorded, flush the commands queued before recording began:
+  if(ctx -> command_list != 0) {
+    uint32_t * current = context -> current;
+    context -> current = ctx -> command_list_saved_current;
+    rsxgl_gcm_flush(context);
+    context -> current = current;
+    return;
+  }
+
+  rsxgl_timestamp_post(ctx);
+  rsxgl_gcm_flush(context);
+
+  ctx -> flush_draws = 0;
+  ctx -> flush_vertices = 0;
+  ctx -> flush_mark = context -> current;
+
+  rsxgl_reclaim_orphans(ctx);
 }
 
 #if 0
@@ -19,6 +19,9 @@
 #include "framebuffer.h"
 #include "sync.h"
 #include "query.h"
+#include "command_list.h"
+#include "register_cache.h"
+#include "stream.h"
 
 #include "bit_set.h"
 
@@ -37,14 +40,26 @@ public:
 
   state_t state;
 
+  // What the GPU's registers are known to hold:
+  register_cache_t registers;
+
   memory_arena_t::binding_type arena_binding;
   buffer_t::binding_type buffer_binding;
   std::pair< rsx_size_t, rsx_size_t > buffer_binding_offset_size[RSXGL_MAX_BUFFER_RANGE_TARGETS];
 
+  // Memory given up by buffers that were respecified while the GPU was using them:
+  retired_buffer_memory_list_t retired_buffer_memory;
+
+  // Storage for streamed buffers, indexed by memory location:
+  stream_ring_t * stream_rings[RSXGL_MAX_STREAM_RINGS];
+
+  // Orphaned rings, of other contexts, that this context's commands may still be using:
+  retired_stream_ring_list_t retired_stream_rings;
+
   union {
     uint8_t all;
     struct {
-      uint8_t draw_framebuffer:1, read_framebuffer:1, program:1;
+      uint8_t draw_framebuffer:1, read_framebuffer:1, program:1, vertex_cache:1, texture_cache:1;
     } parts;
   } invalid;
 
@@ -81,10 +96,30 @@ public:
   // The last timestamp that was posted to the command stream:
   uint32_t last_timestamp;
 
+  // Timestamp that objects used by commands since the last flush are tagged with, or 0 if no
+  // commands have been emitted since then. It's posted once, by the next flush:
+  uint32_t pending_timestamp;
+
   // Cached copy of the current timestamp on the GPU.
   // Should be initialized to 0:
   uint32_t cached_timestamp;
 
+  // Automatic flush policy. Thresholds are copied from rsxgl_init_parameters when the
+  // context is created; a threshold of 0 disables that test:
+  uint32_t flush_draw_threshold, flush_word_threshold, flush_vertex_threshold;
+
+  // Work submitted since the last flush, and the command buffer position at that flush:
+  uint32_t flush_draws, flush_vertices;
+  uint32_t * flush_mark;
+
+  // Number of flushes performed by rsxgl_flush_policy():
+  uint32_t flush_count;
+
+  // Command list that's being recorded (0 if none), and the command buffer position to
+  // return to when recording ends:
+  command_list_t::name_type command_list;
+  uint32_t * command_list_saved_current, * command_list_saved_end;
+
   rsxgl_context_t(const struct rsxegl_config_t *,gcmContextData *,struct pipe_screen *,struct rsxgl_object_context_t *);
   ~rsxgl_context_t();
 
@@ -121,7 +156,7 @@ public:
     return m_compiler_context;
   }
 
-  static void egl_callback(rsxegl_context_t *,const uint8_t);
+  static int egl_callback(rsxegl_context_t *,const uint8_t);
   static void timestamp_overflow(void *);
 };
 
@@ -141,9 +176,57 @@ current_object_ctx()
   return rsxgl_ctx -> object_context();
 }
 
-uint32_t rsxgl_timestamp_create(rsxgl_context_t *,const uint32_t);
+// Timestamp to tag objects used by the commands that are about to be emitted with:
+uint32_t rsxgl_timestamp_create(rsxgl_context_t *);
 void rsxgl_timestamp_wait(rsxgl_context_t *,const uint32_t);
 bool rsxgl_timestamp_passed(rsxgl_context_t *,const uint32_t);
-void rsxgl_timestamp_post(rsxgl_context_t *,const uint32_t);
+
+// Like !rsxgl_timestamp_passed(), but never flushes - a timestamp that the GPU hasn't been given
+// yet is simply busy:
+bool rsxgl_timestamp_busy(rsxgl_context_t *,const uint32_t);
+
+// Emit the pending timestamp, if there is one. Called by rsxgl_flush:
+void rsxgl_timestamp_post(rsxgl_context_t *);
+
+// The most recent timestamp that was handed out - the end of the window of timestamps that the
+// GPU may not have reached yet:
+static inline uint32_t
+rsxgl_timestamp_issued(const rsxgl_context_t * ctx)
+{
+  return (ctx -> pending_timestamp != 0) ? ctx -> pending_timestamp : ctx -> last_timestamp;
+}
+
+void rsxgl_flush(rsxgl_context_t *);
+
+// Destroy deleted objects that were orphaned because the GPU was still using them, once the GPU
+// has finished with them. Called by rsxgl_flush and once per frame:
+void rsxgl_reclaim_orphans(rsxgl_context_t *);
+
+// Mark all state as needing to be sent to the GPU again:
+void rsxgl_invalidate(rsxgl_context_t *);
+
+// Called by functions that emit commands, after they've done so. Flushes the command buffer
+// if any of the context's flush thresholds have been crossed:
+static inline void
+rsxgl_flush_policy(rsxgl_context_t * ctx,const uint32_t draws,const uint32_t vertices)
+{
+  // Nothing gets submitted while a command list is being recorded:
+  if(ctx -> command_list != 0) return;
+
+  ctx -> flush_draws += draws;
+  ctx -> flush_vertices += vertices;
+
+  const gcmContextData * context = ctx -> gcm_context();
+
+  // The command buffer may have been reset to its beginning since the last flush:
+  const uint32_t words = (context -> current >= ctx -> flush_mark) ? (context -> current - ctx -> flush_mark) : (context -> current - context -> begin);
+
+  if((ctx -> flush_draw_threshold != 0 && ctx -> flush_draws >= ctx -> flush_draw_threshold) ||
+     (ctx -> flush_word_threshold != 0 && words >= ctx -> flush_word_threshold) ||
+     (ctx -> flush_vertex_threshold != 0 && ctx -> flush_vertices >= ctx -> flush_vertex_threshold)) {
+    rsxgl_flush(ctx);
+    ++ctx -> flush_count;
+  }
+}
 
 #endif
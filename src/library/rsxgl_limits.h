@@ -11,6 +11,20 @@
 #define RSXGL_MEMORY_LOCATION_LOCAL 0
 #define RSXGL_MEMORY_LOCATION_MAIN 1
 
+// One streaming ring for each of the above:
+#define RSXGL_MAX_STREAM_RINGS 2
+
+// With buffer migration enabled, a buffer in local memory moves to main memory once the CPU has
+// written to it, or read from it, this many times:
+#define RSXGL_BUFFER_MIGRATE_WRITES 8
+#define RSXGL_BUFFER_MIGRATE_READS 2
+
+// Arenas serve allocations of up to 1 << RSXGL_SLAB_MAX_BLOCK_BITS bytes from slabs of
+// RSXGL_SLAB_SIZE bytes. The smallest block is one RSX cache line:
+#define RSXGL_SLAB_SIZE (64 * 1024)
+#define RSXGL_SLAB_MIN_BLOCK_BITS 7
+#define RSXGL_SLAB_MAX_BLOCK_BITS 14
+
 // Limits of the hardware (Cell & RSX) go here. These shouldn't be changed:
 #define RSXGL_CACHE_LINE_SIZE 128
 #define RSXGL_CACHE_LINE_BITS 7
@@ -46,20 +60,44 @@
 
 #define RSXGL_MAX_QUERIES 65536
 
-// For glFinish, number of iterations to wait before giving up on the GPU.
-#define RSXGL_FINISH_SLEEP_ITERATIONS 100000
+#define RSXGL_MAX_COMMAND_LISTS 4096
+
+#define RSXGL_MAX_FENCES 65536
+
+// Length, in words, of the segments that command lists are recorded into:
+#define RSXGL_COMMAND_LIST_SEGMENT_LENGTH 4096
 
-// Time interval, in microseconds, to sleep while waiting to sync with the RSX
+// For glFinish, time in microseconds to wait before giving up on the GPU.
+#define RSXGL_FINISH_TIMEOUT 3000000
+
+// Time interval, in microseconds, used by eglSwapBuffers to compute its timeout
 #define RSXGL_SYNC_SLEEP_INTERVAL 30
 
+// While waiting to sync with the RSX: time to poll before sleeping, and the shortest and longest
+// intervals to sleep for, in microseconds. Sleeps double in length each time.
+#define RSXGL_WAIT_SPIN_TIME 10
+#define RSXGL_WAIT_MIN_SLEEP 2
+#define RSXGL_WAIT_MAX_SLEEP 100
+
 #define RSXGL_VERTEX_MIGRATE_BUFFER_ALIGN 16
 #define RSXGL_VERTEX_MIGRATE_BUFFER_LOCATION 0
 
+// Client-side index arrays that can be sent in this many command buffer words, or fewer, are
+// written into the command buffer instead of being copied to the vertex migration buffer:
+#define RSXGL_INLINE_INDEX_MAX_WORDS 64
+
+// Number of client-side vertex array uploads that are kept around to be reused by later draws:
+#define RSXGL_CLIENT_ARRAY_CACHE_SIZE 32
+
+// Number of scanned index ranges that each buffer remembers:
+#define RSXGL_BUFFER_ELEMENT_RANGES 4
+
 #define RSXGL_TEXTURE_MIGRATE_BUFFER_ALIGN 1024 * 1024
 #define RSXGL_TEXTURE_MIGRATE_BUFFER_LOCATION 1
 
 // Maximum value for a drawing timestamp. It's set this way so that GL objects
 // can have 1 bit for a deleted flag, and the remaining 31 bits for a timestamp.
+// Timestamps wrap around to 1 after this value (see timestamp.h).
 #define RSXGL_MAX_TIMESTAMP (((uint32_t)1 << 31) - 1)
 
 #endif
@@ -30,6 +30,6 @@ rsxgl_init_default_framebuffer(void * ptr)
 }
 
 rsxgl_object_context_t::rsxgl_object_context_t()
-  : m_refCount(0), m_arena_storage(0,rsxgl_init_default_arena), m_attribs_storage(0,0), m_sampler_storage(0,0), m_texture_storage(0,0), m_framebuffer_storage(0,rsxgl_init_default_framebuffer)
+  : m_refCount(0), main_buffer_arena(0), main_buffer_arena_created(0), m_arena_storage(0,rsxgl_init_default_arena), m_attribs_storage(0,0), m_sampler_storage(0,0), m_texture_storage(0,0), m_framebuffer_storage(0,rsxgl_init_default_framebuffer)
 {
 }
@@ -15,6 +15,10 @@
 struct rsxgl_object_context_t {
   uint32_t m_refCount;
 
+  // Arena in main memory for buffers that are placed there; created when it's first needed:
+  memory_arena_t::name_type main_buffer_arena;
+  uint8_t main_buffer_arena_created:1;
+
   rsxgl_object_context_t();
 
   inline
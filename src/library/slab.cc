@@ -0,0 +1,191 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// slab.cc - Size-class allocator for small allocations from a memory arena.
+
+#include "slab.h"
+#include "rsxgl_assert.h"
+#include "rsxgl_limits.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace {
+
+  const size_t slab_classes = RSXGL_SLAB_MAX_BLOCK_BITS - RSXGL_SLAB_MIN_BLOCK_BITS + 1;
+
+  struct slab_t {
+    uint8_t * address;
+    uint8_t size_class;
+
+    // Indices of free blocks; the last one is allocated next:
+    std::vector< uint16_t > free_blocks;
+
+    // Links in the list of slabs of the same size class that have free blocks:
+    slab_t * prev, * next;
+
+    slab_t(uint8_t * _address,const uint8_t _size_class)
+      : address(_address), size_class(_size_class), prev(0), next(0) {
+      const uint16_t nblocks = RSXGL_SLAB_SIZE >> (RSXGL_SLAB_MIN_BLOCK_BITS + size_class);
+      free_blocks.reserve(nblocks);
+      for(uint16_t i = nblocks;i > 0;--i) {
+	free_blocks.push_back(i - 1);
+      }
+    }
+
+    uint16_t nblocks() const {
+      return RSXGL_SLAB_SIZE >> (RSXGL_SLAB_MIN_BLOCK_BITS + size_class);
+    }
+  };
+
+}
+
+struct slab_allocator_t {
+  mspace space;
+
+  slab_t * available[slab_classes];
+
+  // Slabs are aligned to their size, so the slab that a block belongs to can be found from the
+  // block's address. One entry for each RSXGL_SLAB_SIZE bytes of the mspace's memory, starting
+  // with the one that contains first:
+  uintptr_t first;
+  std::vector< slab_t * > slabs;
+
+  slab_allocator_t(mspace _space,void * address,const rsx_size_t size)
+    : space(_space), first((uintptr_t)address / RSXGL_SLAB_SIZE), slabs((((uintptr_t)address + size + RSXGL_SLAB_SIZE - 1) / RSXGL_SLAB_SIZE) - first,(slab_t *)0) {
+    for(size_t i = 0;i < slab_classes;++i) {
+      available[i] = 0;
+    }
+  }
+};
+
+// Entry in the slabs table for ptr; the table's size if ptr isn't in the mspace's memory:
+static inline size_t
+rsxgl_slab_index(const slab_allocator_t * allocator,const void * ptr)
+{
+  const uintptr_t key = (uintptr_t)ptr / RSXGL_SLAB_SIZE;
+  return (key >= allocator -> first) ? std::min((size_t)(key - allocator -> first),allocator -> slabs.size()) : allocator -> slabs.size();
+}
+
+static inline slab_t *
+rsxgl_slab_find(const slab_allocator_t * allocator,const void * ptr)
+{
+  const size_t i = rsxgl_slab_index(allocator,ptr);
+  return (i < allocator -> slabs.size()) ? allocator -> slabs[i] : 0;
+}
+
+static inline void
+rsxgl_slab_link(slab_allocator_t * allocator,slab_t * slab)
+{
+  slab_t * & head = allocator -> available[slab -> size_class];
+  slab -> prev = 0;
+  slab -> next = head;
+  if(head != 0) head -> prev = slab;
+  head = slab;
+}
+
+static inline void
+rsxgl_slab_unlink(slab_allocator_t * allocator,slab_t * slab)
+{
+  if(slab -> prev != 0) {
+    slab -> prev -> next = slab -> next;
+  }
+  else {
+    allocator -> available[slab -> size_class] = slab -> next;
+  }
+  if(slab -> next != 0) slab -> next -> prev = slab -> prev;
+
+  slab -> prev = 0;
+  slab -> next = 0;
+}
+
+slab_allocator_t *
+rsxgl_slab_allocator_create(mspace space,void * address,const rsx_size_t size)
+{
+  return new slab_allocator_t(space,address,size);
+}
+
+void
+rsxgl_slab_allocator_destroy(slab_allocator_t * allocator)
+{
+  for(std::vector< slab_t * >::const_iterator it = allocator -> slabs.begin(),it_end = allocator -> slabs.end();it != it_end;++it) {
+    if(*it == 0) continue;
+    rsxgl_mspace_free(allocator -> space,(*it) -> address);
+    delete *it;
+  }
+  delete allocator;
+}
+
+void *
+rsxgl_slab_allocate(slab_allocator_t * allocator,const rsx_size_t align,const rsx_size_t size,rsx_size_t & block_size)
+{
+  const rsx_size_t request_size = std::max(size,align);
+  if(request_size == 0 || request_size > (1 << RSXGL_SLAB_MAX_BLOCK_BITS)) return 0;
+
+  uint8_t size_class = 0;
+  while(((rsx_size_t)1 << (RSXGL_SLAB_MIN_BLOCK_BITS + size_class)) < request_size) {
+    ++size_class;
+  }
+
+  slab_t * slab = allocator -> available[size_class];
+
+  if(slab == 0) {
+    uint8_t * address = (uint8_t *)rsxgl_mspace_memalign(allocator -> space,RSXGL_SLAB_SIZE,RSXGL_SLAB_SIZE);
+    if(address == 0) return 0;
+
+    const size_t index = rsxgl_slab_index(allocator,address);
+    rsxgl_assert(index < allocator -> slabs.size());
+
+    slab = new slab_t(address,size_class);
+    allocator -> slabs[index] = slab;
+    rsxgl_slab_link(allocator,slab);
+  }
+
+  const uint16_t i = slab -> free_blocks.back();
+  slab -> free_blocks.pop_back();
+
+  if(slab -> free_blocks.empty()) {
+    rsxgl_slab_unlink(allocator,slab);
+  }
+
+  block_size = (rsx_size_t)1 << (RSXGL_SLAB_MIN_BLOCK_BITS + size_class);
+  return slab -> address + ((size_t)i << (RSXGL_SLAB_MIN_BLOCK_BITS + size_class));
+}
+
+bool
+rsxgl_slab_owns(slab_allocator_t * allocator,const void * ptr)
+{
+  return rsxgl_slab_find(allocator,ptr) != 0;
+}
+
+rsx_size_t
+rsxgl_slab_free(slab_allocator_t * allocator,void * ptr)
+{
+  const size_t index = rsxgl_slab_index(allocator,ptr);
+  if(index == allocator -> slabs.size() || allocator -> slabs[index] == 0) return 0;
+
+  slab_t * slab = allocator -> slabs[index];
+  const rsx_size_t block_size = (rsx_size_t)1 << (RSXGL_SLAB_MIN_BLOCK_BITS + slab -> size_class);
+  const uint16_t i = ((uint8_t *)ptr - slab -> address) >> (RSXGL_SLAB_MIN_BLOCK_BITS + slab -> size_class);
+  rsxgl_assert(i < slab -> nblocks());
+
+  const bool was_full = slab -> free_blocks.empty();
+  slab -> free_blocks.push_back(i);
+
+  if(was_full) {
+    rsxgl_slab_link(allocator,slab);
+  }
+  // Give an empty slab back to the mspace, unless it's the only one of its size class that has
+  // room - keeping that one avoids thrashing when a single block is allocated & freed repeatedly:
+  else if(slab -> free_blocks.size() == slab -> nblocks() && (slab -> prev != 0 || slab -> next != 0)) {
+    rsxgl_slab_unlink(allocator,slab);
+    allocator -> slabs[index] = 0;
+    rsxgl_mspace_free(allocator -> space,slab -> address);
+    delete slab;
+  }
+
+  return block_size;
+}
@@ -0,0 +1,36 @@
+//-*-C++-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// slab.h - Size-class allocator for small allocations from a memory arena.
+//
+// Small allocations are carved out of 64KB slabs that are themselves allocated from the arena's
+// mspace. Each slab holds blocks of a single power-of-two size, from one cache line (128 bytes)
+// up to 16KB; blocks are aligned to their size. Everything that the allocator
+// knows about its slabs is kept in main memory, so allocating and freeing blocks never touches
+// RSX memory, and takes constant time. The slab that a block belongs to is found by indexing a
+// table that covers the arena's memory.
+
+#ifndef rsxgl_slab_H
+#define rsxgl_slab_H
+
+#include "mem.h"
+
+struct slab_allocator_t;
+
+// The mspace manages the size bytes of memory at address:
+slab_allocator_t * rsxgl_slab_allocator_create(mspace,void * address,const rsx_size_t size);
+void rsxgl_slab_allocator_destroy(slab_allocator_t *);
+
+// Returns 0 if the request is too large for a slab, or if no slab could be had. Otherwise sets
+// block_size to the size of the block that was allocated:
+void * rsxgl_slab_allocate(slab_allocator_t *,const rsx_size_t align,const rsx_size_t size,rsx_size_t & block_size);
+
+// Returns true if ptr lies in one of the allocator's slabs:
+bool rsxgl_slab_owns(slab_allocator_t *,const void * ptr);
+
+// Returns the size of the block that was freed; 0 if ptr wasn't allocated from a slab:
+rsx_size_t rsxgl_slab_free(slab_allocator_t *,void * ptr);
+
+#endif
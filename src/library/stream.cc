@@ -0,0 +1,352 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// stream.cc - Rings of GPU-visible memory that storage for streamed buffers is sub-allocated from.
+
+#include "stream.h"
+#include "rsxgl_context.h"
+#include "rsxgl_config.h"
+#include "debug.h"
+
+#include <rsx/gcm_sys.h>
+
+#include <malloc.h>
+
+#include <algorithm>
+
+// Main memory is mapped for the RSX in units of 1MB:
+static const rsx_size_t rsxgl_stream_main_align = 1024 * 1024;
+
+// Give the ring some memory, and an arena that describes it:
+static stream_ring_t *
+rsxgl_stream_create(const uint32_t location)
+{
+  rsx_size_t size = RSXGL_CONFIG_stream_buffer_size;
+  void * address = 0;
+  uint32_t offset = 0;
+
+  if(location == RSXGL_MEMORY_LOCATION_LOCAL) {
+    address = rsxgl_rsx_memalign(128,size);
+    if(address == 0) return 0;
+
+    gcmAddressToOffset(address,&offset);
+  }
+  else if(location == RSXGL_MEMORY_LOCATION_MAIN) {
+    size = (size + rsxgl_stream_main_align - 1) & ~(rsxgl_stream_main_align - 1);
+    address = memalign(rsxgl_stream_main_align,size);
+    if(address == 0) return 0;
+
+    if(gcmMapMainMemory(address,size,&offset) != 0) {
+      free(address);
+      return 0;
+    }
+  }
+  else {
+    return 0;
+  }
+
+  stream_ring_t * ring = new stream_ring_t;
+
+  // The arena has no mspace - only the ring allocates from it. rsxgl_arena_is_object() keeps the
+  // application from using it:
+  const memory_arena_t::name_type name = memory_arena_t::storage().create_name_and_object();
+  memory_arena_t & arena = memory_arena_t::storage().at(name);
+
+  arena.address = address;
+  arena.space = 0;
+  arena.memory.location = location;
+  arena.memory.offset = offset;
+  arena.size = size;
+  arena.ring = ring;
+
+  ring -> arena = name;
+  ring -> size = size;
+
+  return ring;
+}
+
+// Destroying the arena gives the ring's memory back:
+static void
+rsxgl_stream_destroy(stream_ring_t * ring)
+{
+  memory_arena_t::storage().destroy(ring -> arena);
+  delete ring;
+}
+
+static inline void
+rsxgl_stream_maybe_destroy(stream_ring_t * ring)
+{
+  if(ring -> orphaned && ring -> live == 0 && ring -> retiring == 0) {
+    rsxgl_stream_destroy(ring);
+  }
+}
+
+// Drop the context's hold on orphaned rings whose pieces the GPU is done with. If all is true,
+// the GPU has finished with all of the context's commands:
+static void
+rsxgl_stream_retire(rsxgl_context_t * ctx,const bool all)
+{
+  retired_stream_ring_list_t & retired = ctx -> retired_stream_rings;
+
+  retired_stream_ring_list_t::iterator it = retired.begin(), it_end = retired.end(), jt = retired.begin();
+  for(;it != it_end;++it) {
+    if(all || !rsxgl_timestamp_busy(ctx,it -> timestamp)) {
+      --it -> ring -> retiring;
+      rsxgl_stream_maybe_destroy(it -> ring);
+    }
+    else {
+      *jt++ = *it;
+    }
+  }
+
+  retired.erase(jt,it_end);
+}
+
+static inline bool
+rsxgl_stream_allocation_before(const stream_ring_t::allocation_t & lhs,const stream_ring_t::allocation_t & rhs)
+{
+  return lhs.start < rhs.start;
+}
+
+// Find room for size bytes between from and limit, stepping over held pieces:
+static inline bool
+rsxgl_stream_find(const stream_ring_t & ring,const rsx_size_t from,const rsx_size_t limit,const rsx_size_t align,const rsx_size_t size,rsx_size_t & start)
+{
+  rsx_size_t aligned = (from + align - 1) & ~(align - 1);
+
+  for(stream_ring_t::held_type::const_iterator it = ring.held.begin(),it_end = ring.held.end();it != it_end && it -> start < (aligned + size);++it) {
+    if(it -> end > aligned) aligned = (it -> end + align - 1) & ~(align - 1);
+  }
+
+  if(aligned > limit || (limit - aligned) < size) return false;
+
+  start = aligned;
+  return true;
+}
+
+// The free space runs from the tail, around the end of the ring if need be, to the head:
+static inline bool
+rsxgl_stream_find(const stream_ring_t & ring,const rsx_size_t align,const rsx_size_t size,rsx_size_t & start)
+{
+  if(ring.allocations.empty()) {
+    return rsxgl_stream_find(ring,ring.tail,ring.size,align,size,start) || rsxgl_stream_find(ring,0,ring.tail,align,size,start);
+  }
+  else if(ring.tail < ring.head) {
+    return rsxgl_stream_find(ring,ring.tail,ring.head,align,size,start);
+  }
+  else if(ring.tail > ring.head) {
+    return rsxgl_stream_find(ring,ring.tail,ring.size,align,size,start) || rsxgl_stream_find(ring,0,ring.head,align,size,start);
+  }
+  else {
+    return false;
+  }
+}
+
+// Advance the head over the pieces that the GPU is done with, setting aside those that are still
+// held:
+static inline void
+rsxgl_stream_reclaim(rsxgl_context_t * ctx,stream_ring_t & ring)
+{
+  for(stream_ring_t::held_type::iterator it = ring.held.begin();it != ring.held.end();) {
+    if(!it -> live && !rsxgl_timestamp_busy(ctx,it -> timestamp)) {
+      rsxgl_memory_usage_free(&ring.usage,it -> end - it -> start);
+      it = ring.held.erase(it);
+    }
+    else {
+      ++it;
+    }
+  }
+
+  while(!ring.allocations.empty()) {
+    const stream_ring_t::allocation_t & allocation = ring.allocations.front();
+
+    if(allocation.live) {
+      ring.held.insert(std::upper_bound(ring.held.begin(),ring.held.end(),allocation,rsxgl_stream_allocation_before),allocation);
+    }
+    else if(rsxgl_timestamp_busy(ctx,allocation.timestamp)) {
+      break;
+    }
+    else {
+      rsxgl_memory_usage_free(&ring.usage,allocation.end - allocation.start);
+    }
+
+    ring.allocations.pop_front();
+  }
+
+  ring.head = ring.allocations.empty() ? ring.tail : ring.allocations.front().start;
+}
+
+memory_t
+rsxgl_stream_allocate(rsxgl_context_t * ctx,const uint32_t location,const rsx_size_t align,const rsx_size_t size,memory_arena_t::name_type & arena,void ** address)
+{
+  rsxgl_assert(location < RSXGL_MAX_STREAM_RINGS);
+  if(ctx -> stream_rings[location] == 0) {
+    ctx -> stream_rings[location] = rsxgl_stream_create(location);
+    if(ctx -> stream_rings[location] == 0) return memory_t();
+  }
+  stream_ring_t & ring = *ctx -> stream_rings[location];
+
+  if(size == 0 || size > ring.size) {
+    return memory_t();
+  }
+
+  rsx_size_t start = 0;
+  if(!rsxgl_stream_find(ring,align,size,start)) {
+    rsxgl_stream_reclaim(ctx,ring);
+
+    if(!rsxgl_stream_find(ring,align,size,start)) {
+      return memory_t();
+    }
+  }
+
+  stream_ring_t::allocation_t allocation;
+  allocation.start = start;
+  allocation.end = start + size;
+  allocation.live = 1;
+  allocation.timestamp = 0;
+  ring.allocations.push_back(allocation);
+
+  if(ring.allocations.size() == 1) ring.head = start;
+  ring.tail = allocation.end;
+  ++ring.live;
+  rsxgl_memory_usage_allocate(&ring.usage,size);
+
+  memory_arena_t & ring_arena = memory_arena_t::storage().at(ring.arena);
+  const memory_t memory(ring_arena.memory.location,ring_arena.memory.offset + start,1);
+
+  arena = ring.arena;
+  if(address != 0) *address = rsxgl_arena_address(ring_arena,memory);
+
+  return memory;
+}
+
+// Pieces are usually given back soon after they're taken, so look from the newest:
+template< typename Iterator >
+static inline Iterator
+rsxgl_stream_find_live(Iterator it,const Iterator it_end,const rsx_size_t start)
+{
+  for(;it != it_end && (it -> start != start || !it -> live);++it);
+  return it;
+}
+
+void
+rsxgl_stream_free(rsxgl_context_t * ctx,const memory_arena_t::name_type arena,const memory_t & memory,const uint32_t timestamp)
+{
+  const memory_arena_t & ring_arena = memory_arena_t::storage().at(arena);
+  rsxgl_assert(ring_arena.ring != 0);
+  stream_ring_t & ring = *ring_arena.ring;
+
+  const rsx_size_t start = memory.offset - ring_arena.memory.offset;
+  stream_ring_t::allocation_t * allocation = 0;
+
+  stream_ring_t::allocations_type::reverse_iterator it = rsxgl_stream_find_live(ring.allocations.rbegin(),ring.allocations.rend(),start);
+  if(it != ring.allocations.rend()) {
+    allocation = &*it;
+  }
+  else {
+    stream_ring_t::held_type::iterator jt = rsxgl_stream_find_live(ring.held.begin(),ring.held.end(),start);
+    if(jt != ring.held.end()) allocation = &*jt;
+  }
+
+  if(allocation == 0) {
+    rsxgl_debug_printf("%s: memory at %u wasn't taken from its ring\n",__PRETTY_FUNCTION__,memory.offset);
+    return;
+  }
+
+  allocation -> live = 0;
+  allocation -> timestamp = timestamp;
+  --ring.live;
+
+  if(!ring.orphaned) return;
+
+  // The context that the ring belonged to waited for the GPU before it went away, but a context
+  // that shares its objects may still be drawing with the piece:
+  if(ctx != 0 && rsxgl_timestamp_busy(ctx,timestamp)) {
+    retired_stream_ring_t retired;
+    retired.ring = &ring;
+    retired.timestamp = timestamp;
+    ctx -> retired_stream_rings.push_back(retired);
+    ++ring.retiring;
+  }
+
+  rsxgl_stream_maybe_destroy(&ring);
+}
+
+void
+rsxgl_stream_reclaim(rsxgl_context_t * ctx)
+{
+  for(size_t i = 0;i < RSXGL_MAX_STREAM_RINGS;++i) {
+    if(ctx -> stream_rings[i] != 0) rsxgl_stream_reclaim(ctx,*ctx -> stream_rings[i]);
+  }
+
+  rsxgl_stream_retire(ctx,false);
+}
+
+void
+rsxgl_stream_destroy(rsxgl_context_t * ctx)
+{
+  rsxgl_stream_retire(ctx,true);
+
+  for(size_t i = 0;i < RSXGL_MAX_STREAM_RINGS;++i) {
+    stream_ring_t * ring = ctx -> stream_rings[i];
+    if(ring == 0) continue;
+
+    if(ring -> live == 0) {
+      rsxgl_stream_destroy(ring);
+    }
+    else {
+      ring -> orphaned = true;
+    }
+
+    ctx -> stream_rings[i] = 0;
+  }
+}
+
+// Largest gap between from and limit that isn't held:
+static inline rsx_size_t
+rsxgl_stream_largest_free(const stream_ring_t & ring,rsx_size_t from,const rsx_size_t limit)
+{
+  rsx_size_t largest = 0;
+  for(stream_ring_t::held_type::const_iterator it = ring.held.begin(),it_end = ring.held.end();it != it_end && it -> start < limit;++it) {
+    if(it -> end <= from) continue;
+    if(it -> start > from) largest = std::max(largest,it -> start - from);
+    from = it -> end;
+  }
+  if(limit > from) largest = std::max(largest,limit - from);
+  return largest;
+}
+
+void
+rsxgl_stream_info(rsxgl_context_t * ctx,const uint32_t location,rsxgl_memory_info_t * info)
+{
+  rsxgl_assert(location < RSXGL_MAX_STREAM_RINGS);
+  if(ctx -> stream_rings[location] == 0) {
+    info -> size = 0;
+    info -> used = 0;
+    info -> free = 0;
+    info -> peak = 0;
+    info -> largest_free = 0;
+    return;
+  }
+  const stream_ring_t & ring = *ctx -> stream_rings[location];
+
+  info -> size = ring.size;
+  info -> used = ring.usage.used;
+  info -> free = ring.size - ring.usage.used;
+  info -> peak = ring.usage.peak;
+
+  // Pieces that have been given back, but that haven't been reclaimed yet, still count as taken:
+  if(ring.allocations.empty()) {
+    info -> largest_free = std::max(rsxgl_stream_largest_free(ring,ring.tail,ring.size),rsxgl_stream_largest_free(ring,0,ring.tail));
+  }
+  else if(ring.tail < ring.head) {
+    info -> largest_free = rsxgl_stream_largest_free(ring,ring.tail,ring.head);
+  }
+  else if(ring.tail > ring.head) {
+    info -> largest_free = std::max(rsxgl_stream_largest_free(ring,ring.tail,ring.size),rsxgl_stream_largest_free(ring,0,ring.head));
+  }
+  else {
+    info -> largest_free = 0;
+  }
+}
@@ -0,0 +1,98 @@
+//-*-C++-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// stream.h - Rings of GPU-visible memory that storage for GL_STREAM_DRAW and GL_DYNAMIC_DRAW
+// buffers is sub-allocated from.
+//
+// Pieces are taken from the tail of the ring, in order, wrapping around to the start. A piece
+// that's been given back is reclaimed once the GPU has passed the timestamp of the last commands
+// that used it, and the head of the ring advances over it. A piece that's still held when the
+// head reaches it (by a buffer that isn't respecified again, say) is set aside, and the tail steps
+// over it, so that it doesn't stop the space after it from being reused. A ring is never waited
+// on - if it's full, the caller falls back to allocating from an arena.
+
+#ifndef rsxgl_stream_H
+#define rsxgl_stream_H
+
+#include "arena.h"
+
+#include <deque>
+#include <vector>
+
+struct stream_ring_t {
+  // Internal arena that describes the ring's memory, so that memory allocated from the ring can
+  // be addressed like any other:
+  memory_arena_t::name_type arena;
+  rsx_size_t size;
+
+  // Offsets from the start of the ring:
+  struct allocation_t {
+    rsx_size_t start, end;
+    uint32_t live:1, timestamp:31;
+  };
+
+  // Pieces between the head and the tail, in the order that they were taken:
+  typedef std::deque< allocation_t > allocations_type;
+  allocations_type allocations;
+
+  // Pieces that the head has passed while they were held, sorted by offset:
+  typedef std::vector< allocation_t > held_type;
+  held_type held;
+
+  // head - where the oldest piece that hasn't been reclaimed starts
+  // tail - where the next piece is taken from
+  rsx_size_t head, tail;
+
+  // Pieces that haven't been given back:
+  size_t live;
+
+  // Set once the context that the ring belongs to is gone. The ring is destroyed when its last
+  // piece is given back, and no other context is waiting for the GPU to finish with a piece:
+  bool orphaned;
+
+  // Entries for the ring on contexts' retired_stream_rings lists:
+  size_t retiring;
+
+  // Bytes held by the allocations:
+  rsxgl_memory_usage_t usage;
+
+  stream_ring_t()
+    : arena(0), size(0), head(0), tail(0), live(0), orphaned(false), retiring(0) {
+    usage.used = 0;
+    usage.peak = 0;
+  }
+};
+
+// A piece of an orphaned ring that a context gave back while its commands were still using it.
+// The ring is kept until the GPU has passed the context's timestamp:
+struct retired_stream_ring_t {
+  stream_ring_t * ring;
+  uint32_t timestamp;
+};
+
+typedef std::vector< retired_stream_ring_t > retired_stream_ring_list_t;
+
+struct rsxgl_context_t;
+
+// Allocate size bytes from the ring for the given memory location. Returns a null memory_t if
+// the ring doesn't have room; sets arena to the arena that the memory is addressed through:
+memory_t rsxgl_stream_allocate(rsxgl_context_t *,const uint32_t location,const rsx_size_t align,const rsx_size_t size,memory_arena_t::name_type & arena,void ** address = 0);
+
+// Give memory back to the ring that it came from; arena is the one that rsxgl_stream_allocate
+// returned. timestamp is that of the last commands that used it, issued by ctx - which may be
+// another context than the one that the ring belongs to, or 0 if there's no current context:
+void rsxgl_stream_free(rsxgl_context_t * ctx,const memory_arena_t::name_type arena,const memory_t &,const uint32_t timestamp);
+
+// Reclaim memory that's been given back & that the GPU is done with, and destroy orphaned rings
+// that the context's commands were the last to use:
+void rsxgl_stream_reclaim(rsxgl_context_t *);
+
+// The context is going away, and the GPU has finished with its commands. Rings that no longer
+// have pieces taken are destroyed; the others are destroyed once the pieces are given back:
+void rsxgl_stream_destroy(rsxgl_context_t *);
+
+void rsxgl_stream_info(rsxgl_context_t *,const uint32_t location,rsxgl_memory_info_t *);
+
+#endif
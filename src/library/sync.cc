@@ -5,6 +5,7 @@
 // sync.cc - Implement the glFlush and glFinish functions, and OpenGL synchronization objects.
 
 #include "sync.h"
+#include "timestamp.h"
 
 #include "gl_fifo.h"
 #include "rsxgl_assert.h"
@@ -16,6 +17,7 @@
 #include "gl_object.h"
 
 #include <GL3/gl3.h>
+#include "GL3/rsxgl3ext.h"
 #include "error.h"
 
 #if defined(GLAPI)
@@ -23,12 +25,6 @@
 #endif
 #define GLAPI extern "C"
 
-static inline void
-rsxgl_flush(rsxgl_context_t * ctx)
-{
-  rsxgl_gcm_flush(ctx -> gcm_context());
-}
-
 GLAPI void APIENTRY
 glFlush (void)
 {
@@ -42,6 +38,11 @@ glFinish (void)
 {
   rsxgl_context_t * ctx = current_ctx();
 
+  // Would wait for commands that haven't been submitted:
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
   // TODO - Rumor has it that waiting on ctx -> ref is "slow". See if this is unacceptable, and see if a sync object is any better.
   const uint32_t ref = ctx -> ref++;
   rsxgl_emit_set_ref(ctx -> gcm_context(),ref);
@@ -51,26 +52,68 @@ glFinish (void)
 
   __sync();
 
-  const useconds_t timeout = RSXGL_SYNC_SLEEP_INTERVAL * RSXGL_FINISH_SLEEP_ITERATIONS;
-  const useconds_t timeout_interval = ctx -> base.sync_sleep_interval;
-
   // Wait some interval for the GPU to finish:
-  if(timeout > 0) {
-    useconds_t remaining_timeout = timeout;
-    while(control -> ref != ref && remaining_timeout > 0) {
-      if(timeout_interval > 0) {
-	usleep(timeout_interval);
-	remaining_timeout -= timeout_interval;
-      }
+  if(control -> ref != ref) {
+    rsxgl_wait_t wait;
+    rsxgl_wait_begin(&wait,(RSXGL_FINISH_TIMEOUT > 0) ? RSXGL_FINISH_TIMEOUT : RSXGL_WAIT_FOREVER);
+
+    bool finished = false;
+    while(!(finished = (control -> ref == ref)) && rsxgl_wait_step(&wait));
+
+    rsxgl_wait_end(&wait,finished);
+  }
+
+  RSXGL_NOERROR_();
+}
+
+GLAPI void APIENTRY
+glFlushPolicyParameteriRSX(GLenum pname,GLint param)
+{
+  if(param < 0) {
+    RSXGL_ERROR_(GL_INVALID_VALUE);
+  }
+
+  rsxgl_context_t * ctx = current_ctx();
+
+  if(pname == GL_FLUSH_DRAW_THRESHOLD_RSX) {
+    ctx -> flush_draw_threshold = param;
+  }
+  else if(pname == GL_FLUSH_WORD_THRESHOLD_RSX) {
+    // Must flush before the command buffer fills up:
+    if((ctx -> gcm_context() -> end - ctx -> gcm_context() -> begin) <= param) {
+      RSXGL_ERROR_(GL_INVALID_VALUE);
     }
+    ctx -> flush_word_threshold = param;
+  }
+  else if(pname == GL_FLUSH_VERTEX_THRESHOLD_RSX) {
+    ctx -> flush_vertex_threshold = param;
   }
-  // Wait forever:
   else {
-    while(control -> ref != ref) {
-      if(timeout_interval > 0) {
-	usleep(timeout_interval);
-      }
-    }
+    RSXGL_ERROR_(GL_INVALID_ENUM);
+  }
+
+  RSXGL_NOERROR_();
+}
+
+GLAPI void APIENTRY
+glGetFlushPolicyParameterivRSX(GLenum pname,GLint * params)
+{
+  rsxgl_context_t * ctx = current_ctx();
+
+  if(pname == GL_FLUSH_DRAW_THRESHOLD_RSX) {
+    *params = ctx -> flush_draw_threshold;
+  }
+  else if(pname == GL_FLUSH_WORD_THRESHOLD_RSX) {
+    *params = ctx -> flush_word_threshold;
+  }
+  else if(pname == GL_FLUSH_VERTEX_THRESHOLD_RSX) {
+    *params = ctx -> flush_vertex_threshold;
+  }
+  else if(pname == GL_FLUSH_COUNT_RSX) {
+    *params = ctx -> flush_count;
+  }
+  else {
+    RSXGL_ERROR_(GL_INVALID_ENUM);
   }
 
   RSXGL_NOERROR_();
@@ -110,19 +153,23 @@ rsxgl_sync_object_free(const rsxgl_sync_object_index_type index)
 // Sync objects are not considered true "GL objects," but they do require library-generated names.
 // So we re-use that capability from gl_object<>. But since they can't be bound or orphaned, etc.,
 // this class does not use the CRTP the way that other GL objects do.
+//
+// A fence is just a timestamp on the timeline of the context that created it; it's signalled
+// once that context's timestamp semaphore reaches the value. Creating one doesn't use up any
+// hardware resources.
 struct rsxgl_sync_object_t {
-  typedef gl_object< rsxgl_sync_object_t, RSXGL_MAX_SYNC_OBJECTS > gl_object_type;
+  typedef gl_object< rsxgl_sync_object_t, RSXGL_MAX_FENCES > gl_object_type;
   typedef typename gl_object_type::name_type name_type;
   typedef typename gl_object_type::storage_type storage_type;
 
   static storage_type & storage();
 
-  name_type name;
+  // The creating context's timestamp semaphore:
   rsxgl_sync_object_index_type index;
-  uint32_t status:1, value:31;
+  uint32_t status:1, timestamp:31;
 
   rsxgl_sync_object_t()
-    : name(0), index(RSXGL_MAX_SYNC_OBJECTS), status(0), value(0) {
+    : index(0), status(0), timestamp(0) {
   }
 };
 
@@ -133,14 +180,42 @@ rsxgl_sync_object_t::storage()
   return _storage;
 }
 
-static const uint32_t rsxgl_sync_token_max = (1 << 23);
-static const uint32_t RSXGL_SYNC_UNSIGNALED_TOKEN = (1 << 24);
-static uint32_t _rsxgl_sync_token = 0;
+// GLsync handles are names, rather than pointers, because storage moves when it grows:
+static inline bool
+rsxgl_sync_is_object(GLsync sync)
+{
+  const uintptr_t name = (uintptr_t)sync;
+  return (name != 0) && (name < RSXGL_MAX_FENCES) && rsxgl_sync_object_t::storage().is_object(name);
+}
+
+static inline rsxgl_sync_object_t &
+rsxgl_sync_object(GLsync sync)
+{
+  return rsxgl_sync_object_t::storage().at((uintptr_t)sync);
+}
 
-static uint32_t
-rsxgl_sync_token()
+// End of the window of timestamps that the fence is compared against (see timestamp.h). Only the
+// creating context knows what it has issued - for other contexts' fences, assume that it was
+// within half of the timeline:
+static inline uint32_t
+rsxgl_sync_issued(const rsxgl_context_t * ctx,const rsxgl_sync_object_t & sync_object)
 {
-  return (_rsxgl_sync_token = (_rsxgl_sync_token + 1) & rsxgl_sync_token_max);
+  if(sync_object.index == ctx -> timestamp_sync) {
+    return rsxgl_timestamp_issued(ctx);
+  }
+  else {
+    return (sync_object.timestamp + ((RSXGL_MAX_TIMESTAMP + 1) >> 1)) & RSXGL_MAX_TIMESTAMP;
+  }
+}
+
+// See if the GPU has reached a fence, and remember it if it has:
+static inline bool
+rsxgl_sync_passed(const rsxgl_context_t * ctx,rsxgl_sync_object_t & sync_object)
+{
+  if(!sync_object.status && rsxgl_timestamp_reached(rsxgl_sync_value(sync_object.index),rsxgl_sync_issued(ctx,sync_object),sync_object.timestamp)) {
+    sync_object.status = 1;
+  }
+  return sync_object.status;
 }
 
 GLAPI GLsync APIENTRY
@@ -154,54 +229,45 @@ glFenceSync (GLenum condition, GLbitfield flags)
     RSXGL_ERROR(GL_INVALID_VALUE,0);
   }
 
-  const rsxgl_sync_object_t::name_type name = rsxgl_sync_object_t::storage().create_name_and_object();
+  rsxgl_context_t * ctx = current_ctx();
 
-  const rsxgl_sync_object_index_type index = rsxgl_sync_object_allocate();
-  const uint32_t token = rsxgl_sync_token();
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR(GL_INVALID_OPERATION,0);
+  }
 
-  if(index != RSXGL_MAX_SYNC_OBJECTS) {
-    rsxgl_sync_object_t * sync_object = &rsxgl_sync_object_t::storage().at(name);
-    sync_object -> name = name;
-    sync_object -> status = 0;
-    sync_object -> index = index;
-    sync_object -> value = token;
-  
-    rsxgl_sync_cpu_signal(index,RSXGL_SYNC_UNSIGNALED_TOKEN);
-    rsxgl_emit_sync_gpu_signal_read(current_ctx() -> base.gcm_context,sync_object -> index,token);
+  const rsxgl_sync_object_t::name_type name = rsxgl_sync_object_t::storage().create_name_and_object();
+  rsxgl_sync_object_t & sync_object = rsxgl_sync_object_t::storage().at(name);
 
-    RSXGL_NOERROR((GLsync)sync_object);
-  }
-  else {
-    RSXGL_ERROR(GL_OUT_OF_MEMORY,0);
-  }
+  // Posted along with everything else that's been emitted since the last flush:
+  sync_object.index = ctx -> timestamp_sync;
+  sync_object.status = 0;
+  sync_object.timestamp = rsxgl_timestamp_create(ctx);
+
+  RSXGL_NOERROR((GLsync)(uintptr_t)name);
 }
 
 GLAPI GLboolean APIENTRY
 glIsSync (GLsync sync)
 {
-  return (sync != 0) && (rsxgl_sync_object_t::storage().is_object(reinterpret_cast< rsxgl_sync_object_t * >(sync) -> name));
+  return rsxgl_sync_is_object(sync);
 }
 
 GLAPI void APIENTRY
 glDeleteSync (GLsync sync)
 {
-  if(sync == 0 || !rsxgl_sync_object_t::storage().is_object(reinterpret_cast< rsxgl_sync_object_t * >(sync) -> name)) {
+  if(!rsxgl_sync_is_object(sync)) {
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  rsxgl_sync_object_t * sync_object = reinterpret_cast< rsxgl_sync_object_t * >(sync);
-
-  if(sync_object -> index != RSXGL_MAX_SYNC_OBJECTS) {
-    rsxgl_sync_object_free(sync_object -> index);
-  }
+  rsxgl_sync_object_t::storage().destroy((uintptr_t)sync);
 
-  rsxgl_sync_object_t::storage().destroy(sync_object -> name);
+  RSXGL_NOERROR_();
 }
 
 GLAPI GLenum APIENTRY
 glClientWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout)
 {
-  if(sync == 0 || !rsxgl_sync_object_t::storage().is_object(reinterpret_cast< rsxgl_sync_object_t * >(sync) -> name)) {
+  if(!rsxgl_sync_is_object(sync)) {
     RSXGL_ERROR(GL_INVALID_VALUE,GL_WAIT_FAILED);
   }
 
@@ -212,25 +278,27 @@ glClientWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout)
 
   rsxgl_context_t * ctx = current_ctx();
 
-  rsxgl_sync_object_t * sync_object = reinterpret_cast< rsxgl_sync_object_t * >(sync);
-
-  // Flush it all:
-  if(flags & GL_SYNC_FLUSH_COMMANDS_BIT) {
-    rsxgl_flush(ctx);
-  }
+  rsxgl_sync_object_t & sync_object = rsxgl_sync_object(sync);
 
   // Maybe it's already been set?
-  if(sync_object -> status) {
+  if(rsxgl_sync_passed(ctx,sync_object)) {
     RSXGL_NOERROR(GL_ALREADY_SIGNALED);
   }
 
-  // timeout is nanoseconds - convert to microseconds:
-  const useconds_t timeout_usec = timeout / 1000;
+  // Flush it all. The fence's timestamp isn't emitted until the next flush, so do that anyway if
+  // it belongs to this context - otherwise the wait could never be satisfied:
+  if((flags & GL_SYNC_FLUSH_COMMANDS_BIT) ||
+     (sync_object.index == ctx -> timestamp_sync && sync_object.timestamp == ctx -> pending_timestamp)) {
+    rsxgl_flush(ctx);
+  }
 
-  const int result = rsxgl_sync_cpu_wait(sync_object -> index,sync_object -> value,timeout_usec,RSXGL_SYNC_SLEEP_INTERVAL);
+  // timeout is nanoseconds - convert to microseconds, rounding up so that the wait is at least as
+  // long as requested:
+  const uint64_t timeout_usec = (timeout / 1000) + ((timeout % 1000) != 0 ? 1 : 0);
 
-  if(result) {
-    sync_object -> status = 1;
+  uint32_t cached_timestamp = 0;
+  if(rsxgl_timestamp_wait(cached_timestamp,sync_object.index,sync_object.timestamp,rsxgl_sync_issued(ctx,sync_object),timeout_usec)) {
+    sync_object.status = 1;
     RSXGL_NOERROR(GL_CONDITION_SATISFIED);
   }
   else {
@@ -241,7 +309,7 @@ glClientWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout)
 GLAPI void APIENTRY
 glWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout)
 {
-  if(sync == 0 || !rsxgl_sync_object_t::storage().is_object(reinterpret_cast< rsxgl_sync_object_t * >(sync) -> name)) {
+  if(!rsxgl_sync_is_object(sync)) {
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
@@ -249,7 +317,33 @@ glWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout)
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
-  // TODO - Do something here. Not sure what.
+  rsxgl_context_t * ctx = current_ctx();
+
+  // The value waited for below wouldn't be the right one when the list is called:
+  if(ctx -> command_list != 0) {
+    RSXGL_ERROR_(GL_INVALID_OPERATION);
+  }
+
+  // The CPU has already seen the fence pass, so there's nothing for the GPU to wait for:
+  if(rsxgl_sync_passed(ctx,rsxgl_sync_object(sync))) {
+    RSXGL_NOERROR_();
+  }
+
+  // The semaphore acquire only tests for equality, which a timeline that keeps moving can't be
+  // relied upon to satisfy. Instead, post a timestamp now and wait for exactly that value - nothing
+  // else can write this context's semaphore before the acquire has been processed. All contexts
+  // share one command stream, and the timestamp is written once everything before it (including
+  // the fence, whichever context it came from) has finished.
+  //
+  // So this doesn't wait for the given fence in particular: the GPU drains every command issued
+  // before the call, which is a superset of what the fence covers. The CPU doesn't block.
+  rsxgl_timestamp_create(ctx);
+  rsxgl_timestamp_post(ctx);
+  rsxgl_sync_gpu_wait(ctx -> gcm_context(),ctx -> timestamp_sync,ctx -> last_timestamp);
+
+  // The timestamp is no longer pending, so nothing else would know to flush it - a later client
+  // wait or query poll on it would never see it pass:
+  rsxgl_flush(ctx);
 
   RSXGL_NOERROR_();
 }
@@ -257,7 +351,7 @@ glWaitSync (GLsync sync, GLbitfield flags, GLuint64 timeout)
 GLAPI void APIENTRY
 glGetSynciv (GLsync sync, GLenum pname, GLsizei bufSize, GLsizei *length, GLint *values)
 {
-  if(sync == 0 || !rsxgl_sync_object_t::storage().is_object(reinterpret_cast< rsxgl_sync_object_t * >(sync) -> name)) {
+  if(!rsxgl_sync_is_object(sync)) {
     RSXGL_ERROR_(GL_INVALID_VALUE);
   }
 
@@ -266,13 +360,13 @@ glGetSynciv (GLsync sync, GLenum pname, GLsizei bufSize, GLsizei *length, GLint
     RSXGL_NOERROR_();
   }
 
-  rsxgl_sync_object_t * sync_object = reinterpret_cast< rsxgl_sync_object_t * >(sync);
+  rsxgl_sync_object_t & sync_object = rsxgl_sync_object(sync);
 
   if(pname == GL_OBJECT_TYPE) {
     *values = GL_SYNC_FENCE;
   }
   else if(pname == GL_SYNC_STATUS) {
-    *values = (sync_object -> status) ? GL_SIGNALED : GL_UNSIGNALED;
+    *values = rsxgl_sync_passed(current_ctx(),sync_object) ? GL_SIGNALED : GL_UNSIGNALED;
   }
   else if(pname == GL_SYNC_CONDITION) {
     *values = GL_SYNC_GPU_COMMANDS_COMPLETE;
@@ -22,6 +22,7 @@
 #include "gl_fifo.h"
 #include "rsxgl_assert.h"
 #include "rsxgl_limits.h"
+#include "wait.h"
 
 //
 static inline void
@@ -107,27 +108,26 @@ rsxgl_emit_sync_gpu_signal_write(gcmContextData * context,const rsxgl_sync_objec
   gcm_finish_n_commands(context,4);
 }
 
-// Block the CPU for a specified interval until the sync object is set to a specific value by the GPU.
-// Timing will be inaccurate - instead of actually measuring how long the operation's taken, just
-// divides desired timeout by timeout_interval, and run for that many iterations. Given that reading
-// back the sync value is probably pretty slow, this function may run for longer than timeout.
-// timeout_interval must therefore be some positive number - the function asserts that this is so.
+// Block the CPU for up to timeout microseconds (RSXGL_WAIT_FOREVER never gives up) until the sync
+// object is set to a specific value by the GPU.
 //
-// Returns 1 if the sync object was set to value while this function ran, 0 if it "timed out".
+// Returns 1 if the sync object was set to value while this function ran, 0 if it timed out.
 static inline int
-rsxgl_sync_cpu_wait(const rsxgl_sync_object_index_type index,const uint32_t value,const useconds_t timeout,const useconds_t timeout_interval)
+rsxgl_sync_cpu_wait(const rsxgl_sync_object_index_type index,const uint32_t value,const uint64_t timeout)
 {
-  rsxgl_assert(timeout_interval > 0);
-
   volatile uint32_t * object = gcmGetLabelAddress(index);
   rsxgl_assert(object != 0);
 
   uint32_t current_value = *object;
-  useconds_t i = 0;
-  const useconds_t n = timeout / timeout_interval;
 
-  for(;current_value != value && i < n;current_value = *object,++i) {
-    usleep(timeout_interval);
+  if(current_value != value) {
+    rsxgl_wait_t wait;
+    rsxgl_wait_begin(&wait,timeout);
+
+    for(current_value = *object;current_value != value && rsxgl_wait_step(&wait);current_value = *object) {
+    }
+
+    rsxgl_wait_end(&wait,current_value == value);
   }
 
   return (current_value == value);
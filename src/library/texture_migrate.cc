@@ -22,6 +22,7 @@ static uint32_t rsxgl_texture_migrate_size = RSXGL_CONFIG_texture_migrate_buffer
 static void * _rsxgl_texture_migrate_buffer = 0;
 static uint32_t rsxgl_texture_migrate_buffer_offset = 0;
 static mspace rsxgl_texture_migrate_buffer_space = 0;
+static struct rsxgl_memory_usage_t rsxgl_texture_migrate_usage = { 0, 0 };
 
 void *
 rsxgl_texture_migrate_buffer_new(const rsx_size_t align,const rsx_size_t size, uint32_t *offset)
@@ -89,7 +90,10 @@ rsxgl_texture_migrate_memalign(const rsx_size_t align,const rsx_size_t size)
 
   rsxgl_assert(buffer != 0);
 
-  return mspace_memalign(rsxgl_texture_migrate_buffer_space,align,size);
+  void * ptr = mspace_memalign(rsxgl_texture_migrate_buffer_space,align,size);
+  if(ptr != 0) rsxgl_memory_usage_allocate(&rsxgl_texture_migrate_usage,mspace_usable_size(ptr));
+
+  return ptr;
 }
 
 void
@@ -97,6 +101,7 @@ rsxgl_texture_migrate_free(void * ptr)
 {
   rsxgl_assert(_rsxgl_texture_migrate_buffer != 0);
 
+  rsxgl_memory_usage_free(&rsxgl_texture_migrate_usage,mspace_usable_size(ptr));
   mspace_free(rsxgl_texture_migrate_buffer_space,ptr);
 }
 
@@ -125,3 +130,10 @@ rsxgl_texture_migrate_base()
   rsxgl_assert(_rsxgl_texture_migrate_buffer != 0);
   return (uint8_t *)_rsxgl_texture_migrate_buffer;
 }
+
+void
+rsxgl_texture_migrate_info(struct rsxgl_memory_info_t * info)
+{
+  // The buffer is created by the first texture upload:
+  rsxgl_mspace_info(rsxgl_texture_migrate_buffer_space,(_rsxgl_texture_migrate_buffer != 0) ? rsxgl_texture_migrate_size : 0,&rsxgl_texture_migrate_usage,info);
+}
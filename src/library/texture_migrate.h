@@ -21,5 +21,6 @@ void rsxgl_texture_migrate_reset();
 void * rsxgl_texture_migrate_address(const uint32_t);
 uint32_t rsxgl_texture_migrate_offset(const void *);
 void * rsxgl_texture_migrate_base();
+void rsxgl_texture_migrate_info(struct rsxgl_memory_info_t *);
 
 #endif
@@ -676,14 +676,8 @@ glDeleteTextures (GLsizei n, const GLuint *textures)
     if(texture_t::storage().is_object(texture_name)) {
       ctx -> texture_binding.unbind_from_all(texture_name);
 
-      // TODO: orphan it, instead of doing this:
-      texture_t & texture = texture_t::storage().at(texture_name);
-      if(texture.timestamp > 0) {
-	rsxgl_timestamp_wait(ctx,texture.timestamp);
-	texture.timestamp = 0;
-      }
-
-      texture_t::gl_object_type::maybe_delete(texture_name);
+      // If the GPU is still using the texture, it's destroyed later by rsxgl_reclaim_orphans():
+      texture_t::gl_object_type::maybe_delete_or_orphan(rsxgl_timestamp_busy(ctx,texture_t::storage().at(texture_name).timestamp),texture_name);
     }
     else if(texture_t::storage().is_name(texture_name)) {
       texture_t::storage().destroy(texture_name);
@@ -769,6 +763,9 @@ rsxgl_util_format_translate_dma(rsxgl_context_t * ctx,
   const struct util_format_description *dst_format_desc = util_format_description(dst_format);
   const struct util_format_description *src_format_desc = util_format_description(src_format);
 
+  // Texture storage is being written; the texture cache can't be trusted afterwards:
+  ctx -> invalid.parts.texture_cache = 1;
+
   util_format_translate(dst_format,dstaddress,dst_stride,dst_x,dst_y,
 			src_format,srcaddress,src_stride,src_x,src_y,
 			width,height);
@@ -1314,6 +1311,22 @@ glTexParameteriv (GLenum target, GLenum pname, const GLint *params)
   rsxgl_tex_parameteri(ctx,ctx -> texture_binding.names[ctx -> active_texture],pname,*params);
 }
 
+uint32_t
+rsxgl_texture_storage_size(const texture_t & texture,const uint32_t pitch)
+{
+  uint32_t nbytes = 0;
+  texture_t::dimension_size_type size[3] = { texture.size[0], texture.size[1], texture.size[2] };
+  for(texture_t::level_size_type i = 0,n = texture.num_levels;i < n;++i) {
+    nbytes += pitch * size[1] * size[2];
+
+    for(int j = 0;j < 3;++j) {
+      size[j] = std::max(size[j] >> 1,1);
+    }
+  }
+
+  return nbytes;
+}
+
 static inline void
 rsxgl_texture_validate_storage(rsxgl_context_t * ctx,texture_t & texture)
 {
@@ -1326,15 +1339,7 @@ rsxgl_texture_validate_storage(rsxgl_context_t * ctx,texture_t & texture)
   const uint32_t pitch_tmp = util_format_get_stride(texture.pformat,texture.size[0]);
   const uint32_t pitch = texture.dims > 1 ? align_pot< uint32_t, 64 >(pitch_tmp) : pitch_tmp;
 
-  uint32_t nbytes = 0;
-  texture_t::dimension_size_type size[3] = { texture.size[0], texture.size[1], texture.size[2] };
-  for(texture_t::level_size_type i = 0,n = texture.num_levels;i < n;++i) {
-    nbytes += pitch * size[1] * size[2];
-
-    for(int j = 0;j < 3;++j) {
-      size[j] = std::max(size[j] >> 1,1);
-    }
-  }
+  const uint32_t nbytes = rsxgl_texture_storage_size(texture,pitch);
 
   texture.memory = rsxgl_arena_allocate(memory_arena_t::storage().at(texture.arena),128,nbytes,0);
   texture.memory.owner = true;
@@ -1469,7 +1474,7 @@ rsxgl_tex_storage(rsxgl_context_t * ctx,texture_t & texture,uint8_t dims,bool cu
 
 #if 0
   // TODO: Orphan the texture
-  if(texture.timestamp != 0 && (!rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,texture.timestamp))) {
+  if(texture.timestamp != 0 && (!rsxgl_timestamp_passed(ctx,texture.timestamp))) {
   }
 #else
   if(texture.timestamp > 0) {
@@ -1569,7 +1574,7 @@ rsxgl_tex_image_format(rsxgl_context_t * ctx,texture_t & texture,uint8_t dims,bo
 
 #if 0
   // TODO: Orphan the texture
-  if(texture.timestamp != 0 && (!rsxgl_timestamp_passed(ctx -> cached_timestamp,ctx -> timestamp_sync,texture.timestamp))) {
+  if(texture.timestamp != 0 && (!rsxgl_timestamp_passed(ctx,texture.timestamp))) {
     texture.timestamp = 0;
   }
 #else
@@ -1781,6 +1786,8 @@ rsxgl_tex_subimage(rsxgl_context_t * ctx,texture_t & texture,GLint _level,GLint
       data = (const uint8_t *)data + srcoffset;
       util_format_translate(pdstformat,dstaddress,dstpitch,x,y,
 			    psrcformat,data,srcpitch,0,0,width,height);
+
+      ctx -> invalid.parts.texture_cache = 1;
     }
 
     RSXGL_NOERROR_();
@@ -1793,7 +1800,7 @@ rsxgl_copy_tex_image(rsxgl_context_t * ctx,texture_t & texture,uint8_t dims,bool
   const bool result = rsxgl_tex_image_format(ctx,texture,dims,cube,rect,_level,glinternalformat,width,height,1);
 
   if(result) {
-    const uint32_t timestamp = rsxgl_timestamp_create(ctx,1);
+    const uint32_t timestamp = rsxgl_timestamp_create(ctx);
     
     framebuffer_t & framebuffer = ctx -> framebuffer_binding[RSXGL_READ_FRAMEBUFFER];
     rsxgl_framebuffer_validate(ctx,framebuffer,timestamp);
@@ -1818,7 +1825,7 @@ rsxgl_copy_tex_image(rsxgl_context_t * ctx,texture_t & texture,uint8_t dims,bool
 				      std::min((unsigned)width,(unsigned)framebuffer.size[0] - x),std::min((unsigned)height,(unsigned)framebuffer.size[1] - y));
     }
 
-    rsxgl_timestamp_post(ctx,timestamp);
+    rsxgl_flush_policy(ctx,0,0);
   }
 }
 
@@ -1832,7 +1839,7 @@ rsxgl_copy_tex_subimage(rsxgl_context_t * ctx,texture_t & texture,GLint _level,G
   const bool result = rsxgl_tex_subimage_init(ctx,texture,_level,xoffset,yoffset,zoffset,width,height,1,&pdstformat,&dstpitch,&dstaddress,&dstmem);
 
   if(result) {
-    const uint32_t timestamp = rsxgl_timestamp_create(ctx,1);
+    const uint32_t timestamp = rsxgl_timestamp_create(ctx);
     
     framebuffer_t & framebuffer = ctx -> framebuffer_binding[RSXGL_READ_FRAMEBUFFER];
     rsxgl_framebuffer_validate(ctx,framebuffer,timestamp);
@@ -1850,7 +1857,7 @@ rsxgl_copy_tex_subimage(rsxgl_context_t * ctx,texture_t & texture,GLint _level,G
 				      std::min((unsigned)width,(unsigned)framebuffer.size[0] - x),std::min((unsigned)height,(unsigned)framebuffer.size[1] - y));
     }
     
-    rsxgl_timestamp_post(ctx,timestamp);
+    rsxgl_flush_policy(ctx,0,0);
   }
 }
 
@@ -2153,7 +2160,6 @@ glTexBuffer (GLenum target, GLenum internalformat, GLuint buffer)
 void
 rsxgl_texture_validate(rsxgl_context_t * ctx,texture_t & texture,uint32_t timestamp)
 {
-  rsxgl_assert(timestamp >= texture.timestamp);
   texture.timestamp = timestamp;
 
   if(texture.invalid) {
@@ -2236,22 +2242,7 @@ void
 rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t timestamp)
 {
   gcmContextData * context = ctx -> base.gcm_context;
-
-  // Invalidate the texture cache.
-  // TODO: determine when this is necessary to do, and only do it then.
-  {
-    uint32_t * buffer = gcm_reserve(context,4);
-
-    // Fragment program textures:
-    gcm_emit_method_at(buffer,0,NV40_3D_TEX_CACHE_CTL,1);
-    gcm_emit_at(buffer,1,1);
-
-    // Vertex program textures:
-    gcm_emit_method_at(buffer,2,NV40_3D_TEX_CACHE_CTL,1);
-    gcm_emit_at(buffer,3,2);
-
-    gcm_finish_n_commands(context,4);
-  }
+  register_cache_t & registers = ctx -> registers;
 
   const program_t::textures_bitfield_type
     textures_enabled = program.textures_enabled,
@@ -2280,7 +2271,6 @@ rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t times
 
     if(ctx -> texture_binding.names[api_index] != 0) {
       texture_t & texture = ctx -> texture_binding[api_index];
-      rsxgl_assert(timestamp >= texture.timestamp);
       texture.timestamp = timestamp;
     }
 
@@ -2304,34 +2294,21 @@ rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t times
 
 	if(format_format == RGBA32F_format || format_format == R32F_format) {
 	  // activate the texture:
-	  uint32_t * buffer = gcm_reserve(context,9);
-
 #define NVFX_VERTEX_TEX_OFFSET(INDEX) (0x00000900 + 0x20 * (INDEX))
-	  gcm_emit_method(&buffer,NVFX_VERTEX_TEX_OFFSET(index),2);
-	  gcm_emit(&buffer,texture.memory.offset);
-	  gcm_emit(&buffer,format);
+	  const uint32_t offset_format[2] = { texture.memory.offset, format };
+	  rsxgl_emit_registers(context,registers,NVFX_VERTEX_TEX_OFFSET(index),2,offset_format);
 	  
 #define NVFX_VERTEX_TEX_ENABLE(INDEX) (0x0000090c + 0x20 * (INDEX))
-	  gcm_emit_method(&buffer,NVFX_VERTEX_TEX_ENABLE(index),1);
-	  gcm_emit(&buffer,NV40_3D_TEX_ENABLE_ENABLE);
+	  rsxgl_emit_register(context,registers,NVFX_VERTEX_TEX_ENABLE(index),NV40_3D_TEX_ENABLE_ENABLE);
 	  
 #define NVFX_VERTEX_TEX_NPOT_SIZE(INDEX) (0x00000918 + 0x20 * (INDEX))
-	  gcm_emit_method(&buffer,NVFX_VERTEX_TEX_NPOT_SIZE(index),1);
-	  gcm_emit(&buffer,((uint32_t)texture.size[0] << NV30_3D_TEX_NPOT_SIZE_W__SHIFT) | (uint32_t)texture.size[1]);
+	  rsxgl_emit_register(context,registers,NVFX_VERTEX_TEX_NPOT_SIZE(index),((uint32_t)texture.size[0] << NV30_3D_TEX_NPOT_SIZE_W__SHIFT) | (uint32_t)texture.size[1]);
 	
 #define NVFX_VERTEX_TEX_SIZE1(INDEX) (0x00000910 + 0x20 * (INDEX))
-	  gcm_emit_method(&buffer,NVFX_VERTEX_TEX_SIZE1(index),1);
-	  gcm_emit(&buffer,(uint32_t)texture.pitch);
-	  
-	  gcm_finish_commands(context,&buffer);
+	  rsxgl_emit_register(context,registers,NVFX_VERTEX_TEX_SIZE1(index),(uint32_t)texture.pitch);
 	}
 	else {
-	  uint32_t * buffer = gcm_reserve(context,2);
-
-	  gcm_emit_method(&buffer,NVFX_VERTEX_TEX_ENABLE(index),1);
-	  gcm_emit(&buffer,0);
-
-	  gcm_finish_commands(context,&buffer);
+	  rsxgl_emit_register(context,registers,NVFX_VERTEX_TEX_ENABLE(index),0);
 	}
       }
 
@@ -2347,7 +2324,6 @@ rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t times
 
     if(ctx -> texture_binding.names[api_index] != 0) {
       texture_t & texture = ctx -> texture_binding[api_index];
-      rsxgl_assert(timestamp >= texture.timestamp);
       texture.timestamp = timestamp;
     }
 
@@ -2372,17 +2348,10 @@ rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t times
 	;
       
       //
-      uint32_t * buffer = gcm_reserve(context,4);
-      
-      gcm_emit_method(&buffer,NV30_3D_TEX_FILTER(index),1);
-      gcm_emit(&buffer,filter);
-      
-      gcm_emit_method(&buffer,NV30_3D_TEX_WRAP(index),1);
-      gcm_emit(&buffer,wrap | compare);
+      rsxgl_emit_register(context,registers,NV30_3D_TEX_FILTER(index),filter);
+      rsxgl_emit_register(context,registers,NV30_3D_TEX_WRAP(index),wrap | compare);
 
       // TODO: Set LOD min, max, bias:
-      
-      gcm_finish_commands(context,&buffer);
 
       validated.set(api_index);
     }
@@ -2404,25 +2373,13 @@ rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t times
 #endif
 
 	// activate the texture:
-	uint32_t * buffer = gcm_reserve(context,11);
-	
-	gcm_emit_method(&buffer,NV30_3D_TEX_OFFSET(index),2);
-	gcm_emit(&buffer,texture.memory.offset);
-	gcm_emit(&buffer,texture.format);
-	
-	gcm_emit_method(&buffer,NV30_3D_TEX_ENABLE(index),1);
-	gcm_emit(&buffer,NV40_3D_TEX_ENABLE_ENABLE);
-	
-	gcm_emit_method(&buffer,NV30_3D_TEX_NPOT_SIZE(index),1);
-	gcm_emit(&buffer,((uint32_t)texture.size[0] << NV30_3D_TEX_NPOT_SIZE_W__SHIFT) | (uint32_t)texture.size[1]);
+	const uint32_t offset_format[2] = { texture.memory.offset, texture.format };
+	rsxgl_emit_registers(context,registers,NV30_3D_TEX_OFFSET(index),2,offset_format);
 	
-	gcm_emit_method(&buffer,NV40_3D_TEX_SIZE1(index),1);
-	gcm_emit(&buffer,((uint32_t)texture.size[2] << NV40_3D_TEX_SIZE1_DEPTH__SHIFT) | (uint32_t)texture.pitch);
-
-	gcm_emit_method(&buffer,NV30_3D_TEX_SWIZZLE(index),1);
-	gcm_emit(&buffer,texture.remap);
-	
-	gcm_finish_commands(context,&buffer);
+	rsxgl_emit_register(context,registers,NV30_3D_TEX_ENABLE(index),NV40_3D_TEX_ENABLE_ENABLE);
+	rsxgl_emit_register(context,registers,NV30_3D_TEX_NPOT_SIZE(index),((uint32_t)texture.size[0] << NV30_3D_TEX_NPOT_SIZE_W__SHIFT) | (uint32_t)texture.size[1]);
+	rsxgl_emit_register(context,registers,NV40_3D_TEX_SIZE1(index),((uint32_t)texture.size[2] << NV40_3D_TEX_SIZE1_DEPTH__SHIFT) | (uint32_t)texture.pitch);
+	rsxgl_emit_register(context,registers,NV30_3D_TEX_SWIZZLE(index),texture.remap);
       }
 
       validated.set(api_index);
@@ -2432,4 +2389,23 @@ rsxgl_textures_validate(rsxgl_context_t * ctx,program_t & program,uint32_t times
   ctx -> invalid_texture_assignments.reset();
   ctx -> invalid_samplers &= ~validated;
   ctx -> invalid_textures &= ~validated;
+
+  // Invalidate the texture cache if texture storage has been written since it last was - by the
+  // CPU, by a transfer, or by drawing into a texture attached to a framebuffer. The textures
+  // validated above may have just been uploaded, so this comes after them:
+  if(ctx -> invalid.parts.texture_cache) {
+    uint32_t * buffer = gcm_reserve(context,4);
+
+    // Fragment program textures:
+    gcm_emit_method_at(buffer,0,NV40_3D_TEX_CACHE_CTL,1);
+    gcm_emit_at(buffer,1,1);
+
+    // Vertex program textures:
+    gcm_emit_method_at(buffer,2,NV40_3D_TEX_CACHE_CTL,1);
+    gcm_emit_at(buffer,3,2);
+
+    gcm_finish_n_commands(context,4);
+
+    ctx -> invalid.parts.texture_cache = 0;
+  }
 }
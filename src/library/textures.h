@@ -136,8 +136,13 @@ struct texture_t {
   sampler_t sampler;
 };
 
+template<> bool gl_object_in_use< texture_t >(const texture_t &);
+
 struct rsxgl_context_t;
 
+// Bytes of storage for all of the texture's levels, each with the given pitch:
+uint32_t rsxgl_texture_storage_size(const texture_t &,const uint32_t pitch);
+
 bool rsxgl_texture_validate_complete(rsxgl_context_t *,texture_t &);
 void rsxgl_texture_validate(rsxgl_context_t *,texture_t &,uint32_t);
 void rsxgl_textures_validate(rsxgl_context_t *,program_t &,uint32_t);
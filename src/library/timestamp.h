@@ -17,22 +17,50 @@
 #define rsxgl_timestamp_H
 
 #include "sync.h"
+#include "wait.h"
 
-// max_timestamp + 1 should be a power-of-two value.
-// Should not return 0, because this is reserved for indicating that an object is not waiting
-// on a GPU operation.
+// Timestamps count up from 1 to RSXGL_MAX_TIMESTAMP, then start over at 1 - 0 is reserved for
+// indicating that an object is not waiting on a GPU operation. max_timestamp + 1 must be a
+// power-of-two value.
+//
+// Since the timeline wraps around, timestamps can't be compared with each other directly.
+// Instead, a timestamp is compared against the window of timestamps that the GPU hasn't reached
+// yet - the ones after the GPU's current timestamp, up to and including the last one that was
+// handed out ("issued"). Every other value has been reached, no matter how long ago it was
+// issued, so objects never need their timestamps reset when the timeline starts over.
+
+// Timestamp that follows t:
+static inline uint32_t
+rsxgl_timestamp_next(const uint32_t t)
+{
+  return (t == RSXGL_MAX_TIMESTAMP) ? 1 : (t + 1);
+}
+
+// Number of steps along the timeline from one timestamp to another:
+static inline uint32_t
+rsxgl_timestamp_distance(const uint32_t from,const uint32_t to)
+{
+  return (to - from) & RSXGL_MAX_TIMESTAMP;
+}
+
+// Has a GPU that's at timestamp current reached compare?
+static inline bool
+rsxgl_timestamp_reached(const uint32_t current,const uint32_t issued,const uint32_t compare)
+{
+  const uint32_t distance = rsxgl_timestamp_distance(current,compare);
+  return (distance == 0) || (distance > rsxgl_timestamp_distance(current,issued));
+}
 
-// Add the previously allocated timestamp to the command stream.
 // See if a timestamp has been passed by the GPU:
 static inline bool
-rsxgl_timestamp_passed(uint32_t & cached_timestamp,const uint8_t index,const uint32_t compare)
+rsxgl_timestamp_passed(uint32_t & cached_timestamp,const uint8_t index,const uint32_t compare,const uint32_t issued)
 {
   rsxgl_assert(index != 0);
 
-  if(cached_timestamp < compare) {
+  if(!rsxgl_timestamp_reached(cached_timestamp,issued,compare)) {
     const uint32_t timestamp = rsxgl_sync_value(index);
     cached_timestamp = timestamp;
-    return timestamp >= compare;
+    return rsxgl_timestamp_reached(timestamp,issued,compare);
   }
   else {
     return true;
@@ -41,31 +69,31 @@ rsxgl_timestamp_passed(uint32_t & cached_timestamp,const uint8_t index,const uin
 
 // Conservative timestamp checking - only checks the "cached" timestamp, does not consult the GPU:
 static inline bool
-rsxgl_timestamp_passed_conservative(const uint32_t cached_timestamp,const uint32_t compare)
+rsxgl_timestamp_passed_conservative(const uint32_t cached_timestamp,const uint32_t compare,const uint32_t issued)
 {
-  return (cached_timestamp >= compare);
+  return rsxgl_timestamp_reached(cached_timestamp,issued,compare);
 }
 
 // Wait for the GPU to reach some timestamp. Returns true if the function did indeed need to wait,
 // false otherwise.
 static inline bool
-rsxgl_timestamp_wait(uint32_t & cached_timestamp,const uint8_t index,const uint32_t compare,const useconds_t timeout_interval)
+rsxgl_timestamp_wait(uint32_t & cached_timestamp,const uint8_t index,const uint32_t compare,const uint32_t issued)
 {
-  if(cached_timestamp < compare) {
+  if(!rsxgl_timestamp_reached(cached_timestamp,issued,compare)) {
     volatile uint32_t * object = gcmGetLabelAddress(index);
     rsxgl_assert(object != 0);
     
     uint32_t timestamp = *object;
 
-    if(timeout_interval) {
-      for(;timestamp < compare;timestamp = *object) {
-	usleep(timeout_interval);
-      }
-    }
-    else {
-      while(timestamp < compare) {
-	timestamp = *object;
+    if(!rsxgl_timestamp_reached(timestamp,issued,compare)) {
+      rsxgl_wait_t wait;
+      rsxgl_wait_begin(&wait,RSXGL_WAIT_FOREVER);
+
+      for(timestamp = *object;!rsxgl_timestamp_reached(timestamp,issued,compare);timestamp = *object) {
+	rsxgl_wait_step(&wait);
       }
+
+      rsxgl_wait_end(&wait,1);
     }
 
     cached_timestamp = timestamp;
@@ -77,4 +105,31 @@ rsxgl_timestamp_wait(uint32_t & cached_timestamp,const uint8_t index,const uint3
   }
 }
 
+// Wait for up to timeout microseconds (RSXGL_WAIT_FOREVER never gives up) for the GPU to reach
+// some timestamp. Returns true if it did.
+static inline bool
+rsxgl_timestamp_wait(uint32_t & cached_timestamp,const uint8_t index,const uint32_t compare,const uint32_t issued,const uint64_t timeout)
+{
+  if(!rsxgl_timestamp_reached(cached_timestamp,issued,compare)) {
+    volatile uint32_t * object = gcmGetLabelAddress(index);
+    rsxgl_assert(object != 0);
+
+    uint32_t timestamp = *object;
+
+    if(!rsxgl_timestamp_reached(timestamp,issued,compare)) {
+      rsxgl_wait_t wait;
+      rsxgl_wait_begin(&wait,timeout);
+
+      for(timestamp = *object;!rsxgl_timestamp_reached(timestamp,issued,compare) && rsxgl_wait_step(&wait);timestamp = *object) {
+      }
+
+      rsxgl_wait_end(&wait,rsxgl_timestamp_reached(timestamp,issued,compare));
+    }
+
+    cached_timestamp = timestamp;
+  }
+
+  return rsxgl_timestamp_reached(cached_timestamp,issued,compare);
+}
+
 #endif
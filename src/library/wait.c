@@ -0,0 +1,95 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// wait.c - Waiting for the GPU.
+
+#include <EGL/egl.h>
+#include "GL3/rsxgl.h"
+#include "rsxgl_limits.h"
+#include "wait.h"
+
+#include <sys/systime.h>
+
+extern struct rsxgl_init_parameters_t rsxgl_init_parameters;
+
+static struct rsxgl_wait_statistics_t rsxgl_wait_statistics = { 0, 0, 0, 0, 0 };
+
+uint64_t
+rsxgl_wait_time(void)
+{
+  return sysGetSystemTime();
+}
+
+void
+rsxgl_wait_begin(struct rsxgl_wait_t * wait,const uint64_t timeout)
+{
+  wait -> start = rsxgl_wait_time();
+  wait -> deadline = (timeout > (RSXGL_WAIT_FOREVER - wait -> start)) ? RSXGL_WAIT_FOREVER : (wait -> start + timeout);
+  wait -> sleep = RSXGL_WAIT_MIN_SLEEP;
+  wait -> sleeps = 0;
+}
+
+int
+rsxgl_wait_step(struct rsxgl_wait_t * wait)
+{
+  const uint64_t now = rsxgl_wait_time();
+
+  if(now >= wait -> deadline) {
+    return 0;
+  }
+
+  const useconds_t max_sleep = rsxgl_init_parameters.wait_max_sleep;
+
+  // Keep polling:
+  if(max_sleep == 0 || (now - wait -> start) < rsxgl_init_parameters.wait_spin_time) {
+    return 1;
+  }
+
+  // Don't sleep past the deadline:
+  useconds_t sleep = (wait -> sleep < max_sleep) ? wait -> sleep : max_sleep;
+  if((uint64_t)sleep > (wait -> deadline - now)) {
+    sleep = (useconds_t)(wait -> deadline - now);
+  }
+
+  usleep(sleep);
+
+  ++wait -> sleeps;
+  if(wait -> sleep < max_sleep) {
+    wait -> sleep *= 2;
+  }
+
+  return 1;
+}
+
+void
+rsxgl_wait_end(struct rsxgl_wait_t * wait,const int satisfied)
+{
+  const uint64_t time = rsxgl_wait_time() - wait -> start;
+
+  ++rsxgl_wait_statistics.waits;
+  rsxgl_wait_statistics.sleeps += wait -> sleeps;
+  if(!satisfied) {
+    ++rsxgl_wait_statistics.timeouts;
+  }
+  rsxgl_wait_statistics.total_time += time;
+  if(time > rsxgl_wait_statistics.max_time) {
+    rsxgl_wait_statistics.max_time = time;
+  }
+}
+
+void
+rsxglGetWaitStatistics(struct rsxgl_wait_statistics_t * statistics)
+{
+  *statistics = rsxgl_wait_statistics;
+}
+
+void
+rsxglResetWaitStatistics(void)
+{
+  rsxgl_wait_statistics.waits = 0;
+  rsxgl_wait_statistics.sleeps = 0;
+  rsxgl_wait_statistics.timeouts = 0;
+  rsxgl_wait_statistics.total_time = 0;
+  rsxgl_wait_statistics.max_time = 0;
+}
@@ -0,0 +1,48 @@
+//-*-C-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// wait.h - Waiting for the GPU. Polls without sleeping for a short while, since most waits are
+// brief, then sleeps for exponentially longer intervals so that long waits don't burn PPU time.
+//
+// Usage: check the condition; if it isn't met, call rsxgl_wait_begin, then call rsxgl_wait_step
+// each time the condition is checked and found not to be met, and finally rsxgl_wait_end.
+
+#ifndef rsxgl_wait_H
+#define rsxgl_wait_H
+
+#include <stdint.h>
+#include <unistd.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timeout that never expires:
+#define RSXGL_WAIT_FOREVER (~(uint64_t)0)
+
+struct rsxgl_wait_t {
+  uint64_t start, deadline;
+  useconds_t sleep;
+  uint32_t sleeps;
+};
+
+// Current time, in microseconds:
+uint64_t rsxgl_wait_time(void);
+
+// timeout is in microseconds:
+void rsxgl_wait_begin(struct rsxgl_wait_t *,const uint64_t timeout);
+
+// Spins or sleeps. Returns 0 once the timeout has expired, non-zero otherwise:
+int rsxgl_wait_step(struct rsxgl_wait_t *);
+
+// Adds the wait to the statistics returned by rsxglGetWaitStatistics. satisfied is 0 if the
+// wait timed out:
+void rsxgl_wait_end(struct rsxgl_wait_t *,const int satisfied);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,31 @@
+#!/bin/sh
+# Golden-stream test of the decoder: decode known command streams, and compare what rsxfifo prints
+# with the expected text. Each test in tests/ is NAME.hex (big-endian words, in hex, loaded at
+# offset 0), an optional NAME_list.hex (loaded at 0x100000) and NAME.expected.
+
+srcdir=${srcdir:-.}
+XXD=${XXD:-xxd}
+status=0
+
+for expected in "$srcdir"/tests/*.expected; do
+    name=`basename "$expected" .expected`
+
+    "$XXD" -r -p "$srcdir/tests/$name.hex" > "$name.bin" || exit 1
+    files="$name.bin"
+
+    if test -r "$srcdir/tests/${name}_list.hex"; then
+	"$XXD" -r -p "$srcdir/tests/${name}_list.hex" > "${name}_list.bin" || exit 1
+	files="$files ${name}_list.bin@0x100000"
+    fi
+
+    ./rsxfifo -d $files > "$name.out"
+
+    if diff -u "$expected" "$name.out"; then
+	rm -f "$name.bin" "${name}_list.bin" "$name.out"
+    else
+	echo "FAIL: $name"
+	status=1
+    fi
+done
+
+exit $status
@@ -0,0 +1,253 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// main.cc - Command-line front end to the command stream decoder.
+
+#include "rsxfifo.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+static void
+usage(const char * progname)
+{
+  fprintf(stderr,"Usage: %s [options] file[@offset] [file[@offset] ...]\n",progname);
+  fprintf(stderr,"Decode captured RSX command buffers. Each file is loaded at the given RSX offset (default 0).\n\n");
+  fprintf(stderr,"Options:\n");
+  fprintf(stderr,"\t-g <offset>\tstart executing at <offset> (default: the offset of the first file)\n");
+  fprintf(stderr,"\t-p <offset>\tstop executing at <offset> (default: the end of the first file)\n");
+  fprintf(stderr,"\t-n <words>\tstop after fetching <words> words (default: 16777216)\n");
+  fprintf(stderr,"\t-l\t\tfiles contain little-endian words (default: big-endian, as captured from a PS3)\n");
+  fprintf(stderr,"\t-d\t\tprint each command as it's executed\n");
+  fprintf(stderr,"\t-h\t\tprint this message\n");
+}
+
+static bool
+parse_number(const char * s,uint64_t * value)
+{
+  char * end = 0;
+  *value = strtoull(s,&end,0);
+  return end != s && *end == 0;
+}
+
+static inline uint32_t
+swap32(const uint32_t v)
+{
+  return (v >> 24) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+static bool
+load_words(const char * filename,const bool big_endian,std::vector< uint32_t > & words)
+{
+  FILE * f = fopen(filename,"rb");
+  if(f == 0) {
+    return false;
+  }
+
+  uint32_t word;
+  while(fread(&word,sizeof(word),1,f) == 1) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+    if(!big_endian) word = swap32(word);
+#else
+    if(big_endian) word = swap32(word);
+#endif
+    words.push_back(word);
+  }
+
+  fclose(f);
+  return true;
+}
+
+// Prints each command as it's executed:
+struct dump_visitor_t : public rsxfifo_visitor_t {
+  virtual void method(const rsxfifo_command_t & command,const uint32_t * args) {
+    if(command.count == 0) {
+      printf("%08x: %s\n",command.offset,rsxfifo_method_string(command.subchannel,command.method).c_str());
+      return;
+    }
+
+    for(uint32_t i = 0;i < command.count;++i) {
+      const uint32_t method = command.increment ? (command.method + (i * sizeof(uint32_t))) : command.method;
+      printf("%08x: %s = 0x%08x\n",
+	     command.offset + ((i + 1) * (uint32_t)sizeof(uint32_t)),
+	     rsxfifo_method_string(command.subchannel,method).c_str(),args[i]);
+    }
+  }
+
+  virtual void jump(const rsxfifo_command_t & command) {
+    printf("%08x: jump 0x%08x\n",command.offset,command.target);
+  }
+
+  virtual void call(const rsxfifo_command_t & command) {
+    printf("%08x: call 0x%08x\n",command.offset,command.target);
+  }
+
+  virtual void ret(const rsxfifo_command_t & command,const uint32_t target) {
+    printf("%08x: return 0x%08x\n",command.offset,target);
+  }
+};
+
+// Forwards commands to both the stats and (optionally) the dump:
+struct tee_visitor_t : public rsxfifo_visitor_t {
+  rsxfifo_visitor_t & a;
+  rsxfifo_visitor_t * b;
+
+  tee_visitor_t(rsxfifo_visitor_t & _a,rsxfifo_visitor_t * _b) : a(_a), b(_b) {}
+
+  virtual void method(const rsxfifo_command_t & command,const uint32_t * args) {
+    a.method(command,args);
+    if(b != 0) b -> method(command,args);
+  }
+
+  virtual void jump(const rsxfifo_command_t & command) {
+    a.jump(command);
+    if(b != 0) b -> jump(command);
+  }
+
+  virtual void call(const rsxfifo_command_t & command) {
+    a.call(command);
+    if(b != 0) b -> call(command);
+  }
+
+  virtual void ret(const rsxfifo_command_t & command,const uint32_t target) {
+    a.ret(command,target);
+    if(b != 0) b -> ret(command,target);
+  }
+};
+
+static bool
+compare_method_words(const std::pair< uint32_t, rsxfifo_stats_t::counts_t > & lhs,const std::pair< uint32_t, rsxfifo_stats_t::counts_t > & rhs)
+{
+  const uint64_t lhs_words = lhs.second.headers + lhs.second.args, rhs_words = rhs.second.headers + rhs.second.args;
+  return (lhs_words > rhs_words) || (lhs_words == rhs_words && lhs.first < rhs.first);
+}
+
+static void
+print_stats(const rsxfifo_stats_t & stats)
+{
+  printf("words:\t\t%llu\n",(unsigned long long)stats.words);
+  printf("headers:\t%llu\n",(unsigned long long)stats.headers);
+  printf("jumps:\t\t%llu\n",(unsigned long long)stats.jumps);
+  printf("calls:\t\t%llu\n",(unsigned long long)stats.calls);
+  printf("returns:\t%llu\n",(unsigned long long)stats.returns);
+  printf("draws:\t\t%llu\n",(unsigned long long)stats.draws);
+  printf("words per draw:\t%.2f\n",stats.words_per_draw());
+  printf("\n");
+
+  std::vector< std::pair< uint32_t, rsxfifo_stats_t::counts_t > > methods(stats.methods.begin(),stats.methods.end());
+  std::sort(methods.begin(),methods.end(),compare_method_words);
+
+  printf("%-48s %10s %10s %10s\n","method","headers","args","words");
+  for(size_t i = 0,n = methods.size();i < n;++i) {
+    const uint32_t key = methods[i].first;
+    const rsxfifo_stats_t::counts_t & counts = methods[i].second;
+
+    printf("%-48s %10llu %10llu %10llu\n",
+	   rsxfifo_method_string(key >> 13,key & 0x1ffc).c_str(),
+	   (unsigned long long)counts.headers,(unsigned long long)counts.args,(unsigned long long)(counts.headers + counts.args));
+  }
+}
+
+int
+main(int argc,char ** argv)
+{
+  uint64_t get = 0, put = 0, limit = 16 * 1024 * 1024;
+  bool get_set = false, put_set = false, big_endian = true, dump = false;
+
+  int c;
+  while((c = getopt(argc,argv,"g:p:n:ldh")) != -1) {
+    switch(c) {
+    case 'g':
+      if(!parse_number(optarg,&get)) {
+	fprintf(stderr,"%s: invalid offset: %s\n",argv[0],optarg);
+	return 1;
+      }
+      get_set = true;
+      break;
+    case 'p':
+      if(!parse_number(optarg,&put)) {
+	fprintf(stderr,"%s: invalid offset: %s\n",argv[0],optarg);
+	return 1;
+      }
+      put_set = true;
+      break;
+    case 'n':
+      if(!parse_number(optarg,&limit)) {
+	fprintf(stderr,"%s: invalid word count: %s\n",argv[0],optarg);
+	return 1;
+      }
+      break;
+    case 'l':
+      big_endian = false;
+      break;
+    case 'd':
+      dump = true;
+      break;
+    case 'h':
+      usage(argv[0]);
+      return 0;
+    default:
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  if(optind >= argc) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  rsxfifo_image_t image;
+
+  for(int i = optind;i < argc;++i) {
+    std::string filename = argv[i];
+    uint64_t offset = 0;
+
+    const std::string::size_type at = filename.rfind('@');
+    if(at != std::string::npos) {
+      if(!parse_number(filename.c_str() + at + 1,&offset) || (offset & 0x3) != 0) {
+	fprintf(stderr,"%s: invalid offset: %s\n",argv[0],argv[i]);
+	return 1;
+      }
+      filename.resize(at);
+    }
+
+    std::vector< uint32_t > words;
+    if(!load_words(filename.c_str(),big_endian,words)) {
+      fprintf(stderr,"%s: couldn't read %s\n",argv[0],filename.c_str());
+      return 1;
+    }
+
+    if(i == optind) {
+      if(!get_set) get = offset;
+      if(!put_set) put = offset + (words.size() * sizeof(uint32_t));
+    }
+
+    image.add((uint32_t)offset,words);
+  }
+
+  rsxfifo_stats_t stats;
+  dump_visitor_t dumper;
+  tee_visitor_t visitor(stats,dump ? &dumper : 0);
+
+  const rsxfifo_result_t result = rsxfifo_run(image,(uint32_t)get,(uint32_t)put,visitor,limit);
+
+  if(dump) {
+    printf("\n");
+  }
+  print_stats(stats);
+
+  if(result.status != RSXFIFO_OK) {
+    fprintf(stderr,"%s: stopped at 0x%08x after %llu words: %s\n",argv[0],result.offset,(unsigned long long)result.words,rsxfifo_status_string(result.status));
+    return 2;
+  }
+
+  return 0;
+}
@@ -0,0 +1,225 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// rsxfifo.cc - Decode and simulate captured RSX command streams on the host.
+
+#include "rsxfifo.h"
+#include "nv40.h"
+
+rsxfifo_command_t
+rsxfifo_decode(const uint32_t word,const uint32_t offset)
+{
+  rsxfifo_command_t command;
+
+  command.type = RSXFIFO_COMMAND_INVALID;
+  command.offset = offset;
+  command.subchannel = 0;
+  command.method = 0;
+  command.count = 0;
+  command.increment = true;
+  command.target = 0;
+
+  // Old-style jump, which is what gcm_jump_cmd emits:
+  if((word & 0xe0000003) == 0x20000000) {
+    command.type = RSXFIFO_COMMAND_JUMP;
+    command.target = word & 0x1ffffffc;
+  }
+  // New-style jump:
+  else if((word & 0x00000003) == 0x00000001) {
+    command.type = RSXFIFO_COMMAND_JUMP;
+    command.target = word & 0xfffffffc;
+  }
+  else if((word & 0x00000003) == 0x00000002) {
+    command.type = RSXFIFO_COMMAND_CALL;
+    command.target = word & 0xfffffffc;
+  }
+  else if((word & 0xffff0003) == 0x00020000) {
+    command.type = RSXFIFO_COMMAND_RETURN;
+  }
+  // Method headers - method | (count << 18) | (subchannel << 13), with bit 30 set for methods
+  // whose arguments all go to the same register:
+  else if((word & 0xa0030003) == 0) {
+    command.type = RSXFIFO_COMMAND_METHOD;
+    command.increment = (word & 0x40000000) == 0;
+    command.count = (word >> 18) & 0x7ff;
+    command.subchannel = (word >> 13) & 0x7;
+    command.method = word & 0x1ffc;
+  }
+
+  return command;
+}
+
+void
+rsxfifo_image_t::add(const uint32_t offset,const std::vector< uint32_t > & words)
+{
+  regions[offset] = words;
+}
+
+const uint32_t *
+rsxfifo_image_t::at(const uint32_t offset,uint32_t * available) const
+{
+  regions_type::const_iterator it = regions.upper_bound(offset);
+  if(it == regions.begin()) {
+    return 0;
+  }
+  --it;
+
+  const uint32_t index = (offset - it -> first) >> 2;
+  if(index >= it -> second.size()) {
+    return 0;
+  }
+
+  *available = it -> second.size() - index;
+  return &it -> second[index];
+}
+
+const char *
+rsxfifo_status_string(const rsxfifo_status status)
+{
+  switch(status) {
+  case RSXFIFO_OK:
+    return "ok";
+  case RSXFIFO_UNMAPPED:
+    return "fetched from an offset that wasn't captured";
+  case RSXFIFO_INVALID_COMMAND:
+    return "invalid command word";
+  case RSXFIFO_TRUNCATED:
+    return "method arguments run past the end of the captured region";
+  case RSXFIFO_NESTED_CALL:
+    return "call from within a call";
+  case RSXFIFO_UNMATCHED_RETURN:
+    return "return without a call";
+  case RSXFIFO_WORD_LIMIT:
+    return "word limit reached";
+  }
+  return "unknown";
+}
+
+rsxfifo_result_t
+rsxfifo_run(const rsxfifo_image_t & image,const uint32_t get,const uint32_t put,rsxfifo_visitor_t & visitor,const uint64_t limit)
+{
+  rsxfifo_result_t result;
+  result.status = RSXFIFO_OK;
+  result.offset = get;
+  result.words = 0;
+
+  bool in_call = false;
+  uint32_t return_offset = 0;
+
+  uint32_t & offset = result.offset;
+
+  while(offset != put) {
+    if(result.words >= limit) {
+      result.status = RSXFIFO_WORD_LIMIT;
+      break;
+    }
+
+    uint32_t available = 0;
+    const uint32_t * words = image.at(offset,&available);
+    if(words == 0) {
+      result.status = RSXFIFO_UNMAPPED;
+      break;
+    }
+
+    const rsxfifo_command_t command = rsxfifo_decode(*words,offset);
+
+    if(command.type == RSXFIFO_COMMAND_METHOD) {
+      if(command.count >= available) {
+	result.status = RSXFIFO_TRUNCATED;
+	break;
+      }
+
+      visitor.method(command,words + 1);
+      result.words += command.count + 1;
+      offset += (command.count + 1) * sizeof(uint32_t);
+    }
+    else if(command.type == RSXFIFO_COMMAND_JUMP) {
+      visitor.jump(command);
+      result.words += 1;
+      offset = command.target;
+    }
+    else if(command.type == RSXFIFO_COMMAND_CALL) {
+      if(in_call) {
+	result.status = RSXFIFO_NESTED_CALL;
+	break;
+      }
+
+      visitor.call(command);
+      result.words += 1;
+      in_call = true;
+      return_offset = offset + sizeof(uint32_t);
+      offset = command.target;
+    }
+    else if(command.type == RSXFIFO_COMMAND_RETURN) {
+      if(!in_call) {
+	result.status = RSXFIFO_UNMATCHED_RETURN;
+	break;
+      }
+
+      visitor.ret(command,return_offset);
+      result.words += 1;
+      in_call = false;
+      offset = return_offset;
+    }
+    else {
+      result.status = RSXFIFO_INVALID_COMMAND;
+      break;
+    }
+  }
+
+  return result;
+}
+
+rsxfifo_stats_t::rsxfifo_stats_t()
+  : words(0), headers(0), jumps(0), calls(0), returns(0), draws(0)
+{
+}
+
+void
+rsxfifo_stats_t::method(const rsxfifo_command_t & command,const uint32_t * args)
+{
+  counts_t & counts = methods[(command.subchannel << 13) | command.method];
+  ++counts.headers;
+  counts.args += command.count;
+
+  ++headers;
+  words += command.count + 1;
+
+  if(command.subchannel != 0) return;
+
+  for(uint32_t i = 0;i < command.count;++i) {
+    const uint32_t method = command.increment ? (command.method + (i * sizeof(uint32_t))) : command.method;
+
+    if(method == NV30_3D_VERTEX_BEGIN_END && args[i] != NV30_3D_VERTEX_BEGIN_END_STOP) {
+      ++draws;
+    }
+  }
+}
+
+void
+rsxfifo_stats_t::jump(const rsxfifo_command_t & command)
+{
+  ++jumps;
+  ++words;
+}
+
+void
+rsxfifo_stats_t::call(const rsxfifo_command_t & command)
+{
+  ++calls;
+  ++words;
+}
+
+void
+rsxfifo_stats_t::ret(const rsxfifo_command_t & command,const uint32_t target)
+{
+  ++returns;
+  ++words;
+}
+
+double
+rsxfifo_stats_t::words_per_draw() const
+{
+  return (draws > 0) ? ((double)words / (double)draws) : 0.0;
+}
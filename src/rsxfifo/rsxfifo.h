@@ -0,0 +1,136 @@
+//-*-C++-*-
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// rsxfifo.h - Decode and simulate captured RSX command streams on the host.
+
+#ifndef rsxfifo_H
+#define rsxfifo_H
+
+#include <stdint.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Kinds of word that the RSX's command processor fetches:
+enum rsxfifo_command_type {
+  RSXFIFO_COMMAND_METHOD = 0,
+  RSXFIFO_COMMAND_JUMP,
+  RSXFIFO_COMMAND_CALL,
+  RSXFIFO_COMMAND_RETURN,
+  RSXFIFO_COMMAND_INVALID
+};
+
+struct rsxfifo_command_t {
+  rsxfifo_command_type type;
+
+  // RSX offset of the command word itself:
+  uint32_t offset;
+
+  // Method headers. If increment is true, then argument i is written to method + (i * 4), otherwise
+  // all of the arguments are written to method:
+  uint32_t subchannel, method, count;
+  bool increment;
+
+  // Destination of jumps and calls:
+  uint32_t target;
+};
+
+// Decode a single command word, that was read from RSX offset "offset". This is the inverse of the
+// encoding done by gcm_emit_method_at, gcm_emit_channel_method_at, gcm_jump_cmd, gcm_call_cmd and
+// gcm_return_cmd in src/library/gl_fifo.h:
+rsxfifo_command_t rsxfifo_decode(const uint32_t word,const uint32_t offset);
+
+// Look up the register that's written to by (subchannel,method), using the names in nv40.h.
+// Registers that belong to arrays also return their index (or indices, for two-dimensional arrays);
+// dimensions is 0 for plain registers. Returns false if the register isn't known.
+struct rsxfifo_method_name_t {
+  const char * name;
+  uint32_t dimensions, index0, index1;
+};
+
+bool rsxfifo_method_name(const uint32_t subchannel,const uint32_t method,rsxfifo_method_name_t * name);
+
+// Printable name of a register, like "NV30_3D_VTXFMT(3)". Unknown registers are formatted by
+// their address instead:
+std::string rsxfifo_method_string(const uint32_t subchannel,const uint32_t method);
+
+// Captured regions of RSX address space (the command buffer, command list segments, etc.). Words
+// are stored in host byte order:
+struct rsxfifo_image_t {
+  typedef std::map< uint32_t, std::vector< uint32_t > > regions_type;
+  regions_type regions;
+
+  void add(const uint32_t offset,const std::vector< uint32_t > & words);
+
+  // Returns the address of the word at offset, and the number of words that follow it in the same
+  // region (including itself). Returns 0 if offset isn't captured.
+  const uint32_t * at(const uint32_t offset,uint32_t * available) const;
+};
+
+// Receives the commands that are executed by rsxfifo_run:
+struct rsxfifo_visitor_t {
+  virtual ~rsxfifo_visitor_t() {}
+
+  // args points to command.count words:
+  virtual void method(const rsxfifo_command_t & command,const uint32_t * args) {}
+  virtual void jump(const rsxfifo_command_t & command) {}
+  virtual void call(const rsxfifo_command_t & command) {}
+  virtual void ret(const rsxfifo_command_t & command,const uint32_t target) {}
+};
+
+enum rsxfifo_status {
+  RSXFIFO_OK = 0,
+  RSXFIFO_UNMAPPED,
+  RSXFIFO_INVALID_COMMAND,
+  RSXFIFO_TRUNCATED,
+  RSXFIFO_NESTED_CALL,
+  RSXFIFO_UNMATCHED_RETURN,
+  RSXFIFO_WORD_LIMIT
+};
+
+const char * rsxfifo_status_string(const rsxfifo_status status);
+
+struct rsxfifo_result_t {
+  rsxfifo_status status;
+
+  // Where execution stopped, and how many words were fetched to get there:
+  uint32_t offset;
+  uint64_t words;
+};
+
+// Execute the commands between get and put the way the RSX's command processor would, following
+// jumps, calls and returns. Like the hardware, there is a single level of call. Stops after limit
+// words have been fetched, in case the stream loops.
+rsxfifo_result_t rsxfifo_run(const rsxfifo_image_t & image,const uint32_t get,const uint32_t put,rsxfifo_visitor_t & visitor,const uint64_t limit);
+
+// Accumulates per-method counts, and the number of words spent per draw:
+struct rsxfifo_stats_t : public rsxfifo_visitor_t {
+  struct counts_t {
+    uint64_t headers, args;
+
+    counts_t() : headers(0), args(0) {}
+  };
+
+  // Keyed by (subchannel << 13) | method of the first register written by each method header:
+  typedef std::map< uint32_t, counts_t > methods_type;
+  methods_type methods;
+
+  uint64_t words, headers, jumps, calls, returns;
+
+  // Number of NV30_3D_VERTEX_BEGIN_END writes that start a primitive:
+  uint64_t draws;
+
+  rsxfifo_stats_t();
+
+  virtual void method(const rsxfifo_command_t & command,const uint32_t * args);
+  virtual void jump(const rsxfifo_command_t & command);
+  virtual void call(const rsxfifo_command_t & command);
+  virtual void ret(const rsxfifo_command_t & command,const uint32_t target);
+
+  double words_per_draw() const;
+};
+
+#endif
@@ -0,0 +1,494 @@
+// RSXGL - Graphics library for the PS3 GPU.
+//
+// Copyright (c) 2011 Alexander Betts (alex.betts@gmail.com)
+//
+// rsxfifo_methods.cc - Names of the registers that can be written by method headers.
+
+#include "rsxfifo.h"
+#include "nv40.h"
+
+#include <stdio.h>
+
+namespace {
+
+  // Registers are keyed by (subchannel << 13) | method. Arrays of registers have up to two
+  // dimensions; the address of element (i0,i1) is base + (i0 * stride0) + (i1 * stride1):
+  struct method_entry_t {
+    uint32_t base, stride0, count0, stride1, count1, dimensions;
+    const char * name;
+  };
+
+#define RSXFIFO_METHOD(NAME) { NAME, 4, 1, 4, 1, 0, #NAME }
+#define RSXFIFO_ARRAY(NAME,LEN) { NAME(0), NAME(1) - NAME(0), LEN, 4, 1, 1, #NAME }
+#define RSXFIFO_ARRAY2(NAME,LEN0,LEN1) { NAME(0,0), NAME(1,0) - NAME(0,0), LEN0, NAME(0,1) - NAME(0,0), LEN1, 2, #NAME }
+
+  // Every register defined by nv40.h, in the order that they appear there. Array lengths that the
+  // header doesn't specify are taken from the array that encloses them, or else assumed to be 8:
+  const method_entry_t methods[] = {
+    RSXFIFO_METHOD(NV30_3D_DMA_NOTIFY),
+    RSXFIFO_METHOD(NV30_3D_DMA_TEXTURE0),
+    RSXFIFO_METHOD(NV30_3D_DMA_TEXTURE1),
+    RSXFIFO_METHOD(NV30_3D_DMA_COLOR1),
+    RSXFIFO_METHOD(NV30_3D_DMA_UNK190),
+    RSXFIFO_METHOD(NV30_3D_DMA_COLOR0),
+    RSXFIFO_METHOD(NV30_3D_DMA_ZETA),
+    RSXFIFO_METHOD(NV30_3D_DMA_VTXBUF0),
+    RSXFIFO_METHOD(NV30_3D_DMA_VTXBUF1),
+    RSXFIFO_METHOD(NV30_3D_DMA_FENCE),
+    RSXFIFO_METHOD(NV30_3D_DMA_QUERY),
+    RSXFIFO_METHOD(NV30_3D_DMA_UNK1AC),
+    RSXFIFO_METHOD(NV30_3D_DMA_UNK1B0),
+    RSXFIFO_METHOD(NV40_3D_DMA_COLOR2),
+    RSXFIFO_METHOD(NV40_3D_DMA_COLOR3),
+    RSXFIFO_METHOD(NV30_3D_RT_HORIZ),
+    RSXFIFO_METHOD(NV30_3D_RT_VERT),
+    RSXFIFO_METHOD(NV30_3D_RT_FORMAT),
+    RSXFIFO_METHOD(NV30_3D_COLOR0_PITCH),
+    RSXFIFO_METHOD(NV40_3D_COLOR0_PITCH),
+    RSXFIFO_METHOD(NV30_3D_COLOR0_OFFSET),
+    RSXFIFO_METHOD(NV30_3D_ZETA_OFFSET),
+    RSXFIFO_METHOD(NV30_3D_COLOR1_OFFSET),
+    RSXFIFO_METHOD(NV30_3D_COLOR1_PITCH),
+    RSXFIFO_METHOD(NV30_3D_RT_ENABLE),
+    RSXFIFO_METHOD(NV40_3D_RT_ENABLE_COLOR2),
+    RSXFIFO_METHOD(NV40_3D_RT_ENABLE_COLOR3),
+    RSXFIFO_METHOD(NV30_3D_RT_ENABLE_MRT),
+    RSXFIFO_METHOD(NV40_3D_ZETA_PITCH),
+    RSXFIFO_METHOD(NV30_3D_LMA_DEPTH_PITCH),
+    RSXFIFO_METHOD(NV30_3D_LMA_DEPTH_OFFSET),
+    RSXFIFO_METHOD(NV30_3D_TEX_UNITS_ENABLE),
+    RSXFIFO_ARRAY(NV30_3D_TEX_MATRIX_ENABLE,NV30_3D_TEX_MATRIX_ENABLE__LEN),
+    RSXFIFO_METHOD(NV40_3D_COLOR2_PITCH),
+    RSXFIFO_METHOD(NV40_3D_COLOR3_PITCH),
+    RSXFIFO_METHOD(NV40_3D_COLOR2_OFFSET),
+    RSXFIFO_METHOD(NV40_3D_COLOR3_OFFSET),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_TX_ORIGIN),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_CLIP_MODE),
+    RSXFIFO_ARRAY(NV30_3D_VIEWPORT_CLIP_HORIZ,NV30_3D_VIEWPORT_CLIP_HORIZ__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VIEWPORT_CLIP_VERT,NV30_3D_VIEWPORT_CLIP_VERT__LEN),
+    RSXFIFO_METHOD(NV30_3D_DITHER_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_ALPHA_FUNC_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_ALPHA_FUNC_FUNC),
+    RSXFIFO_METHOD(NV30_3D_ALPHA_FUNC_REF),
+    RSXFIFO_METHOD(NV30_3D_BLEND_FUNC_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_BLEND_FUNC_SRC),
+    RSXFIFO_METHOD(NV30_3D_BLEND_FUNC_DST),
+    RSXFIFO_METHOD(NV30_3D_BLEND_COLOR),
+    RSXFIFO_METHOD(NV30_3D_BLEND_EQUATION),
+    RSXFIFO_METHOD(NV40_3D_BLEND_EQUATION),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MASK),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_ENABLE,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_MASK,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_FUNC_FUNC,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_FUNC_REF,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_FUNC_MASK,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_OP_FAIL,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_OP_ZFAIL,NV30_3D_STENCIL__LEN),
+    RSXFIFO_ARRAY(NV30_3D_STENCIL_OP_ZPASS,NV30_3D_STENCIL__LEN),
+    RSXFIFO_METHOD(NV30_3D_SHADE_MODEL),
+    RSXFIFO_METHOD(NV30_3D_FOG_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_FOG_COLOR),
+    RSXFIFO_METHOD(NV40_3D_MRT_COLOR_MASK),
+    RSXFIFO_METHOD(NV30_3D_COLOR_LOGIC_OP_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_COLOR_LOGIC_OP_OP),
+    RSXFIFO_METHOD(NV30_3D_NORMALIZE_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL),
+    RSXFIFO_METHOD(NV30_3D_DEPTH_RANGE_NEAR),
+    RSXFIFO_METHOD(NV30_3D_DEPTH_RANGE_FAR),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_FRONT),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_FRONT_R),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_FRONT_G),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_FRONT_B),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_FRONT_A),
+    RSXFIFO_METHOD(NV40_3D_MIPMAP_ROUNDING),
+    RSXFIFO_METHOD(NV30_3D_LINE_WIDTH),
+    RSXFIFO_METHOD(NV30_3D_LINE_SMOOTH_ENABLE),
+    RSXFIFO_ARRAY2(NV30_3D_TEX_GEN_MODE,8,NV30_3D_TEX_GEN_MODE__LEN),
+    RSXFIFO_ARRAY(NV30_3D_MODELVIEW_MATRIX,NV30_3D_MODELVIEW_MATRIX__LEN),
+    RSXFIFO_ARRAY(NV30_3D_INVERSE_MODELVIEW_MATRIX,NV30_3D_INVERSE_MODELVIEW_MATRIX__LEN),
+    RSXFIFO_ARRAY(NV30_3D_PROJECTION_MATRIX,NV30_3D_PROJECTION_MATRIX__LEN),
+    RSXFIFO_ARRAY2(NV30_3D_TEX_MATRIX,8,NV30_3D_TEX_MATRIX__LEN),
+    RSXFIFO_METHOD(NV30_3D_SCISSOR_HORIZ),
+    RSXFIFO_METHOD(NV30_3D_SCISSOR_VERT),
+    RSXFIFO_METHOD(NV30_3D_FOG_COORD_DIST),
+    RSXFIFO_METHOD(NV30_3D_FOG_MODE),
+    RSXFIFO_METHOD(NV30_3D_FOG_EQUATION_CONSTANT),
+    RSXFIFO_METHOD(NV30_3D_FOG_EQUATION_LINEAR),
+    RSXFIFO_METHOD(NV30_3D_FOG_EQUATION_QUADRATIC),
+    RSXFIFO_METHOD(NV30_3D_FP_ACTIVE_PROGRAM),
+    RSXFIFO_METHOD(NV30_3D_RC_COLOR0),
+    RSXFIFO_METHOD(NV30_3D_RC_COLOR1),
+    RSXFIFO_METHOD(NV30_3D_RC_FINAL0),
+    RSXFIFO_METHOD(NV30_3D_RC_FINAL1),
+    RSXFIFO_METHOD(NV30_3D_RC_ENABLE),
+    RSXFIFO_ARRAY(NV30_3D_RC_IN_ALPHA,8),
+    RSXFIFO_ARRAY(NV30_3D_RC_IN_RGB,8),
+    RSXFIFO_ARRAY(NV30_3D_RC_CONSTANT_COLOR0,8),
+    RSXFIFO_ARRAY(NV30_3D_RC_CONSTANT_COLOR1,8),
+    RSXFIFO_ARRAY(NV30_3D_RC_OUT_ALPHA,8),
+    RSXFIFO_ARRAY(NV30_3D_RC_OUT_RGB,8),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_HORIZ),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_VERT),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_FRONT_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_FRONT_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION_R),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_FRONT_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION_G),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_FRONT_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION_B),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_TRANSLATE),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_TRANSLATE_X),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_TRANSLATE_Y),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_TRANSLATE_Z),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_TRANSLATE_W),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_SCALE),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_SCALE_X),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_SCALE_Y),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_SCALE_Z),
+    RSXFIFO_METHOD(NV30_3D_VIEWPORT_SCALE_W),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_OFFSET_POINT_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_OFFSET_LINE_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_OFFSET_FILL_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_DEPTH_FUNC),
+    RSXFIFO_METHOD(NV30_3D_DEPTH_WRITE_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_DEPTH_TEST_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_OFFSET_FACTOR),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_OFFSET_UNITS),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_3I_XY,NV30_3D_VTX_ATTR_3I_XY__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_3I_Z,NV30_3D_VTX_ATTR_3I_Z__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_FILTER_OPTIMIZATION,NV30_3D_TEX_FILTER_OPTIMIZATION__LEN),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_TRILINEAR_OFF),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_TRILINEAR_HIGH_QUALITY),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_TRILINEAR_PERFORMANCE),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_TRILINEAR_HIGH_PERFORMANCE),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_ANISO_SAMPLE_OFF),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_ANISO_SAMPLE_HIGH_QUALITY),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_ANISO_SAMPLE_QUALITY),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_ANISO_SAMPLE_PERFORMANCE),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_UNKNOWN_OFF),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_UNKNOWN_PARTIAL),
+    RSXFIFO_METHOD(NV40_3D_TEX_FILTER_OPTIMIZATION_UNKNOWN_FULL),
+    RSXFIFO_ARRAY(NV40_3D_UNK0B40,NV40_3D_UNK0B40__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VP_UPLOAD_INST,NV30_3D_VP_UPLOAD_INST__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_CLIP_PLANE,8),
+    RSXFIFO_ARRAY(NV30_3D_TEX_CLIP_PLANE_X,8),
+    RSXFIFO_ARRAY(NV30_3D_TEX_CLIP_PLANE_Y,8),
+    RSXFIFO_ARRAY(NV30_3D_TEX_CLIP_PLANE_Z,8),
+    RSXFIFO_ARRAY(NV30_3D_TEX_CLIP_PLANE_W,8),
+    RSXFIFO_METHOD(NV30_3D_LIGHT),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_AMBIENT,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_AMBIENT_R,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_AMBIENT_G,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_AMBIENT_B,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_DIFFUSE,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_DIFFUSE_R,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_DIFFUSE_G,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_DIFFUSE_B,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_SPECULAR,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_SPECULAR_R,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_SPECULAR_G,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_FRONT_SIDE_PRODUCT_SPECULAR_B,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_UNK24,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_HALF_VECTOR,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_HALF_VECTOR_X,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_HALF_VECTOR_Y,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_HALF_VECTOR_Z,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_DIRECTION,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_DIRECTION_X,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_DIRECTION_Y,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_DIRECTION_Z,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_CUTOFF_A,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_CUTOFF_B,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_CUTOFF_C,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_DIR,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_DIR_X,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_DIR_Y,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_DIR_Z,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_SPOT_CUTOFF_D,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_POSITION,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_POSITION_X,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_POSITION_Y,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_POSITION_Z,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_ATTENUATION,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_ATTENUATION_CONSTANT,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_ATTENUATION_LINEAR,8),
+    RSXFIFO_ARRAY(NV30_3D_LIGHT_ATTENUATION_QUADRATIC,8),
+    RSXFIFO_ARRAY(NV30_3D_FRONT_MATERIAL_SHININESS,NV30_3D_FRONT_MATERIAL_SHININESS__LEN),
+    RSXFIFO_METHOD(NV30_3D_ENABLED_LIGHTS),
+    RSXFIFO_METHOD(NV30_3D_VERTEX_TWO_SIDE_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_FP_REG_CONTROL),
+    RSXFIFO_METHOD(NV30_3D_FLATSHADE_FIRST),
+    RSXFIFO_METHOD(NV30_3D_EDGEFLAG),
+    RSXFIFO_METHOD(NV30_3D_VP_CLIP_PLANES_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_STIPPLE_ENABLE),
+    RSXFIFO_ARRAY(NV30_3D_POLYGON_STIPPLE_PATTERN,NV30_3D_POLYGON_STIPPLE_PATTERN__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_3F,NV30_3D_VTX_ATTR_3F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_3F_X,NV30_3D_VTX_ATTR_3F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_3F_Y,NV30_3D_VTX_ATTR_3F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_3F_Z,NV30_3D_VTX_ATTR_3F__LEN),
+    RSXFIFO_ARRAY2(NV30_3D_VP_CLIP_PLANE,8,NV30_3D_VP_CLIP_PLANE__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTXBUF,NV30_3D_VTXBUF__LEN),
+    RSXFIFO_METHOD(NV40_3D_VTX_CACHE_INVALIDATE),
+    RSXFIFO_ARRAY(NV30_3D_VTXFMT,NV30_3D_VTXFMT__LEN),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_BACK_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_BACK_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION_R),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_BACK_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION_G),
+    RSXFIFO_METHOD(NV30_3D_LIGHT_MODEL_BACK_SIDE_PRODUCT_AMBIENT_PLUS_EMISSION_B),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_BACK),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_BACK_R),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_BACK_G),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_BACK_B),
+    RSXFIFO_METHOD(NV30_3D_COLOR_MATERIAL_BACK_A),
+    RSXFIFO_METHOD(NV30_3D_QUERY_RESET),
+    RSXFIFO_METHOD(NV30_3D_QUERY_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_QUERY_GET),
+    RSXFIFO_METHOD(NV30_3D_VERTEX_BEGIN_END),
+    RSXFIFO_METHOD(NV30_3D_VB_ELEMENT_U16),
+    RSXFIFO_METHOD(NV30_3D_VB_ELEMENT_U32),
+    RSXFIFO_METHOD(NV30_3D_VB_VERTEX_BATCH),
+    RSXFIFO_METHOD(NV30_3D_VERTEX_DATA),
+    RSXFIFO_METHOD(NV30_3D_IDXBUF_OFFSET),
+    RSXFIFO_METHOD(NV30_3D_IDXBUF_FORMAT),
+    RSXFIFO_METHOD(NV30_3D_VB_INDEX_BATCH),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_MODE_FRONT),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_MODE_BACK),
+    RSXFIFO_METHOD(NV30_3D_CULL_FACE),
+    RSXFIFO_METHOD(NV30_3D_FRONT_FACE),
+    RSXFIFO_METHOD(NV30_3D_POLYGON_SMOOTH_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_CULL_FACE_ENABLE),
+    RSXFIFO_ARRAY(NV30_3D_TEX_PALETTE_OFFSET,NV30_3D_TEX_PALETTE_OFFSET__LEN),
+    RSXFIFO_ARRAY(NV40_3D_TEX_SIZE1,NV40_3D_TEX_SIZE1__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_2F,NV30_3D_VTX_ATTR_2F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_2F_X,NV30_3D_VTX_ATTR_2F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_2F_Y,NV30_3D_VTX_ATTR_2F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_2I,NV30_3D_VTX_ATTR_2I__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4UB,NV30_3D_VTX_ATTR_4UB__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4I,NV30_3D_VTX_ATTR_4I__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4I_XY,NV30_3D_VTX_ATTR_4I__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4I_ZW,NV30_3D_VTX_ATTR_4I__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_OFFSET,NV30_3D_TEX_OFFSET__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_FORMAT,NV30_3D_TEX_FORMAT__LEN),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_L8),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_A1R5G5B5),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_A4R4G4B4),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_R5G6B5),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_A8R8G8B8),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_DXT1),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_DXT3),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_DXT5),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_A8L8),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_Z24),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_Z16),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_A16),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_A16L16),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_HILO8),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_RGBA16F),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_FORMAT_RGBA32F),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_LINEAR),
+    RSXFIFO_METHOD(NV40_3D_TEX_FORMAT_RECT),
+    RSXFIFO_METHOD(NV30_3D_TEX_FORMAT_MIPMAP),
+    RSXFIFO_ARRAY(NV30_3D_TEX_WRAP,NV30_3D_TEX_WRAP__LEN),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_S_MIRROR_CLAMP),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_ANISO_MIP_FILTER_OPTIMIZATION_OFF),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_ANISO_MIP_FILTER_OPTIMIZATION_QUALITY),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_ANISO_MIP_FILTER_OPTIMIZATION_PERFORMANCE),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_ANISO_MIP_FILTER_OPTIMIZATION_HIGH_PERFORMANCE),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_T_REPEAT),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_T_MIRRORED_REPEAT),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_T_CLAMP_TO_EDGE),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_T_CLAMP_TO_BORDER),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_T_CLAMP),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_T_MIRROR_CLAMP_TO_EDGE),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_T_MIRROR_CLAMP_TO_BORDER),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_T_MIRROR_CLAMP),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_EXPAND_NORMAL),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_R_REPEAT),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_R_MIRRORED_REPEAT),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_R_CLAMP_TO_EDGE),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_R_CLAMP_TO_BORDER),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_R_CLAMP),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_R_MIRROR_CLAMP_TO_EDGE),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_R_MIRROR_CLAMP_TO_BORDER),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_R_MIRROR_CLAMP),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_GAMMA_DECREASE_FILTER_NONE),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_GAMMA_DECREASE_FILTER_RED),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_GAMMA_DECREASE_FILTER_GREEN),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_GAMMA_DECREASE_FILTER_BLUE),
+    RSXFIFO_METHOD(NV40_3D_TEX_WRAP_GAMMA_DECREASE_FILTER_ALL),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_NEVER),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_GREATER),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_EQUAL),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_GEQUAL),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_LESS),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_NOTEQUAL),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_LEQUAL),
+    RSXFIFO_METHOD(NV30_3D_TEX_WRAP_RCOMP_ALWAYS),
+    RSXFIFO_ARRAY(NV30_3D_TEX_ENABLE,NV30_3D_TEX_ENABLE__LEN),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_NONE),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_2X),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_4X),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_6X),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_8X),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_10X),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_12X),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ANISO_16X),
+    RSXFIFO_METHOD(NV30_3D_TEX_ENABLE_ENABLE),
+    RSXFIFO_METHOD(NV40_3D_TEX_ENABLE_ENABLE),
+    RSXFIFO_ARRAY(NV30_3D_TEX_SWIZZLE,NV30_3D_TEX_SWIZZLE__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_FILTER,NV30_3D_TEX_FILTER__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_NPOT_SIZE,NV30_3D_TEX_NPOT_SIZE__LEN),
+    RSXFIFO_ARRAY(NV30_3D_TEX_BORDER_COLOR,NV30_3D_TEX_BORDER_COLOR__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4F,NV30_3D_VTX_ATTR_4F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4F_X,NV30_3D_VTX_ATTR_4F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4F_Y,NV30_3D_VTX_ATTR_4F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4F_Z,NV30_3D_VTX_ATTR_4F__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_4F_W,NV30_3D_VTX_ATTR_4F__LEN),
+    RSXFIFO_METHOD(NV30_3D_FP_CONTROL),
+    RSXFIFO_METHOD(NV40_3D_FP_CONTROL_KIL),
+    RSXFIFO_METHOD(NV30_3D_DEPTH_CONTROL),
+    RSXFIFO_METHOD(NV30_3D_MULTISAMPLE_CONTROL),
+    RSXFIFO_METHOD(NV30_3D_COORD_CONVENTIONS),
+    RSXFIFO_METHOD(NV30_3D_CLEAR_DEPTH_VALUE),
+    RSXFIFO_METHOD(NV30_3D_CLEAR_COLOR_VALUE),
+    RSXFIFO_METHOD(NV30_3D_CLEAR_BUFFERS),
+    RSXFIFO_METHOD(NV30_3D_DO_VERTICES),
+    RSXFIFO_METHOD(NV30_3D_LINE_STIPPLE_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_LINE_STIPPLE_PATTERN),
+    RSXFIFO_ARRAY(NV30_3D_BACK_MATERIAL_SHININESS,NV30_3D_BACK_MATERIAL_SHININESS__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VTX_ATTR_1F,NV30_3D_VTX_ATTR_1F__LEN),
+    RSXFIFO_METHOD(NV30_3D_ENGINE),
+    RSXFIFO_METHOD(NV30_3D_VP_UPLOAD_FROM_ID),
+    RSXFIFO_METHOD(NV30_3D_VP_START_FROM_ID),
+    RSXFIFO_ARRAY(NV30_3D_POINT_PARAMETERS,NV30_3D_POINT_PARAMETERS__LEN),
+    RSXFIFO_METHOD(NV30_3D_POINT_SIZE),
+    RSXFIFO_METHOD(NV30_3D_POINT_PARAMETERS_ENABLE),
+    RSXFIFO_METHOD(NV30_3D_POINT_SPRITE),
+    RSXFIFO_METHOD(NV30_3D_VP_UPLOAD_CONST_ID),
+    RSXFIFO_ARRAY(NV30_3D_VP_UPLOAD_CONST,NV30_3D_VP_UPLOAD_CONST__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VP_UPLOAD_CONST_X,NV30_3D_VP_UPLOAD_CONST__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VP_UPLOAD_CONST_Y,NV30_3D_VP_UPLOAD_CONST__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VP_UPLOAD_CONST_Z,NV30_3D_VP_UPLOAD_CONST__LEN),
+    RSXFIFO_ARRAY(NV30_3D_VP_UPLOAD_CONST_W,NV30_3D_VP_UPLOAD_CONST__LEN),
+    RSXFIFO_ARRAY(NV30_3D_UNK1F80,NV30_3D_UNK1F80__LEN),
+    RSXFIFO_METHOD(NV40_3D_TEX_CACHE_CTL),
+    RSXFIFO_METHOD(NV40_3D_VP_ATTRIB_EN),
+    RSXFIFO_METHOD(NV40_3D_VP_RESULT_EN),
+    RSXFIFO_METHOD(NV3062TCL_SET_CONTEXT_DMA_IMAGE_DEST),
+    RSXFIFO_METHOD(NV3062TCL_SET_COLOR_FORMAT),
+    RSXFIFO_METHOD(NV3062TCL_SET_OFFSET_DEST),
+    RSXFIFO_METHOD(NV308ATCL_POINT),
+    RSXFIFO_METHOD(NV308ATCL_COLOR),
+    RSXFIFO_METHOD(NV40TCL_SEMAPHORE_OFFSET),
+    RSXFIFO_METHOD(NV40TCL_SEMAPHORE_BACKENDWRITE_RELEASE),
+    RSXFIFO_METHOD(NV406ETCL_SEMAPHORE_OFFSET),
+    RSXFIFO_METHOD(NV406ETCL_SEMAPHORE_ACQUIRE),
+    RSXFIFO_METHOD(NV406ETCL_SEMAPHORE_RELEASE),
+
+    // Registers that RSXGL writes to, but which aren't named by nv40.h:
+    { 0x00000050, 4, 1, 4, 1, 0, "NV406E_SET_REFERENCE" },
+    { 0x00000100, 4, 1, 4, 1, 0, "NV4097_NO_OPERATION" },
+    { 0x00000110, 4, 1, 4, 1, 0, "NV4097_WAIT_FOR_IDLE" },
+    { 0x00001710, 4, 1, 4, 1, 0, "NV4097_INVALIDATE_VERTEX_CACHE_FILE" },
+    { 0x0000173c, 4, 1, 4, 1, 0, "NV4097_SET_VERTEX_DATA_BASE_INDEX" },
+    { 0x00001dac, 4, 1, 4, 1, 0, "NV4097_SET_RESTART_INDEX_ENABLE" },
+    { 0x00001db0, 4, 1, 4, 1, 0, "NV4097_SET_RESTART_INDEX" },
+
+    // NV_MEMORY_TO_MEMORY_FORMAT, bound to subchannel 1:
+    { 0x00002184, 4, 1, 4, 1, 0, "NV0039_SET_CONTEXT_DMA_BUFFER_IN" },
+    { 0x00002188, 4, 1, 4, 1, 0, "NV0039_SET_CONTEXT_DMA_BUFFER_OUT" },
+    { 0x0000230c, 4, 1, 4, 1, 0, "NV0039_OFFSET_IN" },
+    { 0x00002310, 4, 1, 4, 1, 0, "NV0039_OFFSET_OUT" },
+    { 0x00002314, 4, 1, 4, 1, 0, "NV0039_PITCH_IN" },
+    { 0x00002318, 4, 1, 4, 1, 0, "NV0039_PITCH_OUT" },
+    { 0x0000231c, 4, 1, 4, 1, 0, "NV0039_LINE_LENGTH_IN" },
+    { 0x00002320, 4, 1, 4, 1, 0, "NV0039_LINE_COUNT" },
+    { 0x00002324, 4, 1, 4, 1, 0, "NV0039_FORMAT" },
+    { 0x00002328, 4, 1, 4, 1, 0, "NV0039_BUFFER_NOTIFY" }
+  };
+
+#undef RSXFIFO_METHOD
+#undef RSXFIFO_ARRAY
+#undef RSXFIFO_ARRAY2
+
+  const size_t nmethods = sizeof(methods) / sizeof(method_entry_t);
+
+  inline bool
+  method_entry_match(const method_entry_t & entry,const uint32_t key,uint32_t * index0,uint32_t * index1)
+  {
+    if(key < entry.base) return false;
+
+    const uint32_t offset = key - entry.base;
+    const uint32_t i0 = offset / entry.stride0;
+    if(i0 >= entry.count0) return false;
+
+    const uint32_t remainder = offset - (i0 * entry.stride0);
+    const uint32_t i1 = remainder / entry.stride1;
+    if((remainder % entry.stride1) != 0 || i1 >= entry.count1) return false;
+
+    *index0 = i0;
+    *index1 = i1;
+    return true;
+  }
+
+  inline bool
+  method_entry_is_nv40(const method_entry_t & entry)
+  {
+    return entry.name[2] == '4';
+  }
+
+}
+
+bool
+rsxfifo_method_name(const uint32_t subchannel,const uint32_t method,rsxfifo_method_name_t * name)
+{
+  const uint32_t key = (subchannel << 13) | method;
+
+  // Several names can alias the same register. Later (more specific) names are preferred, except
+  // that NV40 names are preferred over NV30 ones:
+  const method_entry_t * match = 0;
+  uint32_t index0 = 0, index1 = 0;
+
+  for(size_t i = 0;i < nmethods;++i) {
+    const method_entry_t & entry = methods[i];
+    uint32_t i0 = 0, i1 = 0;
+
+    if(!method_entry_match(entry,key,&i0,&i1)) continue;
+    if(match != 0 && method_entry_is_nv40(*match) && !method_entry_is_nv40(entry)) continue;
+
+    match = &entry;
+    index0 = i0;
+    index1 = i1;
+  }
+
+  if(match == 0) {
+    return false;
+  }
+
+  name -> name = match -> name;
+  name -> dimensions = match -> dimensions;
+  name -> index0 = index0;
+  name -> index1 = index1;
+  return true;
+}
+
+std::string
+rsxfifo_method_string(const uint32_t subchannel,const uint32_t method)
+{
+  rsxfifo_method_name_t name;
+  char buffer[256];
+
+  if(rsxfifo_method_name(subchannel,method,&name)) {
+    if(name.dimensions == 0) {
+      return name.name;
+    }
+    else if(name.dimensions == 1) {
+      snprintf(buffer,sizeof(buffer),"%s(%u)",name.name,name.index0);
+    }
+    else {
+      snprintf(buffer,sizeof(buffer),"%s(%u,%u)",name.name,name.index0,name.index1);
+    }
+  }
+  else {
+    snprintf(buffer,sizeof(buffer),"[%u]0x%04x",subchannel,method);
+  }
+
+  return buffer;
+}